@@ -0,0 +1,191 @@
+// adc_calibration.cpp
+#include "adc_calibration.h"
+#include <string.h>
+
+#if defined(ESP_PLATFORM)
+#include <esp_idf_version.h>
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#define ADC_CAL_IDF5            1
+#include <esp_adc/adc_cali.h>
+#include <esp_adc/adc_cali_scheme.h>
+#else
+#define ADC_CAL_IDF5            0
+#include <esp_adc_cal.h>
+#endif
+#define ADC_CAL_EFUSE           1
+#else
+#define ADC_CAL_EFUSE           0
+#endif
+
+AdcCalibrationClass::AdcCalibrationClass()
+    :   _base(nullptr),
+        _base_ctx(nullptr),
+        _adc_ref(3.3f),
+        _source("linear"),
+        _count(0)
+{
+    memset(_points, 0, sizeof(_points));
+    memset(_lut, 0, sizeof(_lut));
+}
+
+// ----------------- eFuse base curve -----------------
+#if ADC_CAL_EFUSE
+#if ADC_CAL_IDF5
+static adc_cali_handle_t s_cali = nullptr;
+
+static uint16_t efuseMV(uint16_t raw, void* ctx)
+{
+    (void)ctx;
+    int mv = 0;
+    adc_cali_raw_to_voltage(s_cali, raw, &mv);
+    return (uint16_t)(mv < 0 ? 0 : mv);
+}
+#else
+static esp_adc_cal_characteristics_t s_chars;
+
+static uint16_t efuseMV(uint16_t raw, void* ctx)
+{
+    (void)ctx;
+    return (uint16_t)esp_adc_cal_raw_to_voltage(raw, &s_chars);
+}
+#endif
+#endif
+
+bool AdcCalibrationClass::begin(uint8_t pin)
+{
+#if ADC_CAL_EFUSE
+    // S3: GPIO1..10 are ADC1, GPIO11..20 ADC2
+    const adc_unit_t unit = (pin >= 11 && pin <= 20) ? ADC_UNIT_2 : ADC_UNIT_1;
+#if ADC_CAL_IDF5
+    if (s_cali)
+    {
+        adc_cali_delete_scheme_curve_fitting(s_cali);
+        s_cali = nullptr;
+    }
+    adc_cali_curve_fitting_config_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.unit_id = unit;
+    cfg.atten = ADC_ATTEN_DB_11;
+    cfg.bitwidth = ADC_BITWIDTH_12;
+    if (adc_cali_create_scheme_curve_fitting(&cfg, &s_cali) == ESP_OK)
+    {
+        setBASE(efuseMV, nullptr);
+        _source = "eFuse curve";
+        return true;
+    }
+#else
+    esp_adc_cal_value_t v = esp_adc_cal_characterize(unit, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, 1100, &s_chars);
+    if (v == ESP_ADC_CAL_VAL_EFUSE_TP_FIT || v == ESP_ADC_CAL_VAL_EFUSE_TP || v == ESP_ADC_CAL_VAL_EFUSE_VREF)
+    {
+        setBASE(efuseMV, nullptr);
+        _source = (v == ESP_ADC_CAL_VAL_EFUSE_TP_FIT) ? "eFuse curve" : "eFuse two-point";
+        return true;
+    }
+#endif
+#else
+    (void)pin;
+#endif
+    _base = nullptr;
+    _source = "linear";
+    return false;
+}
+
+void AdcCalibrationClass::setBASE(ADC_CAL_BASE fn, void* ctx)
+{
+    _base = fn;
+    _base_ctx = ctx;
+    _source = "custom";
+}
+
+uint16_t AdcCalibrationClass::baseMV(uint16_t raw) const
+{
+    if (_base)
+    {
+        return _base(raw, _base_ctx);
+    }
+    float mv = raw * (_adc_ref * 1000.0f) / (ADC_CAL_LUT_SIZE - 1);
+    return (uint16_t)(mv + 0.5f);
+}
+
+// ----------------- user points -----------------
+uint8_t AdcCalibrationClass::addPOINT(uint16_t raw, uint16_t pin_mv)
+{
+    if (raw >= ADC_CAL_LUT_SIZE)
+    {
+        return _count;
+    }
+    // replace the nearest point when close or full, otherwise insert in order
+    int8_t near = -1;
+    uint16_t best = 0xFFFF;
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        uint16_t d = _points[i].raw > raw ? _points[i].raw - raw : raw - _points[i].raw;
+        if (d < best)
+        {
+            best = d;
+            near = i;
+        }
+    }
+    if (near >= 0 && (best <= ADC_CAL_MERGE_RAW || _count == ADC_CAL_MAX_POINTS))
+    {
+        for (uint8_t i = near; i + 1 < _count; i++) _points[i] = _points[i + 1];
+        _count--;
+    }
+    uint8_t at = _count;
+    while (at > 0 && _points[at - 1].raw > raw)
+    {
+        _points[at] = _points[at - 1];
+        at--;
+    }
+    _points[at].raw = raw;
+    _points[at].mv = pin_mv;
+    _count++;
+    return _count;
+}
+
+void AdcCalibrationClass::setPOINTS(const ADC_CAL_POINT* p, uint8_t n)
+{
+    _count = 0;
+    for (uint8_t i = 0; i < n && i < ADC_CAL_MAX_POINTS; i++)
+    {
+        if (p[i].raw && p[i].mv) addPOINT(p[i].raw, p[i].mv);
+    }
+}
+
+// ----------------- table -----------------
+float AdcCalibrationClass::_gain(uint16_t raw, const float* ratios) const
+{
+    if (!_count)
+    {
+        return 1.0f;
+    }
+    if (raw <= _points[0].raw)
+    {
+        return ratios[0];
+    }
+    for (uint8_t i = 1; i < _count; i++)
+    {
+        if (raw <= _points[i].raw)
+        {
+            const float f = (float)(raw - _points[i - 1].raw) / (float)(_points[i].raw - _points[i - 1].raw);
+            return ratios[i - 1] + f * (ratios[i] - ratios[i - 1]);
+        }
+    }
+    return ratios[_count - 1];
+}
+
+void AdcCalibrationClass::build(float divider, float scale)
+{
+    float ratios[ADC_CAL_MAX_POINTS];
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        uint16_t b = baseMV(_points[i].raw);
+        ratios[i] = b ? (float)_points[i].mv / b : 1.0f;
+    }
+    const float k = divider * scale;
+    for (uint16_t raw = 0; raw < ADC_CAL_LUT_SIZE; raw++)
+    {
+        float mv = baseMV(raw) * _gain(raw, ratios) * k + 0.5f;
+        _lut[raw] = mv >= 65535.0f ? 65535 : (mv <= 0.0f ? 0 : (uint16_t)mv);
+    }
+}
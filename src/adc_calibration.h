@@ -0,0 +1,52 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Raw ADC count -> battery millivolts through one precomputed table.
+//
+// The base curve is the chip's own characterisation: the eFuse curve-fitting data of the S3
+// at 11 dB (esp_adc_cal on IDF 4.4, adc_cali on IDF 5), or a linear raw / 4095 * adc_ref when
+// the eFuse holds nothing. User points (raw count, true pin mV, from a multimeter reading of
+// the battery) correct the base by a gain that is interpolated between points and held flat
+// beyond them; one point is the old single calibration factor. build() folds base, correction,
+// divider and scale into ADC_CAL_LUT_SIZE uint16_t, so a conversion is one indexed load.
+
+const uint16_t ADC_CAL_LUT_SIZE     = 4096;     // 12-bit raw
+const uint8_t  ADC_CAL_MAX_POINTS   = 6;
+const uint16_t ADC_CAL_MERGE_RAW    = 48;       // a new point this close to an old one replaces it
+
+typedef struct ADC_CAL_POINT {
+    uint16_t raw;
+    uint16_t mv;                                // true voltage at the ADC pin
+} ADC_CAL_POINT;
+
+typedef uint16_t (*ADC_CAL_BASE)(uint16_t raw, void* ctx);     // uncorrected pin mV
+
+class AdcCalibrationClass {
+public:
+    AdcCalibrationClass();
+    bool begin(uint8_t pin);                    // eFuse characterisation for the pin's ADC unit
+    void setBASE(ADC_CAL_BASE fn, void* ctx);   // replaces the eFuse curve (host tools)
+    void setLinearREF(float adc_ref_v) { _adc_ref = adc_ref_v; }
+    const char* source() const { return _source; }
+
+    uint8_t addPOINT(uint16_t raw, uint16_t pin_mv);    // returns the point count
+    void    setPOINTS(const ADC_CAL_POINT* p, uint8_t n);
+    void    clearPOINTS() { _count = 0; }
+    uint8_t pointCOUNT() const { return _count; }
+    const ADC_CAL_POINT& point(uint8_t i) const { return _points[i]; }
+
+    uint16_t baseMV(uint16_t raw) const;
+    void build(float divider, float scale);     // regenerates the table
+    inline uint16_t batteryMV(uint16_t raw) const { return _lut[raw < ADC_CAL_LUT_SIZE ? raw : ADC_CAL_LUT_SIZE - 1]; }
+private:
+    ADC_CAL_BASE  _base;
+    void*         _base_ctx;
+    float         _adc_ref;
+    const char*   _source;
+    ADC_CAL_POINT _points[ADC_CAL_MAX_POINTS];  // sorted by raw
+    uint8_t       _count;
+    uint16_t      _lut[ADC_CAL_LUT_SIZE];
+
+    float _gain(uint16_t raw, const float* ratios) const;
+};
@@ -0,0 +1,165 @@
+// adc_dma_source.cpp
+#include "adc_dma_source.h"
+
+AdcDmaSOURCE::AdcDmaSOURCE()
+    :   _running(false),
+        _channel(0)
+#if ADC_DMA_IDF5
+        , _handle(NULL)
+#endif
+{
+}
+
+#if ADC_DMA_SUPPORTED
+
+bool AdcDmaSOURCE::start(uint8_t pin, uint32_t sample_rate_hz)
+{
+    if (_running)
+    {
+        stop();
+    }
+    // ADC1 is GPIO1..GPIO10 on the S3; ADC2 continuous reads collide with Wi-Fi/BT
+    int8_t ch = digitalPinToAnalogChannel(pin);
+    if (ch < 0 || ch >= SOC_ADC_CHANNEL_NUM(0))
+    {
+        Serial.println("BATTERY::DMA::pin is not an ADC1 channel");
+        return false;
+    }
+    if (sample_rate_hz < SOC_ADC_SAMPLE_FREQ_THRES_LOW)  sample_rate_hz = SOC_ADC_SAMPLE_FREQ_THRES_LOW;
+    if (sample_rate_hz > SOC_ADC_SAMPLE_FREQ_THRES_HIGH) sample_rate_hz = SOC_ADC_SAMPLE_FREQ_THRES_HIGH;
+    _channel = (uint8_t)ch;
+
+    adc_digi_pattern_config_t pattern;
+    memset(&pattern, 0, sizeof(pattern));
+    pattern.atten = ADC_ATTEN_DB_11;
+    pattern.channel = _channel;
+    pattern.unit = 0;                       // ADC1
+    pattern.bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+
+#if ADC_DMA_IDF5
+    adc_continuous_handle_cfg_t handle_cfg;
+    memset(&handle_cfg, 0, sizeof(handle_cfg));
+    handle_cfg.max_store_buf_size = ADC_DMA_STORE_BYTES;
+    handle_cfg.conv_frame_size = ADC_DMA_FRAME_BYTES;
+    if (adc_continuous_new_handle(&handle_cfg, &_handle) != ESP_OK)
+    {
+        Serial.println("BATTERY::DMA::driver install failed");
+        return false;
+    }
+    adc_continuous_config_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.pattern_num = 1;
+    cfg.adc_pattern = &pattern;
+    cfg.sample_freq_hz = sample_rate_hz;
+    cfg.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    cfg.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+    if (adc_continuous_config(_handle, &cfg) != ESP_OK || adc_continuous_start(_handle) != ESP_OK)
+    {
+        adc_continuous_deinit(_handle);
+        _handle = NULL;
+        Serial.println("BATTERY::DMA::start failed");
+        return false;
+    }
+#else
+    adc_digi_init_config_t init_cfg;
+    memset(&init_cfg, 0, sizeof(init_cfg));
+    init_cfg.max_store_buf_size = ADC_DMA_STORE_BYTES;
+    init_cfg.conv_num_each_intr = ADC_DMA_FRAME_BYTES;
+    init_cfg.adc1_chan_mask = BIT(_channel);
+    init_cfg.adc2_chan_mask = 0;
+    if (adc_digi_initialize(&init_cfg) != ESP_OK)
+    {
+        Serial.println("BATTERY::DMA::driver install failed");
+        return false;
+    }
+    adc_digi_configuration_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.conv_limit_en = false;
+    cfg.pattern_num = 1;
+    cfg.adc_pattern = &pattern;
+    cfg.sample_freq_hz = sample_rate_hz;
+    cfg.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    cfg.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+    if (adc_digi_controller_configure(&cfg) != ESP_OK || adc_digi_start() != ESP_OK)
+    {
+        adc_digi_deinitialize();
+        Serial.println("BATTERY::DMA::start failed");
+        return false;
+    }
+#endif
+    _running = true;
+    return true;
+}
+
+void AdcDmaSOURCE::stop()
+{
+    if (!_running)
+    {
+        return;
+    }
+#if ADC_DMA_IDF5
+    adc_continuous_stop(_handle);
+    adc_continuous_deinit(_handle);
+    _handle = NULL;
+#else
+    adc_digi_stop();
+    adc_digi_deinitialize();
+#endif
+    _running = false;
+}
+
+size_t AdcDmaSOURCE::read(uint16_t* out, size_t max, uint32_t timeout_ms)
+{
+    size_t n = 0;
+    const uint32_t t0 = millis();
+    while (_running && n < max)
+    {
+        uint32_t elapsed = millis() - t0;
+        if (elapsed >= timeout_ms)
+        {
+            break;
+        }
+        uint32_t got = 0;
+#if ADC_DMA_IDF5
+        esp_err_t r = adc_continuous_read(_handle, _frame, sizeof(_frame), &got, timeout_ms - elapsed);
+#else
+        esp_err_t r = adc_digi_read_bytes(_frame, sizeof(_frame), &got, timeout_ms - elapsed);
+#endif
+        if (r != ESP_OK)
+        {
+            break;
+        }
+        for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= got && n < max; i += SOC_ADC_DIGI_RESULT_BYTES)
+        {
+            const adc_digi_output_data_t* d = (const adc_digi_output_data_t*)&_frame[i];
+            if (d->type2.unit == 0 && d->type2.channel == _channel)
+            {
+                out[n++] = (uint16_t)d->type2.data;
+            }
+        }
+    }
+    return n;
+}
+
+#else   // no continuous driver on this target: callers fall back to one-shot sampling
+
+bool AdcDmaSOURCE::start(uint8_t pin, uint32_t sample_rate_hz)
+{
+    (void)pin;
+    (void)sample_rate_hz;
+    return false;
+}
+
+void AdcDmaSOURCE::stop()
+{
+}
+
+size_t AdcDmaSOURCE::read(uint16_t* out, size_t max, uint32_t timeout_ms)
+{
+    (void)out;
+    (void)max;
+    (void)timeout_ms;
+    return 0;
+}
+
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+#include <Arduino.h>
+#include "adc_source.h"
+
+// ESP32-S3 continuous (DMA) ADC source, ADC1 pins only.
+//
+// The driver is installed on start() and removed on stop(), so between battery readings the
+// converter and its DMA descriptors are gone and the task sleeps in vTaskDelayUntil. While
+// read() waits for a frame the task is blocked on the driver's semaphore, not polling.
+// IDF 5.x uses esp_adc/adc_continuous.h, IDF 4.4 the older adc_digi_* calls in driver/adc.h.
+
+#define ADC_DMA_FRAME_BYTES     256
+#define ADC_DMA_STORE_BYTES     1024
+
+#if defined(ESP_PLATFORM) && defined(CONFIG_IDF_TARGET_ESP32S3)
+#define ADC_DMA_SUPPORTED       1
+#else
+#define ADC_DMA_SUPPORTED       0
+#endif
+
+#if ADC_DMA_SUPPORTED
+#include <esp_idf_version.h>
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#define ADC_DMA_IDF5            1
+#include <esp_adc/adc_continuous.h>
+#else
+#define ADC_DMA_IDF5            0
+#include <driver/adc.h>
+#endif
+#else
+#define ADC_DMA_IDF5            0
+#endif
+
+class AdcDmaSOURCE : public AdcSourceClass {
+public:
+    AdcDmaSOURCE();
+    bool   start(uint8_t pin, uint32_t sample_rate_hz);
+    void   stop();
+    size_t read(uint16_t* out, size_t max, uint32_t timeout_ms);
+private:
+    bool    _running;
+    uint8_t _channel;
+    uint8_t _frame[ADC_DMA_FRAME_BYTES];
+#if ADC_DMA_IDF5
+    adc_continuous_handle_t _handle;
+#endif
+};
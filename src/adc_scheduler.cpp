@@ -0,0 +1,155 @@
+// adc_scheduler.cpp
+#include "adc_scheduler.h"
+
+AdcSchedulerClass::AdcSchedulerClass()
+    :   _count(0),
+        _next(0),
+        _read(nullptr),
+        _read_ctx(nullptr)
+{
+}
+
+void AdcSchedulerClass::setREADER(ADC_READ_FN fn, void* ctx)
+{
+    _read = fn;
+    _read_ctx = ctx;
+}
+
+uint8_t AdcSchedulerClass::addCHANNEL(const ADC_CHANNEL_DEF& def)
+{
+    if (_count >= ADC_SCHED_MAX_CHANNELS)
+    {
+        return ADC_SCHED_NONE;
+    }
+    CHANNEL& c = _ch[_count];
+    c.def = def;
+    c.enabled = true;
+    c.fresh = true;
+    c.have_value = false;
+    c.samples = 0;
+    c.ema = 0.0f;
+    c.due_ms = 0;
+    c.window.setSIZE(def.window);
+    return _count++;
+}
+
+bool AdcSchedulerClass::configure(uint8_t ch, uint8_t pin, uint8_t window, uint16_t fill_ms)
+{
+    if (ch >= _count)
+    {
+        return false;
+    }
+    CHANNEL& c = _ch[ch];
+    c.def.pin = pin;
+    c.def.fill_ms = fill_ms;
+    c.def.window = window;
+    c.window.setSIZE(window);           // refill at fill_ms; the last value stays readable meanwhile
+    c.have_value = false;
+    c.fresh = true;
+    return true;
+}
+
+void AdcSchedulerClass::setPERIOD(uint8_t ch, uint16_t period_ms)
+{
+    if (ch < _count)
+    {
+        _ch[ch].def.period_ms = period_ms;
+    }
+}
+
+void AdcSchedulerClass::setENABLED(uint8_t ch, bool on)
+{
+    if (ch < _count)
+    {
+        if (on && !_ch[ch].enabled) _ch[ch].fresh = true;
+        _ch[ch].enabled = on;
+    }
+}
+
+uint32_t AdcSchedulerClass::service(uint32_t now_ms, uint8_t max_samples)
+{
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        if (_ch[i].fresh)
+        {
+            _ch[i].due_ms = now_ms;
+            _ch[i].fresh = false;
+        }
+    }
+    uint8_t taken = 0;
+    uint8_t first = _next;
+    for (uint8_t k = 0; k < _count && taken < max_samples; k++)
+    {
+        uint8_t i = (uint8_t)((first + k) % _count);
+        CHANNEL& c = _ch[i];
+        if (!c.enabled || (int32_t)(now_ms - c.due_ms) < 0)
+        {
+            continue;
+        }
+        _sample(c, now_ms);
+        taken++;
+        _next = (uint8_t)((i + 1) % _count);
+    }
+
+    uint32_t wait = ADC_SCHED_IDLE;
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        if (!_ch[i].enabled) continue;
+        int32_t left = (int32_t)(_ch[i].due_ms - now_ms);
+        uint32_t w = left > 0 ? (uint32_t)left : 0;
+        if (w < wait) wait = w;
+    }
+    return wait;
+}
+
+void AdcSchedulerClass::_sample(CHANNEL& c, uint32_t now_ms)
+{
+    uint16_t raw = _read ? _read(c.def.pin, _read_ctx) : 0;
+    c.window.push(raw);
+    c.samples++;
+
+    const bool full = c.window.full();
+    uint32_t step = full ? c.def.period_ms : c.def.fill_ms;
+    if (!step) step = 1;
+    c.due_ms += step;
+    if ((int32_t)(now_ms - c.due_ms) > (int32_t)step)
+    {
+        c.due_ms = now_ms + step;       // fell far behind (owner was blocked): do not burst
+    }
+    if (!full)
+    {
+        return;
+    }
+    const float r = c.window.median3();
+    float v = c.def.convert ? c.def.convert(r, c.def.ctx) : r;
+    if (!c.have_value || c.def.ema_alpha >= 1.0f || c.def.ema_alpha <= 0.0f)
+    {
+        c.ema = v;
+    }
+    else
+    {
+        c.ema += c.def.ema_alpha * (v - c.ema);
+    }
+    c.have_value = true;
+    _publish(c, c.ema, r, now_ms);
+}
+
+// single writer (the owner task)
+void AdcSchedulerClass::_publish(CHANNEL& c, float value, float raw, uint32_t now_ms)
+{
+    ADC_CHANNEL_VALUE v;
+    v.value = value;
+    v.raw = raw;
+    v.time_ms = now_ms;
+    v.samples = c.samples;
+    c.latch.publish(v);
+}
+
+bool AdcSchedulerClass::read(uint8_t ch, ADC_CHANNEL_VALUE* out) const
+{
+    if (ch >= _count)
+    {
+        return false;
+    }
+    return _ch[ch].latch.read(out);
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "running_median.h"
+#include "seq_latch.h"
+
+// Multi-channel one-shot ADC scheduling, independent of the RTOS so tools/ can drive it.
+//
+// Each channel has its own pin, sample period, running-median window, optional EMA and a
+// conversion from filtered raw counts to its unit. service() is called by the one task that
+// owns the converter (adc_service.h): it takes one sample of every channel that is due, in
+// round-robin order starting after the channel served last, so a per-pass budget never
+// starves a channel. A channel samples at fill_ms until its window is full (start-up or after
+// a change), then at period_ms. Every sample of a full window republishes the channel's value
+// through a per-channel SeqLatch (seq_latch.h), which any task or core reads without a lock.
+
+const uint8_t ADC_SCHED_MAX_CHANNELS    = 4;
+const uint8_t ADC_SCHED_NONE            = 0xFF;
+const uint32_t ADC_SCHED_IDLE           = 0xFFFFFFFF;
+
+typedef uint16_t (*ADC_READ_FN)(uint8_t pin, void* ctx);            // one raw conversion
+typedef float    (*ADC_CONVERT_FN)(float raw, void* ctx);           // filtered raw -> unit
+
+typedef struct ADC_CHANNEL_DEF {
+    const char*    name;
+    uint8_t        pin;
+    uint16_t       period_ms;           // between samples once the window is full
+    uint16_t       fill_ms;             // between samples while it fills
+    uint8_t        window;              // running-median length, MEDIAN_MIN..MAX_SAMPLES
+    float          ema_alpha;           // on the converted value; 1 = off
+    ADC_CONVERT_FN convert;             // nullptr: the value is the filtered raw count
+    void*          ctx;
+} ADC_CHANNEL_DEF;
+
+typedef struct ADC_CHANNEL_VALUE {
+    float    value;                     // converted and smoothed
+    float    raw;                       // median3 of the window, counts
+    uint32_t time_ms;
+    uint32_t samples;                   // raw samples taken so far
+} ADC_CHANNEL_VALUE;
+
+class AdcSchedulerClass {
+public:
+    AdcSchedulerClass();
+    void setREADER(ADC_READ_FN fn, void* ctx);
+    uint8_t addCHANNEL(const ADC_CHANNEL_DEF& def);     // ADC_SCHED_NONE when full
+    bool configure(uint8_t ch, uint8_t pin, uint8_t window, uint16_t fill_ms);   // empties the window, refills
+    void setPERIOD(uint8_t ch, uint16_t period_ms);                                 // keeps the window
+    void setENABLED(uint8_t ch, bool on);
+    uint8_t channelCOUNT() const { return _count; }
+    const ADC_CHANNEL_DEF& def(uint8_t ch) const { return _ch[ch].def; }
+
+    // owner task only: samples what is due, returns ms until the next sample is due
+    uint32_t service(uint32_t now_ms, uint8_t max_samples = ADC_SCHED_MAX_CHANNELS);
+
+    // any task: false until the channel's window first filled
+    bool read(uint8_t ch, ADC_CHANNEL_VALUE* out) const;
+private:
+    typedef struct CHANNEL {
+        ADC_CHANNEL_DEF    def;
+        RunningMedianClass window;
+        bool               enabled;
+        bool               fresh;       // due at the next service()
+        bool               have_value;
+        uint32_t           due_ms;
+        uint32_t           samples;
+        float              ema;
+        SeqLatch<ADC_CHANNEL_VALUE> latch;
+    } CHANNEL;
+
+    CHANNEL     _ch[ADC_SCHED_MAX_CHANNELS];
+    uint8_t     _count;
+    uint8_t     _next;                  // round-robin start
+    ADC_READ_FN _read;
+    void*       _read_ctx;
+
+    void _sample(CHANNEL& c, uint32_t now_ms);
+    static void _publish(CHANNEL& c, float value, float raw, uint32_t now_ms);
+};
@@ -0,0 +1,188 @@
+// adc_service.cpp
+#include "adc_service.h"
+#include "task_CP.h"
+#include "idle_manager.h"
+
+#define ADC_RESOLUTION_BITS     12
+
+AdcServiceClass adc;
+
+AdcServiceClass::AdcServiceClass()
+    :   _sched(),
+        _mutex(NULL),
+        _task_handle(NULL)
+{
+    _sched.setREADER(_readPIN, this);
+}
+
+// before any addCHANNEL(); the battery monitor registers its channel in its own begin()
+bool AdcServiceClass::begin()
+{
+    _mutex = xSemaphoreCreateMutex();
+    if (!_mutex)
+    {
+        Serial.println("ADC::MUTEX::Creation failed");
+        return false;
+    }
+    analogReadResolution(ADC_RESOLUTION_BITS);
+    BaseType_t r = xTaskCreate(
+        _taskFunctionSTATIC,
+        "ADC_SCHEDULER_TASK",
+        3072, this,
+        ADC_SCHEDULER_TASK_PRIO,
+        &_task_handle
+    );
+    if (r != pdPASS)
+    {
+        Serial.println("ADC::TASK::Creation failed");
+        return false;
+    }
+    return true;
+}
+
+uint8_t AdcServiceClass::addCHANNEL(const ADC_CHANNEL_DEF& def)
+{
+    uint8_t ch = ADC_SCHED_NONE;
+    if (lockADC(portMAX_DELAY))
+    {
+        ch = _sched.addCHANNEL(def);
+        #if defined(ARDUINO_ARCH_ESP32)
+        if (ch != ADC_SCHED_NONE)
+        {
+            analogSetPinAttenuation(def.pin, ADC_11db);
+        }
+        #endif
+        unlockADC();
+    }
+    if (ch == ADC_SCHED_NONE)
+    {
+        Serial.printf("ADC::CHANNEL::no slot for %s\n", def.name);
+    }
+    _wake();
+    return ch;
+}
+
+void AdcServiceClass::configure(uint8_t ch, uint8_t pin, uint8_t window, uint16_t fill_ms)
+{
+    if (lockADC(portMAX_DELAY))
+    {
+        _sched.configure(ch, pin, window, fill_ms);
+        #if defined(ARDUINO_ARCH_ESP32)
+        analogSetPinAttenuation(pin, ADC_11db);
+        #endif
+        unlockADC();
+    }
+    _wake();
+}
+
+void AdcServiceClass::setPERIOD(uint8_t ch, uint16_t period_ms)
+{
+    if (lockADC(portMAX_DELAY))
+    {
+        _sched.setPERIOD(ch, period_ms);
+        unlockADC();
+    }
+}
+
+void AdcServiceClass::setENABLED(uint8_t ch, bool on)
+{
+    if (lockADC(portMAX_DELAY))
+    {
+        _sched.setENABLED(ch, on);
+        unlockADC();
+    }
+    _wake();
+}
+
+bool AdcServiceClass::lockADC(uint32_t timeout_ms)
+{
+    TickType_t t = timeout_ms == portMAX_DELAY ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    return _mutex && xSemaphoreTake(_mutex, t) == pdTRUE;
+}
+
+void AdcServiceClass::unlockADC()
+{
+    xSemaphoreGive(_mutex);
+}
+
+void AdcServiceClass::_wake()
+{
+    if (_task_handle)
+    {
+        xTaskNotifyGive(_task_handle);
+    }
+}
+
+uint16_t AdcServiceClass::_readPIN(uint8_t pin, void* ctx)
+{
+    (void)ctx;
+    return analogRead(pin);
+}
+
+void AdcServiceClass::_taskFunctionSTATIC(void* p)
+{
+    static_cast<AdcServiceClass*>(p)->_taskFUNC();
+}
+
+// every channel that is due in one pass, then sleep until the earliest next one
+void AdcServiceClass::_taskFUNC()
+{
+    for (;;)
+    {
+        uint32_t wait_ms = ADC_SERVICE_MAX_WAIT_MS;
+        if (lockADC(portMAX_DELAY))
+        {
+            wait_ms = _sched.service(millis());
+            unlockADC();
+        }
+        if (wait_ms > ADC_SERVICE_MAX_WAIT_MS)
+        {
+            wait_ms = ADC_SERVICE_MAX_WAIT_MS;
+        }
+        // steady sampling lands on the shared slot edges, together with the other periodic
+        // tasks; a window filling at fill_ms stays a short burst
+        if (wait_ms >= IDLE_SLOT_MS)
+        {
+            uint32_t now = millis();
+            wait_ms = idleALIGN_UP(now + wait_ms) - now;
+        }
+        TickType_t t = pdMS_TO_TICKS(wait_ms);
+        ulTaskNotifyTake(pdTRUE, t ? t : 1);
+    }
+}
+
+void AdcServiceClass::printCHANNELS()
+{
+    uint32_t now = millis();
+    Serial.println("ADC:: ch name      pin period window      value      raw    age ms  samples");
+    for (uint8_t i = 0; i < _sched.channelCOUNT(); i++)
+    {
+        const ADC_CHANNEL_DEF& d = _sched.def(i);
+        ADC_CHANNEL_VALUE v;
+        if (_sched.read(i, &v))
+        {
+            Serial.printf("ADC:: %2u %-9s %3u %6u %6u %10.3f %8.1f %9u %8u\n", i, d.name, d.pin, d.period_ms,
+                          d.window, v.value, v.raw, (unsigned)(now - v.time_ms), (unsigned)v.samples);
+        }
+        else
+        {
+            Serial.printf("ADC:: %2u %-9s %3u %6u %6u    (filling)\n", i, d.name, d.pin, d.period_ms, d.window);
+        }
+    }
+}
+
+// ----------------- console commands -----------------
+static void cmd_ADC(void* ctx, const CmdArgs& args)
+{
+    (void)args;
+    static_cast<AdcServiceClass*>(ctx)->printCHANNELS();
+}
+
+static constexpr CONSOLE_CMD ADC_COMMANDS[] = {
+    {"ADC", nullptr, 0, cmd_ADC, "- sampled ADC channels and their filtered values"},
+};
+
+void AdcServiceClass::registerCOMMANDS(SerialConsoleClass& console)
+{
+    console.addTABLE(ADC_COMMANDS, this, "ADC");
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "adc_scheduler.h"
+#include "serial_console.h"
+
+// The one task that touches the ADC in one-shot mode (adc_scheduler.h for the scheduling).
+//
+// Channels are added before or after begin(); their filtered values are read lock-free with
+// read(). Everything else that needs the converter for a while - the battery monitor's DMA
+// block reads - takes lockADC() first, which also holds the scheduler off. The task sleeps
+// until the next channel is due, or until a configuration change notifies it.
+
+const uint16_t ADC_SERVICE_MAX_WAIT_MS = 1000;
+
+class AdcServiceClass {
+public:
+    AdcServiceClass();
+    bool begin();
+    uint8_t addCHANNEL(const ADC_CHANNEL_DEF& def);                     // ADC_SCHED_NONE when full
+    void configure(uint8_t ch, uint8_t pin, uint8_t window, uint16_t fill_ms);
+    void setPERIOD(uint8_t ch, uint16_t period_ms);
+    void setENABLED(uint8_t ch, bool on);
+    bool read(uint8_t ch, ADC_CHANNEL_VALUE* out) const { return _sched.read(ch, out); }
+
+    bool lockADC(uint32_t timeout_ms);
+    void unlockADC();
+    void printCHANNELS();
+    void registerCOMMANDS(SerialConsoleClass& console);
+private:
+    AdcSchedulerClass _sched;           // mutated under _mutex only
+    SemaphoreHandle_t _mutex;
+    TaskHandle_t      _task_handle;
+
+    static uint16_t _readPIN(uint8_t pin, void* ctx);
+    static void _taskFunctionSTATIC(void* p);
+    void _taskFUNC();
+    void _wake();
+};
+
+extern AdcServiceClass adc;
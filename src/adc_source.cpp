@@ -0,0 +1,87 @@
+// adc_source.cpp
+#include "adc_source.h"
+#include <string.h>
+
+float adcBlockFILTER(const uint16_t* samples, size_t n)
+{
+    const uint8_t bins = (ADC_RAW_MAX >> ADC_FILTER_BIN_SHIFT) + 1;
+    uint16_t count[bins];
+    uint32_t sum[bins];
+    memset(count, 0, sizeof(count));
+    memset(sum, 0, sizeof(sum));
+    if (n == 0)
+    {
+        return 0.0f;
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        uint16_t s = samples[i] > ADC_RAW_MAX ? ADC_RAW_MAX : samples[i];
+        uint8_t b = s >> ADC_FILTER_BIN_SHIFT;
+        count[b]++;
+        sum[b] += s;
+    }
+    // median bin
+    size_t half = (n + 1) / 2;
+    size_t seen = 0;
+    uint8_t m = 0;
+    for (; m < bins - 1; m++)
+    {
+        seen += count[m];
+        if (seen >= half) break;
+    }
+    uint8_t lo = m > 0 ? m - 1 : 0;
+    uint8_t hi = m < bins - 1 ? m + 1 : bins - 1;
+    uint32_t c = 0;
+    uint32_t s = 0;
+    for (uint8_t b = lo; b <= hi; b++)
+    {
+        c += count[b];
+        s += sum[b];
+    }
+    return (float)s / (float)c;
+}
+
+AdcSimSOURCE::AdcSimSOURCE(uint16_t level, uint16_t noise, uint16_t spike_every)
+    :   _level(level),
+        _noise(noise),
+        _spike_every(spike_every),
+        _rng(0x12345678u),
+        _rate_hz(0),
+        _produced(0),
+        _running(false)
+{
+}
+
+bool AdcSimSOURCE::start(uint8_t pin, uint32_t sample_rate_hz)
+{
+    (void)pin;
+    _rate_hz = sample_rate_hz;
+    _running = true;
+    return true;
+}
+
+size_t AdcSimSOURCE::read(uint16_t* out, size_t max, uint32_t timeout_ms)
+{
+    (void)timeout_ms;
+    if (!_running)
+    {
+        return 0;
+    }
+    for (size_t i = 0; i < max; i++)
+    {
+        _produced++;
+        if (_spike_every && (_produced % _spike_every) == 0)
+        {
+            out[i] = (_produced & 1) ? ADC_RAW_MAX : 0;
+            continue;
+        }
+        _rng = _rng * 1664525u + 1013904223u;
+        int32_t v = (int32_t)_level;
+        if (_noise)
+        {
+            v += (int32_t)((_rng >> 16) % (2u * _noise + 1u)) - (int32_t)_noise;
+        }
+        out[i] = (uint16_t)(v < 0 ? 0 : (v > ADC_RAW_MAX ? ADC_RAW_MAX : v));
+    }
+    return max;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Sample sources for the battery monitor's block (DMA) sampling mode.
+//
+// A source is started at a sample rate, hands out raw 12-bit readings of one channel in
+// blocks, and is stopped between readings so the converter is idle for the rest of the
+// interval. AdcDmaSOURCE (adc_dma_source.h) is the ESP32-S3 continuous driver; AdcSimSOURCE
+// below is a deterministic stand-in so filtering and throughput can be checked off target.
+
+const uint16_t ADC_RAW_MAX          = 4095;
+const uint8_t  ADC_FILTER_BIN_SHIFT = 6;        // 64 bins of 64 LSB
+
+class AdcSourceClass {
+public:
+    virtual ~AdcSourceClass() {}
+    virtual bool   start(uint8_t pin, uint32_t sample_rate_hz) = 0;
+    virtual void   stop() = 0;
+    // blocks until max samples arrived or timeout; returns how many were written
+    virtual size_t read(uint16_t* out, size_t max, uint32_t timeout_ms) = 0;
+};
+
+// One pass over the block: a 64-bin histogram with per-bin sums. The result is the mean of
+// the samples in the median bin and its two neighbours, so spikes and rail hits outside that
+// 192-LSB band are dropped without sorting. 0 for an empty block.
+float adcBlockFILTER(const uint16_t* samples, size_t n);
+
+class AdcSimSOURCE : public AdcSourceClass {
+public:
+    AdcSimSOURCE(uint16_t level = 2048, uint16_t noise = 8, uint16_t spike_every = 0);
+    void setLEVEL(uint16_t level) { _level = level; }
+    bool   start(uint8_t pin, uint32_t sample_rate_hz);
+    void   stop() { _running = false; }
+    size_t read(uint16_t* out, size_t max, uint32_t timeout_ms);
+    uint32_t samplesPRODUCED() const { return _produced; }
+    uint32_t sampleRATE() const { return _rate_hz; }
+private:
+    uint16_t _level;
+    uint16_t _noise;
+    uint16_t _spike_every;          // every Nth sample hits a rail, 0 = never
+    uint32_t _rng;
+    uint32_t _rate_hz;
+    uint32_t _produced;
+    bool     _running;
+};
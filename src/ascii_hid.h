@@ -0,0 +1,14 @@
+#pragma once
+#include <stdint.h>
+
+// 7-bit ASCII -> HID keyboard usage (US layout). Bit 7 set means the character needs Shift;
+// 0 means the character has no key and is skipped.
+const uint8_t ASCII_HID_SHIFT = 0x80;
+const uint8_t ASCII_HID_USAGE = 0x7F;
+
+extern const uint8_t ASCII_TO_HID[128];
+
+inline uint8_t asciiToHID(char c)
+{
+    return ((uint8_t)c < 128) ? ASCII_TO_HID[(uint8_t)c] : 0;
+}
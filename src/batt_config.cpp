@@ -0,0 +1,71 @@
+// batt_config.cpp
+#include "batt_config.h"
+#include <string.h>
+
+// CRC-32 (IEEE, reflected), nibble table
+static constexpr uint32_t CRC32_NIBBLE[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+uint32_t battConfigCRC(const uint8_t* data, size_t len)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ CRC32_NIBBLE[crc & 0x0F];
+        crc = (crc >> 4) ^ CRC32_NIBBLE[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+size_t battConfigENCODE(const BATT_CONFIG_DATA& cfg, uint8_t* out)
+{
+    out[0] = (uint8_t)(BATT_CONFIG_MAGIC & 0xFF);
+    out[1] = (uint8_t)(BATT_CONFIG_MAGIC >> 8);
+    out[2] = BATT_CONFIG_VERSION;
+    out[3] = (uint8_t)sizeof(BATT_CONFIG_DATA);
+    memcpy(out + BATT_CONFIG_HEADER, &cfg, sizeof(BATT_CONFIG_DATA));
+    const size_t body = BATT_CONFIG_HEADER + sizeof(BATT_CONFIG_DATA);
+    uint32_t crc = battConfigCRC(out, body);
+    memcpy(out + body, &crc, sizeof(crc));
+    return body + sizeof(crc);
+}
+
+bool battConfigDECODE(const uint8_t* blob, size_t len, BATT_CONFIG_DATA* cfg)
+{
+    if (len < BATT_CONFIG_HEADER + 4)
+    {
+        return false;
+    }
+    const uint16_t magic = (uint16_t)(blob[0] | (blob[1] << 8));
+    const uint8_t version = blob[2];
+    const uint8_t payload = blob[3];
+    if (magic != BATT_CONFIG_MAGIC || version == 0 || version > BATT_CONFIG_VERSION)
+    {
+        return false;
+    }
+    if (len != (size_t)BATT_CONFIG_HEADER + payload + 4)
+    {
+        return false;
+    }
+    uint32_t crc;
+    memcpy(&crc, blob + BATT_CONFIG_HEADER + payload, sizeof(crc));
+    if (crc != battConfigCRC(blob, BATT_CONFIG_HEADER + payload))
+    {
+        return false;
+    }
+
+    // appended fields keep their defaults when the stored payload is shorter
+    BATT_CONFIG_DATA tmp = *cfg;
+    memcpy(&tmp, blob + BATT_CONFIG_HEADER, payload < sizeof(tmp) ? payload : sizeof(tmp));
+    switch (version)
+    {
+        // case 1 -> 2 conversions go here once a field changes meaning or type
+        default:
+            break;
+    }
+    *cfg = tmp;
+    return true;
+}
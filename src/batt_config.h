@@ -0,0 +1,48 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Battery monitor settings as one packed, versioned, CRC-protected NVS blob.
+//
+//   magic(2) version(1) length(1) | BATT_CONFIG_DATA (length bytes) | crc32(4)
+//
+// The CRC covers header and payload. Fields are only ever appended to BATT_CONFIG_DATA, so an
+// older blob is decoded by copying its shorter payload over the defaults; anything that is not
+// a plain append bumps BATT_CONFIG_VERSION and gets a case in battConfigDECODE(). A blob from
+// a newer firmware, a bad CRC or a wrong length is rejected and the defaults stay.
+
+const uint16_t BATT_CONFIG_MAGIC    = 0xBA7C;
+const uint8_t  BATT_CONFIG_VERSION  = 1;
+const uint8_t  BATT_CONFIG_HEADER   = 4;
+const uint8_t  BATT_CONFIG_CAL_POINTS = 6;
+
+typedef struct __attribute__((packed)) BATT_CONFIG_DATA {
+    // version 1
+    uint8_t  pin_adc;
+    float    r_top;
+    float    r_bottom;
+    uint8_t  number_of_samples;
+    uint16_t sample_delay_ms;
+    uint16_t interval_ms;
+    float    ema_alpha;
+    float    adc_ref;
+    float    calibration_factor;
+    uint8_t  charge_status_pin;
+    uint8_t  sample_mode;
+    uint32_t block_rate_hz;
+    uint16_t block_samples;
+    uint8_t  chemistry;
+    uint16_t capacity_mah;
+    // appended: multi-point ADC calibration (adc_calibration.h), pin mV at raw counts
+    uint8_t  cal_count;
+    uint16_t cal_raw[BATT_CONFIG_CAL_POINTS];
+    uint16_t cal_mv[BATT_CONFIG_CAL_POINTS];
+} BATT_CONFIG_DATA;
+
+const size_t BATT_CONFIG_BLOB_SIZE = BATT_CONFIG_HEADER + sizeof(BATT_CONFIG_DATA) + 4;
+
+uint32_t battConfigCRC(const uint8_t* data, size_t len);
+// serialise into out (BATT_CONFIG_BLOB_SIZE bytes), returns the blob length
+size_t battConfigENCODE(const BATT_CONFIG_DATA& cfg, uint8_t* out);
+// cfg must hold the defaults; it is only overwritten by a valid blob
+bool battConfigDECODE(const uint8_t* blob, size_t len, BATT_CONFIG_DATA* cfg);
@@ -0,0 +1,269 @@
+// batt_history.cpp
+#include "batt_history.h"
+#include "serial_console.h"
+#include "esp_timer.h"
+
+BattHistoryClass::BattHistoryClass()
+    :   _part(nullptr),
+        _mutex(NULL),
+        _pages(0),
+        _next_page(0),
+        _next_seq(1),
+        _clock_base(0),
+        _boot(true),
+        _have_last(false),
+        _last_t(0),
+        _last_charging(false)
+{
+    memset(_headers, 0, sizeof(_headers));
+}
+
+bool BattHistoryClass::begin()
+{
+    _part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)HIST_PARTITION_SUBTYPE, HIST_PARTITION_LABEL);
+    if (!_part)
+    {
+        Serial.println("HISTORY::no \"" HIST_PARTITION_LABEL "\" partition, history disabled");
+        return false;
+    }
+    _mutex = xSemaphoreCreateMutex();
+    if (!_mutex)
+    {
+        Serial.println("HISTORY::MUTEX::Creation failed");
+        return false;
+    }
+    _pages = (uint8_t)min((uint32_t)HIST_MAX_PAGES, _part->size / HIST_PAGE_SIZE);
+
+    // full read of every sector once: the CRC covers the data, not just the header
+    int newest = -1;
+    for (uint8_t i = 0; i < _pages; i++)
+    {
+        if (esp_partition_read(_part, (size_t)i * HIST_PAGE_SIZE, _scratch, HIST_PAGE_SIZE) != ESP_OK ||
+            !histPageVALID(_scratch))
+        {
+            continue;
+        }
+        memcpy(&_headers[i], _scratch, HIST_HEADER_SIZE);
+        if (newest < 0 || (int32_t)(_headers[i].seq - _headers[newest].seq) > 0)
+        {
+            newest = i;
+        }
+    }
+    if (newest >= 0)
+    {
+        _next_page = (uint8_t)((newest + 1) % _pages);
+        _next_seq = _headers[newest].seq + 1;
+        _clock_base = _headers[newest].t_end + 1;
+    }
+    _writer.begin(_page, _next_seq);
+    Serial.printf("HISTORY::%u of %u pages used\n", pagesUSED(), _pages);
+    return true;
+}
+
+uint32_t BattHistoryClass::now() const
+{
+    return _clock_base + (uint32_t)(esp_timer_get_time() / 1000000LL);
+}
+
+uint8_t BattHistoryClass::pagesUSED() const
+{
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < _pages; i++)
+    {
+        if (_headers[i].magic == HIST_MAGIC) n++;
+    }
+    return n;
+}
+
+void BattHistoryClass::record(uint16_t mv, bool charging)
+{
+    if (!_mutex)
+    {
+        return;
+    }
+    const uint32_t t = now();
+    if (_have_last && t - _last_t < HIST_SAMPLE_S && charging == _last_charging)
+    {
+        return;
+    }
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    HIST_SAMPLE x;
+    x.t = t;
+    x.mv = mv;
+    x.flags = (charging ? HIST_FLAG_CHARGING : 0) | (_boot ? HIST_FLAG_BOOT : 0);
+    if (!_writer.append(x))
+    {
+        _commitPAGE();
+        _writer.append(x);
+    }
+    _boot = false;
+    _have_last = true;
+    _last_t = t;
+    _last_charging = charging;
+    if (t - _writer.header().t_start >= HIST_FLUSH_S)
+    {
+        _commitPAGE();
+    }
+    xSemaphoreGive(_mutex);
+}
+
+bool BattHistoryClass::flush()
+{
+    if (!_mutex)
+    {
+        return false;
+    }
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    bool ok = _commitPAGE();
+    xSemaphoreGive(_mutex);
+    return ok;
+}
+
+// caller holds _mutex; one erase + one write per page
+bool BattHistoryClass::_commitPAGE()
+{
+    if (_writer.empty())
+    {
+        return true;
+    }
+    _writer.seal();
+    const size_t at = (size_t)_next_page * HIST_PAGE_SIZE;
+    _headers[_next_page].magic = 0;
+    bool ok = esp_partition_erase_range(_part, at, HIST_PAGE_SIZE) == ESP_OK &&
+              esp_partition_write(_part, at, _page, HIST_PAGE_SIZE) == ESP_OK;
+    if (ok)
+    {
+        memcpy(&_headers[_next_page], _page, HIST_HEADER_SIZE);
+    }
+    else
+    {
+        Serial.println("HISTORY::page write failed");
+    }
+    // a failed sector is skipped rather than retried forever
+    _next_page = (uint8_t)((_next_page + 1) % _pages);
+    _next_seq++;
+    _writer.begin(_page, _next_seq);
+    return ok;
+}
+
+void BattHistoryClass::_addPAGE(const uint8_t* page, uint32_t t_from, uint32_t t_to, HIST_STATS* out)
+{
+    HistPageReaderClass r;
+    if (!r.begin(page, false))
+    {
+        return;
+    }
+    HIST_SAMPLE s;
+    while (r.next(&s))
+    {
+        if (s.t >= t_from && s.t <= t_to) histStatsADD(out, s);
+    }
+}
+
+bool BattHistoryClass::query(uint32_t t_from, uint32_t t_to, HIST_STATS* out)
+{
+    histStatsRESET(out);
+    if (!_mutex)
+    {
+        return false;
+    }
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    for (uint8_t i = 0; i < _pages; i++)
+    {
+        const HIST_PAGE_HEADER& h = _headers[i];
+        if (h.magic != HIST_MAGIC || !h.count || h.t_end < t_from || h.t_start > t_to)
+        {
+            continue;
+        }
+        if (h.t_start >= t_from && h.t_end <= t_to)
+        {
+            histStatsADD_PAGE(out, h);
+            continue;
+        }
+        if (esp_partition_read(_part, (size_t)i * HIST_PAGE_SIZE, _scratch, HIST_PAGE_SIZE) == ESP_OK)
+        {
+            _addPAGE(_scratch, t_from, t_to, out);
+        }
+    }
+    if (!_writer.empty())
+    {
+        _addPAGE(_page, t_from, t_to, out);
+    }
+    xSemaphoreGive(_mutex);
+    return true;
+}
+
+// ----------------- console commands -----------------
+static void printSTATS(const char* what, const HIST_STATS& s)
+{
+    if (!s.count)
+    {
+        Serial.printf("HISTORY:: %s: no samples\n", what);
+        return;
+    }
+    Serial.printf("HISTORY:: %s: %u samples over %.1f h, min %u mV avg %u mV max %u mV\n",
+                  what, s.count, (s.t_last - s.t_first) / 3600.0f,
+                  s.mv_min, (unsigned)(s.mv_sum / s.count), s.mv_max);
+}
+
+// HISTORY [hours]: the last hours (default 24)
+static void cmd_HISTORY(void* ctx, const CmdArgs& args)
+{
+    BattHistoryClass* h = static_cast<BattHistoryClass*>(ctx);
+    long hours = 24;
+    if (args.count() && (!args.toINT(0, &hours) || hours <= 0))
+    {
+        Serial.println("HISTORY:: hours expected");
+        return;
+    }
+    uint32_t t = h->now();
+    uint32_t span = (uint32_t)hours * 3600u;
+    HIST_STATS s;
+    h->query(t > span ? t - span : 0, t, &s);
+    printSTATS("window", s);
+}
+
+// HISTORY RANGE <from_h> <to_h>: hours ago, e.g. RANGE 720 696 is one day a month back
+static void cmd_HISTORY_RANGE(void* ctx, const CmdArgs& args)
+{
+    BattHistoryClass* h = static_cast<BattHistoryClass*>(ctx);
+    long from_h, to_h;
+    if (!args.toINT(0, &from_h) || !args.toINT(1, &to_h) || from_h < to_h || to_h < 0)
+    {
+        Serial.println("HISTORY:: <from hours ago> <to hours ago> expected, from >= to");
+        return;
+    }
+    uint32_t t = h->now();
+    uint32_t a = (uint32_t)from_h * 3600u, b = (uint32_t)to_h * 3600u;
+    HIST_STATS s;
+    h->query(t > a ? t - a : 0, t > b ? t - b : 0, &s);
+    printSTATS("range", s);
+}
+
+static void cmd_HISTORY_INFO(void* ctx, const CmdArgs& args)
+{
+    (void)args;
+    BattHistoryClass* h = static_cast<BattHistoryClass*>(ctx);
+    HIST_STATS s;
+    h->query(0, 0xFFFFFFFFu, &s);
+    Serial.printf("HISTORY:: %u of %u pages, log clock %u s\n", h->pagesUSED(), h->pageCOUNT(), h->now());
+    printSTATS("all", s);
+}
+
+static void cmd_HISTORY_FLUSH(void* ctx, const CmdArgs& args)
+{
+    (void)args;
+    Serial.println(static_cast<BattHistoryClass*>(ctx)->flush() ? "HISTORY:: page written" : "HISTORY:: write failed");
+}
+
+static constexpr CONSOLE_CMD HISTORY_COMMANDS[] = {
+    {"HISTORY", "RANGE", 2, cmd_HISTORY_RANGE, "<from_h> <to_h>  - min/avg/max mV between two points, hours ago"},
+    {"HISTORY", "INFO",  0, cmd_HISTORY_INFO,  "- pages used and the whole log's min/avg/max"},
+    {"HISTORY", "FLUSH", 0, cmd_HISTORY_FLUSH, "- write the page in RAM to flash now"},
+    {"HISTORY", nullptr, 0, cmd_HISTORY,       "[hours]  - min/avg/max mV over the last hours (24)"},
+};
+
+void BattHistoryClass::registerCOMMANDS(SerialConsoleClass& console)
+{
+    console.addTABLE(HISTORY_COMMANDS, this, "HISTORY");
+}
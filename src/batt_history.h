@@ -0,0 +1,62 @@
+#pragma once
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_partition.h"
+#include "history_codec.h"
+
+// Persistent battery history in the "battlog" data partition (partitions_battlog.csv).
+//
+// The partition is a ring of HIST_PAGE_SIZE sectors. Samples collect in a RAM page
+// (history_codec.h) and reach flash a whole page at a time: one erase and one write when the
+// page fills or is HIST_FLUSH_S old, so each sector is erased once per lap of the ring. The
+// newest page is the one with the highest sequence; the page after it is overwritten next.
+// All page headers are cached at boot, so a window query reads flash only for the (at most
+// two) pages straddling its edges.
+// There is no RTC: log time continues from the newest page at every boot and the first sample
+// is flagged HIST_FLAG_BOOT, so power-off gaps are visible but not measured.
+// Flush cadence: a page holds about 22 h of one-a-minute samples, and a flush seals it, so the
+// time limit sits just under that: pages leave RAM about 90 % full and the ring keeps a month.
+// The price is that a power loss can take up to HIST_FLUSH_S of samples with it; the main loop
+// flushes when the battery enters the critical tier, which covers the usual way power is lost.
+// Appending to a written sector instead would need a header that does not change (count, span
+// and CRC do), so the page format is kept.
+
+#define HIST_PARTITION_LABEL        "battlog"
+const uint8_t  HIST_PARTITION_SUBTYPE   = 0x40;     // custom data subtype, see partitions_battlog.csv
+const uint8_t  HIST_MAX_PAGES           = 32;
+const uint32_t HIST_SAMPLE_S            = 60;       // one sample a minute, or on a charging edge
+const uint32_t HIST_FLUSH_S             = 20 * 3600; // a partly filled page is written after this
+
+class SerialConsoleClass;
+
+class BattHistoryClass {
+public:
+    BattHistoryClass();
+    bool begin();                                   // finds the partition and scans the page headers
+    void record(uint16_t mv, bool charging);        // rate-limited to HIST_SAMPLE_S; may write a page
+    bool flush();                                   // write the RAM page now
+    bool query(uint32_t t_from, uint32_t t_to, HIST_STATS* out);    // log seconds, inclusive
+    uint32_t now() const;                           // log seconds
+    uint8_t  pagesUSED() const;
+    uint8_t  pageCOUNT() const { return _pages; }
+    void registerCOMMANDS(SerialConsoleClass& console);
+private:
+    const esp_partition_t* _part;
+    SemaphoreHandle_t _mutex;
+    uint8_t   _pages;
+    uint8_t   _next_page;                           // sector the RAM page goes to
+    uint32_t  _next_seq;
+    uint32_t  _clock_base;                          // log seconds at boot
+    bool      _boot;                                // next sample is the first after power-up
+    bool      _have_last;
+    uint32_t  _last_t;
+    bool      _last_charging;
+    HIST_PAGE_HEADER _headers[HIST_MAX_PAGES];      // flash pages; magic 0 = empty or invalid
+    HistPageWriterClass _writer;
+    uint8_t   _page[HIST_PAGE_SIZE];                // RAM page being filled
+    uint8_t   _scratch[HIST_PAGE_SIZE];             // edge pages during a query
+
+    bool _commitPAGE();
+    void _addPAGE(const uint8_t* page, uint32_t t_from, uint32_t t_to, HIST_STATS* out);
+};
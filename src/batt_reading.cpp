@@ -1,6 +1,7 @@
 // batt_reading.cpp
 #include <helper_keyboard_ble.h>
 #include "task_CP.h"
+#include <atomic>
 #define DEFAULT_ADC_PIN         4
 #define DEFAULT_R_TOP           100000.0f
 #define DEFAULT_R_BOTTOM        100000.0f
@@ -8,10 +9,17 @@
 #define DEFAULT_SAMPLE_DELAY    5
 #define DEFAULT_INTERVAL_MS     1500
 #define DEFAULT_EMA_ALPHA       0.2f 
-#define DEFAULT_ADC_MAX         4095.0f
 #define DEFAULT_ADC_REF         3.3f
+#define DEFAULT_SAMPLE_MODE     BATT_SAMPLE_ONESHOT
+#define DEFAULT_BLOCK_RATE_HZ   20000
+#define DEFAULT_BLOCK_SAMPLES   256
+#define DEFAULT_CHEMISTRY       SOC_CHEM_LIPO
+#define DEFAULT_CAPACITY_MAH    1000
+#define DEFAULT_LOAD_MA         80.0f
 
-#define PREF_NAMESPACE          "BATTERY-MONITOR:V1"
+#define PREF_NAMESPACE          "BATMON"            // NVS names are limited to 15 chars
+#define PREF_CONFIG_KEY         "cfg"
+#define CONFIG_COMMIT_IDLE_MS   5000                // unsaved edits are written after this much quiet
 
 BatteryMonitorClass::BatteryMonitorClass()
     :   pin_adc(DEFAULT_ADC_PIN),
@@ -24,10 +32,35 @@ BatteryMonitorClass::BatteryMonitorClass()
         adc_ref(DEFAULT_ADC_REF),
         calibration_factor(1.0f),
         charge_status_pin(5),
+        sample_mode(DEFAULT_SAMPLE_MODE),
+        block_rate_hz(DEFAULT_BLOCK_RATE_HZ),
+        block_samples(DEFAULT_BLOCK_SAMPLES),
+        chemistry(DEFAULT_CHEMISTRY),
+        capacity_mah(DEFAULT_CAPACITY_MAH),
         _ema_voltage(0.0f),
-        _last_percentage(0),
+        _block_raw(0.0f),
+        _policy_interval_ms(0),
+        _soc(),
+        _load_ma(DEFAULT_LOAD_MA),
+        _soc_last_ms(0),
+        _config_dirty(false),
+        _config_changed_ms(0),
+        _saved_crc(0),
+        _snapshot(),
+        _cal(),
+        _cal_stale(true),
+        _cal_pin(0xFF),
+        _charge(),
         _prefs(),
         _mutex(NULL),
+        _adc_ch(ADC_SCHED_NONE),
+        _ch_pin(0xFF),
+        _ch_window(0),
+        _ch_fill_ms(0),
+        _ch_period_ms(0),
+        _ch_enabled(true),
+        _dma_source(),
+        _source(&_dma_source),
         _task_handle(NULL)
 {
 }
@@ -41,27 +74,27 @@ bool BatteryMonitorClass::begin()
         return false;
     }
     _prefs.begin(PREF_NAMESPACE,false);
-    pin_adc = _prefs.getInt("pin_adc",pin_adc);
-    r_top = _prefs.getFloat("r_top",r_top);
-    r_bottom =  _prefs.getFloat("r_bottom",r_bottom);
-    number_of_samples = _prefs.getInt("num_samp",number_of_samples);
-    sample_delay_ms = _prefs.getInt("s_delayMS",sample_delay_ms);
-    interval_ms = _prefs.getInt("interval_MS",interval_ms);
-    ema_alpha = _prefs.getFloat("ema_alpha",ema_alpha);
-    adc_ref = _prefs.getFloat("adc_ref",adc_ref);
-    calibration_factor = _prefs.getFloat("calibration_factor",calibration_factor);
-    charge_status_pin = _prefs.getInt("charge_status_pin",charge_status_pin);
+    _loadCONFIG();
+    _rebuildCAL();
+    _soc.setPROFILE(chemistry);
+    _soc.setCAPACITY(capacity_mah);
 
-    analogReadResolution(ATDR);
-    #if defined(ARDUINO_ARCH_ESP32)
-    analogSetPinAttenuation(pin_adc,ADC_11db);
-    #endif
-
-
-    if(charge_status_pin>=0)
+    // one-shot samples come from the shared scheduler task (adc.begin() runs first)
+    ADC_CHANNEL_DEF ch = {"battery", pin_adc, _samplePERIOD(), sample_delay_ms, number_of_samples, 1.0f, nullptr, nullptr};
+    _adc_ch = adc.addCHANNEL(ch);
+    if (_adc_ch == ADC_SCHED_NONE)
     {
-        pinMode(charge_status_pin,INPUT_PULLUP);
+        Serial.println("BATTERY::ADC::no scheduler channel");
+        return false;
     }
+    _ch_pin = pin_adc;
+    _ch_window = number_of_samples;
+    _ch_fill_ms = sample_delay_ms;
+    _ch_period_ms = _samplePERIOD();
+    _syncCHANNEL();
+
+    // STAT pin by interrupt (charge_status.h); 0xFF (SET CHARGEINDICATOR -1) means none
+    _charge.begin(charge_status_pin);
     //Battery Monitor Task
     BaseType_t r = xTaskCreate(
         _taskFunctionSTATIC,
@@ -81,81 +114,237 @@ bool BatteryMonitorClass::begin()
 
 void BatteryMonitorClass::saveSETTINGS()
 {
-    _prefs.putInt("pin_adc",pin_adc);
-    _prefs.putFloat("r_top",r_top);
-    _prefs.putFloat("r_bottom",r_bottom);
-    _prefs.putInt("num_samp",number_of_samples);
-    _prefs.putInt("s_delayMS",sample_delay_ms);
-    _prefs.putInt("interval_MS",interval_ms);
-    _prefs.putFloat("ema_alpha",ema_alpha);
-    _prefs.putFloat("adc_ref",adc_ref);
-    _prefs.putFloat("calibration_factor",calibration_factor);
-    _prefs.putInt("charge_status_pin",charge_status_pin);
-    Serial.println("BATTERY:Prefarance settings saved.");
+    if (_commitCONFIG())
+    {
+        Serial.println("BATTERY:Prefarance settings saved.");
+    }
+    else
+    {
+        Serial.println("BATTERY:Prefarance settings unchanged.");
+    }
 }
 
-// <- default removed here; header should keep the default if you want one
-bool BatteryMonitorClass::getBatterySTATUS(float* outVoltage,int* outPercent,bool* outCharging)
+// ----------------- config blob (batt_config.h) -----------------
+static_assert(BATT_CONFIG_CAL_POINTS >= ADC_CAL_MAX_POINTS, "config blob must hold every calibration point");
+
+void BatteryMonitorClass::_packCONFIG(BATT_CONFIG_DATA* c)
 {
-    if (!_mutex)
+    c->pin_adc = pin_adc;
+    c->r_top = r_top;
+    c->r_bottom = r_bottom;
+    c->number_of_samples = number_of_samples;
+    c->sample_delay_ms = sample_delay_ms;
+    c->interval_ms = interval_ms;
+    c->ema_alpha = ema_alpha;
+    c->adc_ref = adc_ref;
+    c->calibration_factor = calibration_factor;
+    c->charge_status_pin = charge_status_pin;
+    c->sample_mode = sample_mode;
+    c->block_rate_hz = block_rate_hz;
+    c->block_samples = block_samples;
+    c->chemistry = chemistry;
+    c->capacity_mah = capacity_mah;
+    memset(c->cal_raw, 0, sizeof(c->cal_raw));
+    memset(c->cal_mv, 0, sizeof(c->cal_mv));
+    c->cal_count = _cal.pointCOUNT();
+    for (uint8_t i = 0; i < c->cal_count; i++)
+    {
+        c->cal_raw[i] = _cal.point(i).raw;
+        c->cal_mv[i] = _cal.point(i).mv;
+    }
+}
+
+void BatteryMonitorClass::_unpackCONFIG(const BATT_CONFIG_DATA& c)
+{
+    pin_adc = c.pin_adc;
+    r_top = c.r_top;
+    r_bottom = c.r_bottom;
+    number_of_samples = c.number_of_samples;
+    sample_delay_ms = c.sample_delay_ms;
+    interval_ms = c.interval_ms;
+    ema_alpha = c.ema_alpha;
+    adc_ref = c.adc_ref;
+    calibration_factor = c.calibration_factor;
+    charge_status_pin = c.charge_status_pin;
+    sample_mode = c.sample_mode;
+    block_rate_hz = c.block_rate_hz;
+    block_samples = c.block_samples;
+    chemistry = c.chemistry;
+    capacity_mah = c.capacity_mah;
+    ADC_CAL_POINT p[ADC_CAL_MAX_POINTS];
+    uint8_t n = min(c.cal_count, ADC_CAL_MAX_POINTS);
+    for (uint8_t i = 0; i < n; i++)
+    {
+        p[i].raw = c.cal_raw[i];
+        p[i].mv = c.cal_mv[i];
+    }
+    _cal.setPOINTS(p, n);
+}
+
+// one getBytes at boot; anything invalid leaves the compiled-in defaults
+void BatteryMonitorClass::_loadCONFIG()
+{
+    uint8_t blob[BATT_CONFIG_HEADER + 255 + 4];
+    BATT_CONFIG_DATA c;
+    _packCONFIG(&c);
+    size_t n = _prefs.getBytes(PREF_CONFIG_KEY,blob,sizeof(blob));
+    if (n == 0)
+    {
+        return;
+    }
+    if (!battConfigDECODE(blob,n,&c))
+    {
+        Serial.println("BATTERY::CONFIG::stored settings invalid, using defaults");
+        return;
+    }
+    _unpackCONFIG(c);
+    _saved_crc = battConfigCRC(blob,n);
+}
+
+void BatteryMonitorClass::configCHANGED()
+{
+    // the setter's fields are visible before the flag that asks for their commit
+    std::atomic_thread_fence(std::memory_order_release);
+    _config_changed_ms = millis();
+    _config_dirty = true;
+}
+
+// writes only when the encoded blob differs from what is in flash. The console SAVE and the
+// idle commit on the monitor task both land here: _mutex keeps one pack/compare/write/_saved_crc
+// sequence from interleaving with the other, and keeps the calibration points still while packed
+bool BatteryMonitorClass::_commitCONFIG()
+{
+    if (!_mutex || xSemaphoreTake(_mutex,portMAX_DELAY)!=pdTRUE)
     {
         return false;
     }
-    if (xSemaphoreTake(_mutex,pdMS_TO_TICKS(50)) != pdTRUE)
+    // cleared before the fields are read: an edit that lands while they are packed sets it
+    // again and is committed next time, instead of being lost with a clear after the pack
+    _config_dirty = false;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    BATT_CONFIG_DATA c;
+    uint8_t blob[BATT_CONFIG_BLOB_SIZE];
+    _packCONFIG(&c);
+    size_t n = battConfigENCODE(c,blob);
+    uint32_t crc = battConfigCRC(blob,n);
+    bool written = false;
+    if (crc != _saved_crc)
+    {
+        if (_prefs.putBytes(PREF_CONFIG_KEY,blob,n) == n)
+        {
+            _saved_crc = crc;
+            written = true;
+        }
+        else
+        {
+            Serial.println("BATTERY::CONFIG::write failed");
+            configCHANGED();    // try again after the next quiet period
+        }
+    }
+    xSemaphoreGive(_mutex);
+    return written;
+}
+
+// <- default removed here; header should keep the default if you want one
+// lock-free copy of the last reading (batt_snapshot.h), safe from any task or core
+bool BatteryMonitorClass::getBatterySTATUS(float* outVoltage,int* outPercent,bool* outCharging)
+{
+    BATT_SNAPSHOT snap;
+    if (!_snapshot.read(&snap))
     {
         return false;
     }
-        /* code */
     if (outVoltage)
     {
-        *outVoltage = _ema_voltage;
+        *outVoltage = snap.voltage;
     }
     if (outPercent)
     {
-        *outPercent = _last_percentage;
+        *outPercent = snap.percent;
     }
-    if (outCharging && charge_status_pin >= 0)
+    // live pin state rather than the reading's, so a plug edge shows up at once
+    if (outCharging && _charge.valid())
     {
-        *outCharging = (digitalRead(charge_status_pin)==LOW);
+        *outCharging = _charge.charging();
     }
-    xSemaphoreGive(_mutex);
     return true;
 }
 
+bool BatteryMonitorClass::getSNAPSHOT(BATT_SNAPSHOT* out) const
+{
+    return _snapshot.read(out);
+}
+
+// the measured battery voltage becomes a pin-referred point, so a later divider change keeps it
 void BatteryMonitorClass::calibrateUsingMEASURED_Volt(float measuredVoltage)
 {
     float raw_adc = _sampleMedianRAW();
-    float measuredReport = _adcRawToBatteryVOLTAGE(raw_adc);
-    if (measuredReport <= 0.0f)
+    float divider = (r_top+r_bottom)/r_bottom;
+    if (raw_adc < 1.0f || !isfinite(divider) || divider <= 0.0f)
     {
         Serial.println("BATTERY MONITOR::Calibration read error");
         return;
     }
-    float  newFactor = measuredVoltage/measuredReport;
-    if (newFactor<=0.0f || !isfinite(newFactor))
+    float pin_mv = measuredVoltage*1000.0f/divider;
+    if (!isfinite(pin_mv) || pin_mv < 1.0f || pin_mv > 65535.0f)
     {
-        Serial.println("BATTERY MONITOR :: CALIBRATION:: Faild(invalid factor)");
+        Serial.println("BATTERY MONITOR :: CALIBRATION:: Faild(invalid voltage)");
         return;
     }
-    calibration_factor = newFactor;
-    _prefs.putFloat("calibration_factor",calibration_factor);
-    Serial.println(calibration_factor,6);
+    uint16_t raw = (uint16_t)(raw_adc + 0.5f);
+    uint8_t n = 0;
+    if (_mutex && xSemaphoreTake(_mutex,pdMS_TO_TICKS(50))==pdTRUE)
+    {
+        n = _cal.addPOINT(raw, (uint16_t)(pin_mv + 0.5f));
+        xSemaphoreGive(_mutex);
+    }
+    // the points replace the single legacy factor
+    calibration_factor = 1.0f;
+    _cal_stale = true;
+    configCHANGED();
+    Serial.printf("BATTERY:CALIBRATION:: raw %u = %u mV at the pin (eFuse base %u mV), %u point(s)\n",
+                  raw, (unsigned)(pin_mv + 0.5f), _cal.baseMV(raw), n);
+}
+void BatteryMonitorClass::clearCALIBRATION()
+{
+    if (_mutex && xSemaphoreTake(_mutex,pdMS_TO_TICKS(50))==pdTRUE)
+    {
+        _cal.clearPOINTS();
+        xSemaphoreGive(_mutex);
+    }
+    calibration_factor = 1.0f;
+    _cal_stale = true;
+    configCHANGED();
+}
+void BatteryMonitorClass::printCALIBRATION()
+{
+    Serial.printf("BATTERY:CALIBRATION:: base %s, %u point(s)\n", _cal.source(), _cal.pointCOUNT());
+    for (uint8_t i = 0; i < _cal.pointCOUNT(); i++)
+    {
+        const ADC_CAL_POINT& p = _cal.point(i);
+        Serial.printf("  raw %4u  pin %4u mV  base %4u mV  battery %5u mV\n",
+                      p.raw, p.mv, _cal.baseMV(p.raw), _cal.batteryMV(p.raw));
+    }
 }
 void BatteryMonitorClass::setDEVIDER(float top , float bottom)
 {
     r_top = top;
     r_bottom = bottom;
-    _prefs.putFloat("r_top",r_top);
-    _prefs.putFloat("r_bottom",r_bottom);
+    _cal_stale = true;
+    configCHANGED();
 }
 void BatteryMonitorClass::setNumberOfSAMPLES(uint8_t n)
 {
-    if (n<3)
+    if (n<MEDIAN_MIN_SAMPLES)
     {
-        n = 3;
+        n = MEDIAN_MIN_SAMPLES;
+    }
+    if (n>MEDIAN_MAX_SAMPLES)
+    {
+        n = MEDIAN_MAX_SAMPLES;
     }
     number_of_samples = n;
-    _prefs.putInt("num_samp",number_of_samples);
+    configCHANGED();
     
 }
 void BatteryMonitorClass::setINTERVAL(uint16_t ms)
@@ -165,7 +354,7 @@ void BatteryMonitorClass::setINTERVAL(uint16_t ms)
         ms = 100;
     }
     interval_ms = ms;
-    _prefs.putInt("interval_MS",interval_ms);
+    configCHANGED();
 }
 void BatteryMonitorClass::setemaALPHA(float alpha)
 {
@@ -174,12 +363,77 @@ void BatteryMonitorClass::setemaALPHA(float alpha)
         alpha = 0.01f;
     }
     ema_alpha = alpha;
-    _prefs.putFloat("ema_alpha",ema_alpha);
+    configCHANGED();
+}
+void BatteryMonitorClass::setSampleMODE(uint8_t mode)
+{
+    if (mode > BATT_SAMPLE_BLOCK)
+    {
+        Serial.println("BATTERY:MODE::0 = one-shot, 1 = block");
+        return;
+    }
+    sample_mode = mode;
+    configCHANGED();
+}
+void BatteryMonitorClass::setBLOCK(uint32_t rate_hz, uint16_t samples)
+{
+    if (rate_hz < 1000)
+    {
+        rate_hz = 1000;
+    }
+    if (samples < MEDIAN_MIN_SAMPLES)
+    {
+        samples = MEDIAN_MIN_SAMPLES;
+    }
+    if (samples > BATT_BLOCK_MAX)
+    {
+        samples = BATT_BLOCK_MAX;
+    }
+    block_rate_hz = rate_hz;
+    block_samples = samples;
+    configCHANGED();
+}
+void BatteryMonitorClass::setCHEMISTRY(uint8_t chem)
+{
+    if (chem >= SOC_CHEM_COUNT)
+    {
+        Serial.println("BATTERY:CHEM::0 = LiPo, 1 = LiFePO4");
+        return;
+    }
+    chemistry = chem;
+    configCHANGED();
+}
+void BatteryMonitorClass::setCAPACITY(uint16_t mah)
+{
+    if (mah < 10)
+    {
+        mah = 10;
+    }
+    capacity_mah = mah;
+    configCHANGED();
+}
+void BatteryMonitorClass::setLoadMA(float ma)
+{
+    _load_ma = ma;
+}
+void BatteryMonitorClass::setPolicyINTERVAL(uint16_t ms)
+{
+    _policy_interval_ms = ms;
+}
+uint16_t BatteryMonitorClass::_intervalMS()
+{
+    uint16_t ms = _policy_interval_ms;
+    return ms ? ms : interval_ms;
+}
+void BatteryMonitorClass::setSOURCE(AdcSourceClass* src)
+{
+    _source = src ? src : &_dma_source;
 }
 void BatteryMonitorClass::setAdcREF(float v)
 {
     adc_ref = v;
-    _prefs.putFloat("adc_ref",adc_ref);
+    _cal_stale = true;
+    configCHANGED();
 }
 void BatteryMonitorClass::printCONFIG()
 {
@@ -187,11 +441,15 @@ void BatteryMonitorClass::printCONFIG()
     Serial.printf("ADC pin : %d\n",pin_adc);
     Serial.printf("Divider : top =%0.0f ohm,\tbottom = %0.0f ohm\n",r_top,r_bottom);
     Serial.printf("Number of Samples : %d & Delay %d ms\n",number_of_samples,sample_delay_ms);
-    Serial.printf("Interval %d ms\n",interval_ms);
+    Serial.printf("Interval %d ms (policy %d ms)\n",interval_ms,_policy_interval_ms);
     Serial.printf("EMA ALPHA : %0.3f\n",ema_alpha);
     Serial.printf("ADC Refarance : %0.4f\n",adc_ref);
     Serial.printf("Calibration Factor %0.6f\n",calibration_factor);
+    Serial.printf("Calibration : %s base, %u point(s)\n",_cal.source(),_cal.pointCOUNT());
     Serial.printf("Charge Status pin : %u\n",charge_status_pin);
+    Serial.printf("Chemistry : %s, %u mAh\n",SocEstimatorClass::profile(chemistry).name,capacity_mah);
+    Serial.printf("Sample mode : %s\n",sample_mode==BATT_SAMPLE_BLOCK ? "BLOCK":"ONE-SHOT");
+    Serial.printf("Block : %u samples @ %u Hz\n",block_samples,block_rate_hz);
     Serial.println("------------------DONE-----------------");
 
 }
@@ -200,247 +458,410 @@ void BatteryMonitorClass::_taskFunctionSTATIC(void* p)
 {
     static_cast<BatteryMonitorClass*>(p)->_taskFUNC();
 }
+// one table load (adc_calibration.h); the float is only the interface to the filters
 float BatteryMonitorClass::_adcRawToBatteryVOLTAGE(float adcAvg)
 {
-    float v_adc = ((adcAvg/DEFAULT_ADC_MAX)*adc_ref);
-    float divider = ((r_top+r_bottom)/r_bottom);
-    float vbat = v_adc*calibration_factor*divider;
-    return vbat;
+    uint16_t raw = adcAvg <= 0.0f ? 0 : (uint16_t)(adcAvg + 0.5f);
+    return _cal.batteryMV(raw) * 0.001f;
+}
+
+// task side: re-characterise on a pin change, then fold divider and factor into the table
+void BatteryMonitorClass::_rebuildCAL()
+{
+    _cal_stale = false;
+    if (_cal_pin != pin_adc)
+    {
+        _cal_pin = pin_adc;
+        _cal.begin(pin_adc);
+    }
+    _cal.setLinearREF(adc_ref);
+    float divider = (r_top+r_bottom)/r_bottom;
+    if (_mutex && xSemaphoreTake(_mutex,portMAX_DELAY)==pdTRUE)
+    {
+        _cal.build(divider, calibration_factor);
+        xSemaphoreGive(_mutex);
+    }
 }
 void BatteryMonitorClass::_taskFUNC()
 {
     vTaskDelay(pdMS_TO_TICKS(200));
 
     {
-        float raw = _sampleMedianRAW();
+        float raw;
+        if (sample_mode == BATT_SAMPLE_BLOCK && !_readBLOCK(&raw))
+        {
+            Serial.println("BATTERY::BLOCK::read failed, back to one-shot sampling");
+            sample_mode = BATT_SAMPLE_ONESHOT;
+        }
+        if (sample_mode != BATT_SAMPLE_BLOCK)
+        {
+            // the scheduler fills the window back to back at sample_delay_ms
+            _syncCHANNEL();
+            while (!_readCHANNEL(&raw))
+            {
+                vTaskDelay(pdMS_TO_TICKS(max(sample_delay_ms, (uint16_t)10)));
+            }
+        }
         float v = _adcRawToBatteryVOLTAGE(raw);
+        bool charging = _chargingNOW();
         _ema_voltage = v;
-        _last_percentage = _voltageToPERCENTAGE(v);
+        _publish(_updateSOC(v, charging, true), charging);
     }
+    // one reading per interval: the scheduler's running median (one-shot) or a fresh block
     for (;;)
     {
-        float raw = _sampleMedianRAW();
-        float v = _adcRawToBatteryVOLTAGE(raw);
-        int pct = _voltageToPERCENTAGE(v);
+        if (_config_dirty && millis() - _config_changed_ms >= CONFIG_COMMIT_IDLE_MS)
+        {
+            _commitCONFIG();
+        }
+        if (_cal_stale || _cal_pin != pin_adc)
+        {
+            _rebuildCAL();
+        }
+        if (_charge.pin() != charge_status_pin)
+        {
+            _charge.begin(charge_status_pin);
+        }
+        _syncCHANNEL();
+        idlemgr.sleepALIGNED(_intervalMS());
 
-        _ema_voltage = (ema_alpha*v)+((1.0f-ema_alpha)*_ema_voltage);
-        if(_mutex)
+        float raw;
+        if (sample_mode == BATT_SAMPLE_BLOCK)
         {
-            if (xSemaphoreTake(_mutex,pdMS_TO_TICKS(50))==pdTRUE)
+            // the source is stopped again before we sleep
+            if (!_readBLOCK(&raw))
             {
-                _last_percentage = pct;
-                xSemaphoreGive(_mutex);
+                Serial.println("BATTERY::BLOCK::read failed, back to one-shot sampling");
+                sample_mode = BATT_SAMPLE_ONESHOT;
+                continue;
             }
-            
         }
-        Serial.print("BATTERY MONITOR :: Raw Voltage = ");
-        Serial.print(v,3);
-        Serial.print(" EMA = ");
-        Serial.print(_ema_voltage,3);// why 3??
-        Serial.print("Voltage pct = ");
-        Serial.print(pct);
-        if (charge_status_pin >= 0)
+        else if (!_readCHANNEL(&raw))
         {
-            Serial.print(digitalRead(charge_status_pin)==LOW ? "YES":"NO");
+            continue;
         }
-        Serial.println();
-        vTaskDelay(pdMS_TO_TICKS(interval_ms));
+
+        float v = _adcRawToBatteryVOLTAGE(raw);
+        bool charging = _chargingNOW();
+        int pct = _updateSOC(v, charging, false);
+
+        _ema_voltage = (ema_alpha*v)+((1.0f-ema_alpha)*_ema_voltage);
+        _publish(pct, charging);
+        // one 16-byte record instead of formatted UART prints; TELEMETRY ON streams it
+        telemetry.emit(TELEM_BATTERY, (uint8_t)(constrain(pct,0,100) | (charging ? 0x80 : 0)),
+                       (uint32_t)(v*1000.0f), (uint32_t)(_ema_voltage*1000.0f));
     }   
 }
 
-float BatteryMonitorClass:: _sampleMedianRAW()
+bool BatteryMonitorClass::_chargingNOW()
 {
-    uint8_t n = number_of_samples;
-    if (n<3)
+    return _charge.charging();
+}
+
+void BatteryMonitorClass::_publish(int pct, bool charging)
+{
+    BATT_SNAPSHOT snap;
+    snap.voltage = _ema_voltage;
+    snap.percent = (int16_t)pct;
+    snap.charging = charging;
+    snap.time_ms = millis();
+    _snapshot.publish(snap);
+}
+
+// ms between two channel samples: the window is spread over about one interval, never faster than sample_delay_ms
+uint16_t BatteryMonitorClass::_samplePERIOD()
+{
+    uint8_t n = max(number_of_samples, MEDIAN_MIN_SAMPLES);
+    uint32_t ms = max((uint32_t)sample_delay_ms, (uint32_t)_intervalMS() / n);
+    return (uint16_t)idlePERIOD(ms);       // whole idle slots, so samples share wake-ups
+}
+
+// push console / policy edits to the scheduler channel; pin and window changes refill it
+void BatteryMonitorClass::_syncCHANNEL()
+{
+    if (_adc_ch == ADC_SCHED_NONE)
     {
-        n = 3;
+        return;
     }
-    std::vector<int>v;
-    v.reserve(n);
-    for (size_t i = 0; i < n; i++)
+    if (_ch_pin != pin_adc || _ch_window != number_of_samples || _ch_fill_ms != sample_delay_ms)
     {
-        int a = analogRead(pin_adc);
-        v.push_back(a);
-        vTaskDelay(pdMS_TO_TICKS(sample_delay_ms));
+        _ch_pin = pin_adc;
+        _ch_window = number_of_samples;
+        _ch_fill_ms = sample_delay_ms;
+        adc.configure(_adc_ch, _ch_pin, _ch_window, _ch_fill_ms);
     }
+    uint16_t period = _samplePERIOD();
+    if (_ch_period_ms != period)
+    {
+        _ch_period_ms = period;
+        adc.setPERIOD(_adc_ch, period);
+    }
+    // block mode reads the pin itself, the channel would only cost wakeups
+    bool on = sample_mode != BATT_SAMPLE_BLOCK;
+    if (_ch_enabled != on)
+    {
+        _ch_enabled = on;
+        adc.setENABLED(_adc_ch, on);
+    }
+}
 
-    std::sort(v.begin(),v.end());
-    uint8_t mid = n/2;
-    uint8_t start = max(0,mid-1);
-    uint8_t end = min(n-1,mid+1);
-    long sum = 0;
-    for(int i = start;i<=end;i++)
+bool BatteryMonitorClass::_readCHANNEL(float* raw)
+{
+    ADC_CHANNEL_VALUE v;
+    if (_adc_ch == ADC_SCHED_NONE || !adc.read(_adc_ch, &v))
     {
-        sum+= v[i];
+        return false;
     }
-    float avg = (float)sum/(float)(end-start+1);
-    return avg;    
+    *raw = v.raw;
+    return true;
 }
 
-uint8_t BatteryMonitorClass:: _voltageToPERCENTAGE(float v)
+// one source block, filtered in a single pass (adcBlockFILTER)
+bool BatteryMonitorClass::_readBLOCK(float* raw)
 {
-    const float table[VOLTS_TABLE_SIZE] ={
-        4.2,4.05,3.92,3.86,3.80,3.75,3.70,3.65,3.60,3.55,3.30
-    };
-    const int ptab[VOLTS_TABLE_SIZE] = {
-        100,90,80,70,60,50,40,30,20,10,0
-    };
-    if (v>=table[0])
+    uint16_t n = min(block_samples, BATT_BLOCK_MAX);
+    if (!_source || block_rate_hz == 0)
     {
-        return 100;
+        return false;
     }
-    if (v<=table[VOLTS_TABLE_SIZE-1])
+    // the converter is ours until stop(); the scheduler's one-shot channels wait
+    uint32_t timeout_ms = (uint32_t)n * 1000u / block_rate_hz + 50;
+    if (!adc.lockADC(timeout_ms))
     {
-        return 0;
+        return false;
     }
-    for (uint8_t i = 0; i < VOLTS_TABLE_SIZE-1; i++)
+    size_t got = 0;
+    if (_source->start(pin_adc, block_rate_hz))
     {
-        if (v<=table[i]&& v>= table[i+1])
-        {
-            float v1 = table[i];
-            float v2 = table[i+1];
-            uint8_t p1 = ptab[i];
-            uint8_t p2 = ptab[i+1];
-            float frac = (v-v2)/(v1-v2);
-            uint8_t pct = round(p2+frac*(p1-p2));
-            return pct;
-        }
+        got = _source->read(_block, n, timeout_ms);
+        _source->stop();
     }
-    return 0;
+    adc.unlockADC();
+    if (got == 0)
+    {
+        return false;
+    }
+    *raw = adcBlockFILTER(_block, got);
+    if (_mutex && xSemaphoreTake(_mutex,pdMS_TO_TICKS(50))==pdTRUE)
+    {
+        _block_raw = *raw;
+        xSemaphoreGive(_mutex);
+    }
+    return true;
 }
 
-void BatteryMonitorClass:: processSerialLINE(String &is)
+// latest filtered raw value: channel median (one-shot) or last block (block mode); no ADC access
+float BatteryMonitorClass:: _sampleMedianRAW()
 {
-    is.trim();
-    is.toUpperCase();
-    if (is.length()==0)
+    float avg = 0.0f;
+    if (sample_mode != BATT_SAMPLE_BLOCK)
     {
-        return;
+        _readCHANNEL(&avg);
+        return avg;
     }
-    if (is=="HELP")
+    if (_mutex && xSemaphoreTake(_mutex,pdMS_TO_TICKS(50))==pdTRUE)
     {
-        printHELP();
-        return;   
+        avg = _block_raw;
+        xSemaphoreGive(_mutex);
     }
-    if (is == "GET")
+    return avg;    
+}
+
+// model-based percentage (soc_estimator.h); settings changed from the console are picked up here
+int BatteryMonitorClass::_updateSOC(float v, bool charging, bool first)
+{
+    if (_soc.chemistry() != chemistry)
     {
-        float raw_V;
-        int bat_percent;
-        bool charge_indecitor;
-        getBatterySTATUS(&raw_V,&bat_percent,&charge_indecitor);
-        Serial.printf("BATTERY MONITOR :: Voltage :%0.3f\t BATTERY PERCENTAGE :%i\nCharging : %s",raw_V,bat_percent,charge_indecitor? "\tYES":"\tNO");
+        _soc.setPROFILE(chemistry);
     }
-    if (is=="CFG")
+    _soc.setCAPACITY(capacity_mah);
+    uint32_t now = millis();
+    uint16_t mv = (uint16_t)(v*1000.0f);
+    if (first)
     {
-        printCONFIG();
-        return;
-    }
-    
-    std::vector<String> tokens;
-    int idx = 0;
-    while (idx<is.length())
-    {
-        int sp = is.indexOf(' ',idx);
-        if (sp == -1) {
-            tokens.push_back(is.substring(idx)); // rest of string
-            break;
-        } else {
-            tokens.push_back(is.substring(idx, sp));
-            idx = sp + 1;
-        }
-    }
-    if (tokens.size()==0)
-    {return;
+        _soc.reset(mv, charging ? 0.0f : _load_ma);
     }
-    if (tokens[0]=="CAL"&&tokens.size()>=2)
+    else
     {
-        float m =tokens[1].toFloat();
-        if (m>0)
-        {
-            calibrateUsingMEASURED_Volt(m);
-        }
-        else
-        {
-            Serial.println("BATTERY:CALIBRATION::Argument Invalid");
-        }
-        return;
+        _soc.update(mv, charging, _load_ma, now - _soc_last_ms);
     }
+    _soc_last_ms = now;
+    return _soc.percent();
+}
 
-    if (tokens[0]=="SET")
+// ----------------- console commands -----------------
+static void cmd_CFG(void* ctx, const CmdArgs& args)
+{
+    (void)args;
+    static_cast<BatteryMonitorClass*>(ctx)->printCONFIG();
+}
+static void cmd_GET(void* ctx, const CmdArgs& args)
+{
+    (void)args;
+    float raw_V = 0.0f;
+    int bat_percent = 0;
+    bool charge_indecitor = false;
+    if (!static_cast<BatteryMonitorClass*>(ctx)->getBatterySTATUS(&raw_V,&bat_percent,&charge_indecitor))
     {
-        String field = tokens[1];
-        String val = tokens[2];
-        if (field=="PIN")
-        {
-            pin_adc = val.toInt();
-        }
-        else if (field =="RTOP")
-        {
-            setDEVIDER(val.toFloat(),r_bottom);
-        }
-        else if (field == "RBOTTOM")
-        {
-            setDEVIDER(r_top,val.toFloat());
-        }
-        else if (field == "NUMSAMP")
-        {
-            setNumberOfSAMPLES(val.toInt());
-        }
-        else if (field == "DELAY")
-        {
-            sample_delay_ms = val.toInt();
-        }
-        else if (field=="INTERVAL")
-        {
-            setINTERVAL(val.toInt());
-            return;
-        }
-        else if (field == "ALPHA")
-        {
-            setemaALPHA(val.toFloat());
-        }
-        else if (field=="ADCREF")
-        {
-            setAdcREF(val.toFloat());
-        }
-        else if (field=="CHARGEINDICATOR")
-        {
-            charge_status_pin = val.toInt();
-        }
-        else
-        {
-            Serial.println("UNKNOWN SET FIELD");
-        }
+        Serial.println("BATTERY MONITOR :: no reading yet");
         return;
     }
-    else if (tokens[0]=="SAVE")
+    Serial.printf("BATTERY MONITOR :: Voltage :%0.3f\t BATTERY PERCENTAGE :%i\nCharging : %s\n",raw_V,bat_percent,charge_indecitor? "\tYES":"\tNO");
+}
+static void cmd_CAL(void* ctx, const CmdArgs& args)
+{
+    float m;
+    if (!args.toFLOAT(0,&m) || m<=0)
     {
-        saveSETTINGS();
+        Serial.println("BATTERY:CALIBRATION::Argument Invalid");
         return;
     }
-    else
+    static_cast<BatteryMonitorClass*>(ctx)->calibrateUsingMEASURED_Volt(m);
+}
+static void cmd_CAL_CLEAR(void* ctx, const CmdArgs& args)
+{
+    (void)args;
+    static_cast<BatteryMonitorClass*>(ctx)->clearCALIBRATION();
+    Serial.println("BATTERY:CALIBRATION:: points cleared, eFuse curve only");
+}
+static void cmd_CAL_LIST(void* ctx, const CmdArgs& args)
+{
+    (void)args;
+    static_cast<BatteryMonitorClass*>(ctx)->printCALIBRATION();
+}
+static void cmd_SAVE(void* ctx, const CmdArgs& args)
+{
+    (void)args;
+    static_cast<BatteryMonitorClass*>(ctx)->saveSETTINGS();
+}
+
+// SET <field> <value>: every field takes one number
+static bool set_INT(const CmdArgs& args, long* v)
+{
+    if (!args.toINT(0,v))
     {
-        Serial.println("UNKNOWN -- COMMAND use:HELP");
+        Serial.printf("BATTERY:SET::'%s' is not a number\n",args.str(0));
+        return false;
     }
+    return true;
 }
-
-void BatteryMonitorClass:: printHELP()
+static bool set_FLOAT(const CmdArgs& args, float* v)
+{
+    if (!args.toFLOAT(0,v))
+    {
+        Serial.printf("BATTERY:SET::'%s' is not a number\n",args.str(0));
+        return false;
+    }
+    return true;
+}
+static void set_PIN(void* ctx, const CmdArgs& args)
+{
+    long v;
+    if (!set_INT(args,&v)) return;
+    BatteryMonitorClass* b = static_cast<BatteryMonitorClass*>(ctx);
+    b->pin_adc = v;
+    b->configCHANGED();
+}
+static void set_RTOP(void* ctx, const CmdArgs& args)
+{
+    BatteryMonitorClass* b = static_cast<BatteryMonitorClass*>(ctx);
+    float v;
+    if (set_FLOAT(args,&v)) b->setDEVIDER(v,b->r_bottom);
+}
+static void set_RBOTTOM(void* ctx, const CmdArgs& args)
+{
+    BatteryMonitorClass* b = static_cast<BatteryMonitorClass*>(ctx);
+    float v;
+    if (set_FLOAT(args,&v)) b->setDEVIDER(b->r_top,v);
+}
+static void set_NUMSAMP(void* ctx, const CmdArgs& args)
+{
+    long v;
+    if (set_INT(args,&v)) static_cast<BatteryMonitorClass*>(ctx)->setNumberOfSAMPLES(constrain(v,0,255));
+}
+static void set_DELAY(void* ctx, const CmdArgs& args)
+{
+    long v;
+    if (!set_INT(args,&v)) return;
+    BatteryMonitorClass* b = static_cast<BatteryMonitorClass*>(ctx);
+    b->sample_delay_ms = constrain(v,0,65535);
+    b->configCHANGED();
+}
+static void set_INTERVAL(void* ctx, const CmdArgs& args)
+{
+    long v;
+    if (set_INT(args,&v)) static_cast<BatteryMonitorClass*>(ctx)->setINTERVAL(constrain(v,0,65535));
+}
+static void set_ALPHA(void* ctx, const CmdArgs& args)
+{
+    float v;
+    if (set_FLOAT(args,&v)) static_cast<BatteryMonitorClass*>(ctx)->setemaALPHA(v);
+}
+static void set_ADCREF(void* ctx, const CmdArgs& args)
 {
-    Serial.println(F("BATMON COMMAND: "));
-    Serial.println(F("HELP  --------    Show all commands"));
-    Serial.println(F("CFG   --------    Print current configuration"));
-    Serial.println(F("GET   --------    Print current battery state"));
-    Serial.println(F("CAL<voltage>     -Calibrate using measured battery voltage"));
-    Serial.println(F("SET PIN <n>      -set ADC pin"));
-    Serial.println(F("SET RTOP <ohm>       - set top resistor"));
-    Serial.println(F("SET RBOT <ohm>       - set bottom resistor"));
-    Serial.println(F("SET SAMP <n>         - set sample window count"));
-    Serial.println(F("SET DELAY <ms>       - set ms between raw samples"));
-    Serial.println(F("SET INTERVAL <ms>         - set monitor interval"));
-    Serial.println(F("SET ALPHA <0..1>     - set EMA alpha"));
-    Serial.println(F("SET ADCREF <v>       - set ADC ref voltage (nominal)"));
-    Serial.println(F("SET CHARGEINDICATOR <pin>    - set optional TP4056 STAT pin (use -1 to disable)"));
-    Serial.println(F("SAVE                 - persist settings to flash"));
-        
+    float v;
+    if (set_FLOAT(args,&v)) static_cast<BatteryMonitorClass*>(ctx)->setAdcREF(v);
+}
+static void set_MODE(void* ctx, const CmdArgs& args)
+{
+    long v;
+    if (set_INT(args,&v)) static_cast<BatteryMonitorClass*>(ctx)->setSampleMODE(constrain(v,0,255));
+}
+static void set_RATE(void* ctx, const CmdArgs& args)
+{
+    BatteryMonitorClass* b = static_cast<BatteryMonitorClass*>(ctx);
+    long v;
+    if (set_INT(args,&v)) b->setBLOCK(max(v,0L),b->block_samples);
+}
+static void set_BLOCK(void* ctx, const CmdArgs& args)
+{
+    BatteryMonitorClass* b = static_cast<BatteryMonitorClass*>(ctx);
+    long v;
+    if (set_INT(args,&v)) b->setBLOCK(b->block_rate_hz,constrain(v,0,65535));
+}
+static void set_CHEM(void* ctx, const CmdArgs& args)
+{
+    long v;
+    if (set_INT(args,&v)) static_cast<BatteryMonitorClass*>(ctx)->setCHEMISTRY(constrain(v,0,255));
+}
+static void set_CAPACITY(void* ctx, const CmdArgs& args)
+{
+    long v;
+    if (set_INT(args,&v)) static_cast<BatteryMonitorClass*>(ctx)->setCAPACITY(constrain(v,0,65535));
+}
+static void set_CHARGEINDICATOR(void* ctx, const CmdArgs& args)
+{
+    long v;
+    if (!set_INT(args,&v)) return;
+    BatteryMonitorClass* b = static_cast<BatteryMonitorClass*>(ctx);
+    b->charge_status_pin = v;
+    b->configCHANGED();
 }
 
+static constexpr CONSOLE_CMD BATTERY_COMMANDS[] = {
+    {"CFG",  nullptr,           0, cmd_CFG,     "- print current configuration"},
+    {"GET",  nullptr,           0, cmd_GET,     "- print current battery state"},
+    {"CAL",  nullptr,           1, cmd_CAL,     "<voltage>  - add a calibration point from a measured battery voltage"},
+    {"CAL",  "LIST",            0, cmd_CAL_LIST,"- calibration points against the eFuse curve"},
+    {"CAL",  "CLEAR",           0, cmd_CAL_CLEAR,"- drop all calibration points"},
+    {"SET",  "PIN",             1, set_PIN,     "<n>  - set ADC pin"},
+    {"SET",  "RTOP",            1, set_RTOP,    "<ohm>  - set top resistor"},
+    {"SET",  "RBOTTOM",         1, set_RBOTTOM, "<ohm>  - set bottom resistor"},
+    {"SET",  "NUMSAMP",         1, set_NUMSAMP, "<n>  - set sample window count"},
+    {"SET",  "DELAY",           1, set_DELAY,   "<ms>  - set min ms between raw samples"},
+    {"SET",  "INTERVAL",        1, set_INTERVAL,"<ms>  - set monitor interval"},
+    {"SET",  "ALPHA",           1, set_ALPHA,   "<0..1>  - set EMA alpha"},
+    {"SET",  "ADCREF",          1, set_ADCREF,  "<v>  - set ADC ref voltage (nominal)"},
+    {"SET",  "MODE",            1, set_MODE,    "<0|1>  - sampling: 0 one-shot median, 1 DMA block"},
+    {"SET",  "RATE",            1, set_RATE,    "<hz>  - block sample rate"},
+    {"SET",  "BLOCK",           1, set_BLOCK,   "<n>  - samples per block (max 512)"},
+    {"SET",  "CHEM",            1, set_CHEM,    "<0|1>  - cell chemistry: 0 LiPo, 1 LiFePO4"},
+    {"SET",  "CAPACITY",        1, set_CAPACITY,"<mAh>  - cell capacity for the SoC model"},
+    {"SET",  "CHARGEINDICATOR", 1, set_CHARGEINDICATOR, "<pin>  - set optional TP4056 STAT pin (use -1 to disable)"},
+    {"SAVE", nullptr,           0, cmd_SAVE,    "- persist settings to flash"},
+};
+
+void BatteryMonitorClass::registerCOMMANDS(SerialConsoleClass& console)
+{
+    console.addTABLE(BATTERY_COMMANDS, this, "BATMON");
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <stdint.h>
+#include "seq_latch.h"
+
+// Latest battery reading, published by the monitor task and read from any task or core
+// through a SeqLatch (seq_latch.h), so a reader never waits on a half-written reading.
+
+typedef struct BATT_SNAPSHOT {
+    float    voltage;               // EMA-filtered battery volts
+    int16_t  percent;
+    bool     charging;              // charge-status pin as sampled with this reading
+    uint32_t time_ms;               // millis() when the reading was taken
+} BATT_SNAPSHOT;
+
+typedef SeqLatch<BATT_SNAPSHOT> BattSnapshotClass;
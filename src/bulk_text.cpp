@@ -0,0 +1,119 @@
+// bulk_text.cpp
+#include "bulk_text.h"
+#include "ascii_hid.h"
+#include <string.h>
+
+const uint8_t BULK_LEFT_SHIFT = 0x02;     // boot-report modifier bit
+
+BulkTextClass::BulkTextClass()
+    :   _head(0),
+        _count(0),
+        _pack(BULK_PACK_MAX),
+        _down(false),
+        _chars(0),
+        _first_ms(0),
+        _last_ms(0)
+{
+    memset(&_prev, 0, sizeof(_prev));
+}
+
+void BulkTextClass::setPACK(uint8_t max_keys)
+{
+    _pack = (max_keys < 1) ? 1 : (max_keys > BULK_PACK_MAX ? BULK_PACK_MAX : max_keys);
+}
+
+void BulkTextClass::push(char c)
+{
+    if (!asciiToHID(c) || _count >= BULK_LOOKAHEAD)
+    {
+        return;
+    }
+    _ring[(_head + _count) & (BULK_LOOKAHEAD - 1)] = c;
+    _count++;
+}
+
+void BulkTextClass::clear()
+{
+    _head = 0;
+    _count = 0;
+    _down = false;
+    memset(&_prev, 0, sizeof(_prev));
+}
+
+bool BulkTextClass::_inPREV(uint8_t usage) const
+{
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        if (_prev.keys[i] == usage) return true;
+    }
+    return false;
+}
+
+bool BulkTextClass::nextREPORT(KB_REPORT* out, uint32_t now_ms)
+{
+    if (_count == 0)
+    {
+        if (!_down)
+        {
+            return false;
+        }
+        // stream ran dry: let go of everything
+        memset(&_prev, 0, sizeof(_prev));
+        _down = false;
+        *out = _prev;
+        return true;
+    }
+
+    uint8_t h = asciiToHID(_ring[_head]);
+    if (_down && _inPREV(h & ASCII_HID_USAGE))
+    {
+        // same key again: it has to go up before it can go down
+        memset(&_prev, 0, sizeof(_prev));
+        _down = false;
+        *out = _prev;
+        return true;
+    }
+
+    KB_REPORT r;
+    memset(&r, 0, sizeof(r));
+    r.mods = (h & ASCII_HID_SHIFT) ? BULK_LEFT_SHIFT : 0;
+    uint8_t n = 0;
+    while (_count && n < _pack)
+    {
+        h = asciiToHID(_ring[_head]);
+        const uint8_t u = h & ASCII_HID_USAGE;
+        if (((h & ASCII_HID_SHIFT) ? BULK_LEFT_SHIFT : 0) != r.mods) break;
+        if (_down && _inPREV(u)) break;
+        bool dup = false;
+        for (uint8_t i = 0; i < n; i++)
+        {
+            if (r.keys[i] == u) { dup = true; break; }
+        }
+        if (dup) break;
+
+        r.keys[n++] = u;
+        _head = (_head + 1) & (BULK_LOOKAHEAD - 1);
+        _count--;
+    }
+
+    if (!_chars)
+    {
+        _first_ms = now_ms;
+    }
+    _chars += n;
+    _last_ms = now_ms;
+    _prev = r;
+    _down = true;
+    *out = r;
+    return true;
+}
+
+uint32_t BulkTextClass::charsPerSEC() const
+{
+    uint32_t span = _last_ms - _first_ms;
+    if (!span)
+    {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)_chars * 1000u / span);
+}
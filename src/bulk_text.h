@@ -0,0 +1,42 @@
+#pragma once
+#include <stdint.h>
+#include "kb_event.h"
+
+// Turns a character stream into packed boot reports for bulk injection.
+//
+// A report carries a run of up to `pack` characters that share one Shift state, use distinct
+// keys and share no key with the report before it; in that case the previous keys are released
+// and the new ones pressed by the same report, so a run costs one notification instead of two
+// per character. An all-up report is only inserted when the next character reuses a key that
+// is still down, or when the stream runs dry. Pure logic; the caller paces the reports.
+
+const uint8_t BULK_LOOKAHEAD = 32;        // power of two
+const uint8_t BULK_PACK_MAX  = 6;
+
+class BulkTextClass {
+public:
+    BulkTextClass();
+    void     setPACK(uint8_t max_keys);          // 1 disables packing
+    uint8_t  space() const { return BULK_LOOKAHEAD - _count; }
+    void     push(char c);                       // characters without a key are dropped here
+    void     clear();
+    bool     idle() const { return _count == 0 && !_down; }
+    bool     nextREPORT(KB_REPORT* out, uint32_t now_ms);   // false when nothing is due
+
+    void     resetSTATS() { _chars = 0; _first_ms = 0; _last_ms = 0; }
+    uint32_t charsSENT() const { return _chars; }
+    uint32_t charsPerSEC() const;
+private:
+    char      _ring[BULK_LOOKAHEAD];
+    uint8_t   _head;
+    uint8_t   _count;
+    uint8_t   _pack;
+    KB_REPORT _prev;
+    bool      _down;
+
+    uint32_t  _chars;
+    uint32_t  _first_ms;
+    uint32_t  _last_ms;
+
+    bool _inPREV(uint8_t usage) const;
+};
@@ -0,0 +1,109 @@
+// charge_status.cpp
+#include "charge_status.h"
+
+ChargeStatusClass::ChargeStatusClass()
+    :   _state(0),
+        _edges(0),
+        _pin(CHARGE_PIN_NONE),
+        _timer(NULL),
+        _listener_count(0)
+{
+}
+
+bool ChargeStatusClass::begin(uint8_t pin, uint16_t glitch_ms)
+{
+    if (_pin != CHARGE_PIN_NONE)
+    {
+        detachInterrupt(_pin);
+    }
+    _pin = pin;
+    if (_pin == CHARGE_PIN_NONE)
+    {
+        _change.publish(CHARGE_CHANGE{0, 0});
+        _state.store(0, std::memory_order_release);
+        return true;
+    }
+    TickType_t period = pdMS_TO_TICKS(glitch_ms);
+    if (!period) period = 1;
+    if (!_timer)
+    {
+        _timer = xTimerCreate("CHARGE_GLITCH", period, pdFALSE, this, _onSETTLED);
+        if (!_timer)
+        {
+            Serial.println("BATTERY::CHARGE::timer creation failed");
+            _pin = CHARGE_PIN_NONE;
+            return false;
+        }
+    }
+    else
+    {
+        xTimerChangePeriod(_timer, period, 0);
+        xTimerStop(_timer, 0);
+    }
+    pinMode(_pin, INPUT_PULLUP);
+    _sample(false);
+    attachInterruptArg(_pin, _onEDGE, this, CHANGE);
+    return true;
+}
+
+bool ChargeStatusClass::addLISTENER(TaskHandle_t task)
+{
+    if (!task || _listener_count >= CHARGE_MAX_LISTENERS)
+    {
+        return false;
+    }
+    _listeners[_listener_count++] = task;
+    return true;
+}
+
+bool ChargeStatusClass::lastCHANGE(bool* charging, uint32_t* at_ms) const
+{
+    CHARGE_CHANGE c = {0, 0};
+    _change.read(&c);
+    if (charging) *charging = c.state & CHARGE_STATE_CHARGING;
+    if (at_ms) *at_ms = c.at_ms;
+    return c.state & CHARGE_STATE_VALID;
+}
+
+// ISR: no pin read here, a bouncing contact would only be sampled mid-bounce
+void IRAM_ATTR ChargeStatusClass::_onEDGE(void* arg)
+{
+    ChargeStatusClass* self = static_cast<ChargeStatusClass*>(arg);
+    self->_edges = self->_edges + 1;
+    BaseType_t woken = pdFALSE;
+    xTimerResetFromISR(self->_timer, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+// timer service task: the pin has been quiet for the glitch window
+void ChargeStatusClass::_onSETTLED(TimerHandle_t t)
+{
+    static_cast<ChargeStatusClass*>(pvTimerGetTimerID(t))->_sample(true);
+}
+
+void ChargeStatusClass::_sample(bool notify)
+{
+    if (_pin == CHARGE_PIN_NONE)
+    {
+        return;
+    }
+    const bool charging = digitalRead(_pin) == LOW;
+    const uint32_t old = _state.load(std::memory_order_relaxed);
+    if ((old & CHARGE_STATE_VALID) && ((old & CHARGE_STATE_CHARGING) != 0) == charging)
+    {
+        return;     // a glitch that settled back to the same level
+    }
+    const uint32_t count = ((old & CHARGE_STATE_COUNT_MASK) + 1) & CHARGE_STATE_COUNT_MASK;
+    // single writer (this timer or begin()); the transition is latched before the state word
+    const uint32_t state = CHARGE_STATE_VALID | (charging ? CHARGE_STATE_CHARGING : 0) | count;
+    _change.publish(CHARGE_CHANGE{state, (uint32_t)millis()});
+    _state.store(state, std::memory_order_release);
+    if (!notify)
+    {
+        return;
+    }
+    for (uint8_t i = 0; i < _listener_count; i++)
+    {
+        xTaskNotifyGive(_listeners[i]);
+    }
+}
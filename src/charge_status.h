@@ -0,0 +1,56 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+#include "seq_latch.h"
+
+// Charger STAT pin (TP4056 CHRG, open drain, low while charging) tracked by interrupt.
+//
+// Every edge restarts a one-shot FreeRTOS timer from the ISR; only when the pin has been
+// quiet for the glitch window does the timer callback sample it and, on a real change, update
+// the state word and wake the listener tasks with a notification. Readers do one atomic load.
+// The state word packs the level with a transition count; each transition is also published
+// with its timestamp through a SeqLatch (seq_latch.h) before the state word, so a reader that
+// also wants the time gets a matching pair.
+
+const uint8_t  CHARGE_PIN_NONE          = 0xFF;     // charge_status_pin value for "no STAT pin"
+const uint16_t CHARGE_GLITCH_MS         = 20;
+const uint8_t  CHARGE_MAX_LISTENERS     = 4;
+
+const uint32_t CHARGE_STATE_VALID       = 1u << 31; // a pin is configured and was sampled
+const uint32_t CHARGE_STATE_CHARGING    = 1u << 30;
+const uint32_t CHARGE_STATE_COUNT_MASK  = CHARGE_STATE_CHARGING - 1;   // transitions so far
+
+typedef struct CHARGE_CHANGE {
+    uint32_t state;                                 // state word after the transition
+    uint32_t at_ms;
+} CHARGE_CHANGE;
+
+class ChargeStatusClass {
+public:
+    ChargeStatusClass();
+    bool begin(uint8_t pin, uint16_t glitch_ms = CHARGE_GLITCH_MS);   // CHARGE_PIN_NONE detaches
+    uint8_t pin() const { return _pin; }
+    bool addLISTENER(TaskHandle_t task);            // gets xTaskNotifyGive() on every transition
+
+    uint32_t state() const { return _state.load(std::memory_order_acquire); }
+    bool valid() const { return state() & CHARGE_STATE_VALID; }
+    bool charging() const { return state() & CHARGE_STATE_CHARGING; }
+    uint32_t transitions() const { return state() & CHARGE_STATE_COUNT_MASK; }
+    bool lastCHANGE(bool* charging, uint32_t* at_ms) const;    // consistent pair, false without a pin
+    uint32_t edges() const { return _edges; }                  // raw edges, glitches included
+private:
+    std::atomic<uint32_t> _state;
+    SeqLatch<CHARGE_CHANGE> _change;                // last transition, single writer as _state
+    volatile uint32_t _edges;
+    uint8_t       _pin;
+    TimerHandle_t _timer;
+    TaskHandle_t  _listeners[CHARGE_MAX_LISTENERS];
+    uint8_t       _listener_count;
+
+    static void IRAM_ATTR _onEDGE(void* arg);
+    static void _onSETTLED(TimerHandle_t t);
+    void _sample(bool notify);
+};
@@ -0,0 +1,182 @@
+// dashboard.cpp
+#include "dashboard.h"
+#include <Wire.h>
+#include "serial_console.h"
+#include "task_CP.h"
+#include "idle_manager.h"
+
+// horizontal addressing, so a column window on one page is filled left to right
+static const uint8_t SSD1306_INIT[] = {
+    0xAE,               // display off
+    0xD5, 0x80,         // clock divide
+    0xA8, 0x3F,         // multiplex 64
+    0xD3, 0x00,         // no offset
+    0x40,               // start line 0
+    0x8D, 0x14,         // charge pump on
+    0x20, 0x00,         // horizontal addressing
+    0xA1, 0xC8,         // segment remap, COM scan descending
+    0xDA, 0x12,         // COM pins
+    0x81, 0xCF,         // contrast
+    0xD9, 0xF1,         // pre-charge
+    0xDB, 0x40,         // VCOMH
+    0xA4, 0xA6,         // RAM content, normal polarity
+    0x2E,               // no scrolling
+    0xAF,               // display on
+};
+static const uint8_t SSD1306_OFF = 0xAE;
+static const uint8_t SSD1306_ON = 0xAF;
+
+DashboardClass::DashboardClass()
+    :   _next(),
+        _shown(),
+        _source(nullptr),
+        _ctx(nullptr),
+        _on(true),
+        _full(true),
+        _task_handle(NULL),
+        _frames(0),
+        _bytes(0),
+        _bus_us(0)
+{
+}
+
+bool DashboardClass::begin(DASH_SOURCE source, void* ctx)
+{
+    _source = source;
+    _ctx = ctx;
+    Wire.begin(DASH_PIN_SDA, DASH_PIN_SCL, DASH_I2C_HZ);
+    Wire.beginTransmission(DASH_I2C_ADDR);
+    if (Wire.endTransmission() != 0 || !_command(SSD1306_INIT, sizeof(SSD1306_INIT)))
+    {
+        Serial.println("DASHBOARD::no panel at 0x3C");
+        return false;
+    }
+    BaseType_t r = xTaskCreatePinnedToCore(
+        _taskFunctionSTATIC,
+        "DASHBOARD_TASK",
+        DASH_TASK_STACK, this,
+        DASHBOARD_TASK_PRIO,
+        &_task_handle,
+        DASHBOARD_TASK_Core
+    );
+    if (r != pdPASS)
+    {
+        Serial.println("DASHBOARD::TASK::Creation failed");
+        return false;
+    }
+    return true;
+}
+
+void DashboardClass::setON(bool on)
+{
+    _on = on;
+    if (on)
+    {
+        _full = true;                           // RAM kept its content, but do not rely on it
+    }
+}
+
+bool DashboardClass::_command(const uint8_t* cmd, uint8_t n)
+{
+    Wire.beginTransmission(DASH_I2C_ADDR);
+    Wire.write((uint8_t)0x00);                  // control byte: commands follow
+    Wire.write(cmd, n);
+    return Wire.endTransmission() == 0;
+}
+
+bool DashboardClass::_sendRANGE(uint8_t page, uint8_t x0, uint8_t x1)
+{
+    const uint8_t window[] = {0x21, x0, x1, 0x22, page, page};
+    if (!_command(window, sizeof(window)))
+    {
+        return false;
+    }
+    const uint8_t* src = _next.page(page);
+    for (uint16_t x = x0; x <= x1; x += DASH_I2C_CHUNK)
+    {
+        uint8_t n = (uint8_t)min((uint16_t)DASH_I2C_CHUNK, (uint16_t)(x1 - x + 1));
+        Wire.beginTransmission(DASH_I2C_ADDR);
+        Wire.write((uint8_t)0x40);              // control byte: display data follows
+        Wire.write(src + x, n);
+        if (Wire.endTransmission() != 0)
+        {
+            return false;
+        }
+        _bytes += n;
+    }
+    return true;
+}
+
+void DashboardClass::_taskFunctionSTATIC(void* p)
+{
+    static_cast<DashboardClass*>(p)->_taskFUNC();
+}
+
+void DashboardClass::_taskFUNC()
+{
+    bool panel_on = true;
+    for (;;)
+    {
+        idlemgr.sleepALIGNED(idlemgr.idle() ? DASH_IDLE_REFRESH_MS : DASH_REFRESH_MS);
+        if (_on != panel_on)
+        {
+            panel_on = _on;
+            _command(panel_on ? &SSD1306_ON : &SSD1306_OFF, 1);
+        }
+        if (!panel_on)
+        {
+            continue;
+        }
+        DASH_STATE s;
+        _source(&s, _ctx);
+        dashRENDER(s, &_next);
+
+        const bool full = _full;
+        _full = false;
+        uint32_t t0 = micros();
+        for (uint8_t p = 0; p < OLED_PAGES; p++)
+        {
+            uint8_t x0 = 0, x1 = OLED_WIDTH - 1;
+            if (!full && !OledFrameClass::dirtyRANGE(_next, _shown, p, &x0, &x1))
+            {
+                continue;
+            }
+            if (!_sendRANGE(p, x0, x1))
+            {
+                _full = true;                   // the panel may hold a partial page; redo all next time
+                break;
+            }
+            _shown.copyPAGE(_next, p, x0, x1);
+        }
+        _bus_us += micros() - t0;
+        _frames++;
+    }
+}
+
+void DashboardClass::printSTATS()
+{
+    Serial.printf("DASHBOARD:: %s, %u frames, %u data bytes (%u per frame), %u ms on the bus\n",
+                  _on ? "on" : "off", _frames, _bytes, _frames ? _bytes / _frames : 0, _bus_us / 1000);
+}
+
+// ----------------- console commands -----------------
+static void cmd_DASH(void* ctx, const CmdArgs& args)
+{
+    DashboardClass* d = static_cast<DashboardClass*>(ctx);
+    if (args.count() > 0)
+    {
+        if (args.is(0, "ON"))       d->setON(true);
+        else if (args.is(0, "OFF")) d->setON(false);
+        else { Serial.println("DASHBOARD:: ON or OFF expected"); return; }
+    }
+    d->printSTATS();
+}
+
+static constexpr CONSOLE_CMD DASH_COMMANDS[] = {
+    {"DASH", nullptr, 0, cmd_DASH, "[ON|OFF]  - OLED dashboard and its I2C traffic"},
+};
+
+void DashboardClass::registerCOMMANDS(SerialConsoleClass& console)
+{
+    console.addTABLE(DASH_COMMANDS, this, "DASHBOARD");
+}
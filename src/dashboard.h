@@ -0,0 +1,54 @@
+#pragma once
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "oled_frame.h"
+#include "dashboard_view.h"
+
+// SSD1306 status dashboard on I2C, pushed by partial page updates.
+//
+// A low-priority task on the core the input path does not use wakes every DASH_REFRESH_MS,
+// asks its source for a DASH_STATE, renders a full frame locally and compares it with the copy
+// of what the panel shows. Only the changed column span of each changed page goes over the bus
+// (column/page window, then the bytes), so an idle screen costs no bus time and a battery tick
+// costs a few dozen bytes instead of the 1 KB display() of TRIALS/oled_debug.cpp. The refresh
+// period is the upper bound on the update rate whatever the source does.
+
+const uint8_t  DASH_I2C_ADDR        = 0x3C;
+const uint8_t  DASH_PIN_SDA         = 8;
+const uint8_t  DASH_PIN_SCL         = 9;
+const uint32_t DASH_I2C_HZ          = 400000;
+const uint16_t DASH_REFRESH_MS      = 250;      // 4 frames/s at most
+const uint16_t DASH_IDLE_REFRESH_MS = 1000;     // nothing typed: battery and uptime only
+const uint8_t  DASH_I2C_CHUNK       = 64;       // data bytes per transaction; Wire buffers 128
+const uint16_t DASH_TASK_STACK      = 3072;
+
+typedef void (*DASH_SOURCE)(DASH_STATE* out, void* ctx);   // runs on the dashboard task
+
+class SerialConsoleClass;
+
+class DashboardClass {
+public:
+    DashboardClass();
+    bool begin(DASH_SOURCE source, void* ctx);  // false when no panel answers; nothing runs then
+    void setON(bool on);                        // panel off stops rendering and bus traffic
+    bool on() const { return _on; }
+    void printSTATS();
+    void registerCOMMANDS(SerialConsoleClass& console);
+private:
+    OledFrameClass _next;                       // task only
+    OledFrameClass _shown;                      // what the panel holds
+    DASH_SOURCE    _source;
+    void*          _ctx;
+    volatile bool  _on;
+    volatile bool  _full;                       // panel content unknown: push every page
+    TaskHandle_t   _task_handle;
+    uint32_t       _frames;
+    uint32_t       _bytes;                      // data bytes sent
+    uint32_t       _bus_us;
+
+    static void _taskFunctionSTATIC(void* p);
+    void _taskFUNC();
+    bool _command(const uint8_t* cmd, uint8_t n);
+    bool _sendRANGE(uint8_t page, uint8_t x0, uint8_t x1);
+};
@@ -0,0 +1,49 @@
+// dashboard_view.cpp
+#include "dashboard_view.h"
+#include <stdio.h>
+
+//  page 0   BLE connected          (inverted title bar)
+//  page 1   Host  QWERTY  Mac
+//  page 2   Batt  3.92V  78%  CHG
+//  page 3   [#########.........]
+//  page 4   p99   12 ms
+//  page 5   Keys  3.4 /s
+//  page 6   Tier  NORMAL
+//  page 7   Up    1h23m
+void dashRENDER(const DASH_STATE& s, OledFrameClass* f)
+{
+    char line[OLED_COLS + 1];
+    f->clear();
+
+    f->fillPAGE(0, 0, OLED_WIDTH, 0xFF);
+    f->text(0, 0, s.ble_connected ? " BLE connected" : " BLE advertising", true);
+
+    snprintf(line, sizeof(line), "Host  %s%s", s.host_layout ? s.host_layout : "?", s.host_mac ? "  Mac" : "");
+    f->text(0, 1, line);
+
+    if (s.have_battery)
+    {
+        snprintf(line, sizeof(line), "Batt  %u.%02uV %3u%%%s", s.battery_mv / 1000, (s.battery_mv % 1000) / 10,
+                 s.battery_pct, s.charging ? " CHG" : "");
+        f->text(0, 2, line);
+        f->bar(0, 3, OLED_WIDTH, s.battery_pct);
+    }
+    else
+    {
+        f->text(0, 2, "Batt  --");
+    }
+
+    if (s.latency_p99_ms == DASH_NONE) snprintf(line, sizeof(line), "p99   -- ms");
+    else                               snprintf(line, sizeof(line), "p99   %u ms", s.latency_p99_ms);
+    f->text(0, 4, line);
+
+    snprintf(line, sizeof(line), "Keys  %u.%u /s", s.keys_per_s_x10 / 10, s.keys_per_s_x10 % 10);
+    f->text(0, 5, line);
+
+    snprintf(line, sizeof(line), "Tier  %s", s.power_tier ? s.power_tier : "?");
+    f->text(0, 6, line);
+
+    const uint32_t m = s.uptime_s / 60;
+    snprintf(line, sizeof(line), "Up    %uh%02um", (unsigned)(m / 60), (unsigned)(m % 60));
+    f->text(0, 7, line);
+}
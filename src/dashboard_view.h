@@ -0,0 +1,28 @@
+#pragma once
+#include <stdint.h>
+#include "oled_frame.h"
+
+// What the status dashboard shows, and how, kept free of Arduino so tools/ can render it.
+//
+// dashRENDER() draws a whole frame from a DASH_STATE every time; the dashboard task diffs it
+// against the frame on the glass (oled_frame.h), so a value that did not change costs nothing on
+// the bus. Fields are chosen so they change at human pace: rates in tenths, voltages in 10 mV
+// steps, uptime in minutes.
+
+const uint16_t DASH_NONE = 0xFFFF;
+
+typedef struct DASH_STATE {
+    bool        ble_connected;
+    const char* host_layout;        // remap layout name
+    bool        host_mac;           // Alt/GUI swapped
+    bool        have_battery;
+    uint16_t    battery_mv;
+    uint8_t     battery_pct;
+    bool        charging;
+    uint16_t    latency_p99_ms;     // DASH_NONE: no keys in the window
+    uint16_t    keys_per_s_x10;
+    const char* power_tier;
+    uint32_t    uptime_s;
+} DASH_STATE;
+
+void dashRENDER(const DASH_STATE& s, OledFrameClass* f);
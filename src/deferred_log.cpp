@@ -0,0 +1,87 @@
+// deferred_log.cpp
+#include "deferred_log.h"
+#include "serial_console.h"
+#include "task_CP.h"
+#include "idle_manager.h"
+
+DeferredLogClass dlog;
+
+DeferredLogClass::DeferredLogClass()
+    :   _ring(),
+        _level(DLOG_LEVEL),
+        _dropped_reported(0),
+        _port(nullptr),
+        _task_handle(NULL)
+{
+}
+
+bool DeferredLogClass::begin(Stream& port)
+{
+    _port = &port;
+    BaseType_t r = xTaskCreate(
+        _taskFunctionSTATIC,
+        "DEFERRED_LOG_TASK",
+        DLOG_TASK_STACK, this,
+        DEFERRED_LOG_TASK_PRIO,
+        &_task_handle
+    );
+    if (r != pdPASS)
+    {
+        Serial.println("LOG::TASK::Creation failed");
+        return false;
+    }
+    return true;
+}
+
+void DeferredLogClass::_taskFunctionSTATIC(void* p)
+{
+    static_cast<DeferredLogClass*>(p)->_taskFUNC();
+}
+
+// formatting happens here, at the lowest priority, never on the producer's stack
+void DeferredLogClass::_taskFUNC()
+{
+    char line[DLOG_LINE_MAX];
+    for (;;)
+    {
+        idlemgr.sleepALIGNED(idlemgr.idle() ? DLOG_IDLE_DRAIN_MS : DLOG_DRAIN_MS);
+        DLOG_RECORD r;
+        while (_ring.pop(&r))
+        {
+            size_t n = LogRingClass::format(r, line, sizeof(line));
+            _port->write((const uint8_t*)line, n);
+        }
+        uint32_t d = _ring.dropped();
+        if (d != _dropped_reported)
+        {
+            _port->printf("LOG:: %u records dropped\n", (unsigned)(d - _dropped_reported));
+            _dropped_reported = d;
+        }
+    }
+}
+
+// ----------------- console commands -----------------
+static void cmd_LOG(void* ctx, const CmdArgs& args)
+{
+    DeferredLogClass* l = static_cast<DeferredLogClass*>(ctx);
+    long v;
+    if (args.count() > 0)
+    {
+        if (!args.toINT(0, &v) || v < DLOG_LEVEL_NONE || v > DLOG_LEVEL_DEBUG)
+        {
+            Serial.println("LOG:: level 0 none, 1 error, 2 warn, 3 info, 4 debug");
+            return;
+        }
+        l->setLEVEL((uint8_t)v);
+    }
+    Serial.printf("LOG:: level %u (compiled up to %u), %u records dropped\n", l->level(), (unsigned)DLOG_LEVEL, l->dropped());
+}
+
+static constexpr CONSOLE_CMD LOG_COMMANDS[] = {
+    {"LOG", nullptr, 0, cmd_LOG, "[level]  - deferred log level, 0..4 up to the compiled DLOG_LEVEL"},
+};
+
+void DeferredLogClass::registerCOMMANDS(SerialConsoleClass& console)
+{
+    console.addTABLE(LOG_COMMANDS, this, "LOG");
+}
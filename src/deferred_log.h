@@ -0,0 +1,87 @@
+#pragma once
+#include <Arduino.h>
+#include <type_traits>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "log_ring.h"
+
+// Deferred text logging: call sites store a record (log_ring.h), a low-priority task formats
+// and prints it.
+//
+// DLOG_E / W / I / D compile to nothing - arguments included, they are not evaluated - above
+// DLOG_LEVEL, which defaults to INFO and can be set with build_flags (-DDLOG_LEVEL=4 keeps
+// debug records). A compiled-in call costs a level compare, millis() and a slot copy. The LOG
+// console command lowers the runtime level further.
+//
+//   DLOG_D("RAW : 0x%02x %02x", mods, key0);     // integers only, literal format
+
+#ifndef DLOG_LEVEL
+#define DLOG_LEVEL 3                            // DLOG_LEVEL_INFO; a plain number for #if
+#endif
+
+const uint16_t DLOG_DRAIN_MS        = 100;
+const uint16_t DLOG_IDLE_DRAIN_MS   = 1000;     // no input, little to log
+const uint16_t DLOG_TASK_STACK      = 3072;
+
+class SerialConsoleClass;
+
+class DeferredLogClass {
+public:
+    DeferredLogClass();
+    bool begin(Stream& port);                   // starts the drain task
+    void setLEVEL(uint8_t level) { _level = level > DLOG_LEVEL ? (uint8_t)DLOG_LEVEL : level; }
+    uint8_t level() const { return _level; }
+    uint32_t dropped() const { return _ring.dropped(); }
+
+    template <typename... A>
+    inline bool log(uint8_t level, const char* fmt, A... args)
+    {
+        static_assert(sizeof...(A) <= DLOG_MAX_ARGS, "too many deferred log arguments");
+        if (level > _level)
+        {
+            return false;
+        }
+        const uint32_t v[sizeof...(A) + 1] = {_arg(args)..., 0};
+        return _ring.push(level, millis(), fmt, v, (uint8_t)sizeof...(A));
+    }
+    void registerCOMMANDS(SerialConsoleClass& console);
+private:
+    LogRingClass     _ring;
+    volatile uint8_t _level;
+    uint32_t         _dropped_reported;
+    Stream*          _port;
+    TaskHandle_t     _task_handle;
+
+    template <typename T>
+    static inline uint32_t _arg(T v)
+    {
+        static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+                      "deferred log arguments are integers; scale floats, copy strings");
+        return (uint32_t)v;
+    }
+    static void _taskFunctionSTATIC(void* p);
+    void _taskFUNC();
+};
+
+extern DeferredLogClass dlog;
+
+#if DLOG_LEVEL >= 1
+#define DLOG_E(...) dlog.log(DLOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define DLOG_E(...) do {} while (0)
+#endif
+#if DLOG_LEVEL >= 2
+#define DLOG_W(...) dlog.log(DLOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define DLOG_W(...) do {} while (0)
+#endif
+#if DLOG_LEVEL >= 3
+#define DLOG_I(...) dlog.log(DLOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define DLOG_I(...) do {} while (0)
+#endif
+#if DLOG_LEVEL >= 4
+#define DLOG_D(...) dlog.log(DLOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define DLOG_D(...) do {} while (0)
+#endif
@@ -1,14 +1,26 @@
 #pragma once
 #include <Arduino.h>
 #include <Preferences.h>
-#include <vector>               // used by implementation for median/sort
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
-#include <vector>
-#include <algorithm>
 #include <cmath>
+#include "running_median.h"
+#include "adc_source.h"
+#include "adc_dma_source.h"
+#include "soc_estimator.h"
+#include "serial_console.h"
+#include "batt_config.h"
+#include "batt_snapshot.h"
+#include "telemetry.h"
+#include "adc_calibration.h"
+#include "charge_status.h"
+#include "adc_service.h"
+#include "idle_manager.h"
 
 const uint8_t ATDR = 12;
+const uint8_t  BATT_SAMPLE_ONESHOT  = 0;    // a running-median channel of the ADC scheduler (adc_service.h)
+const uint8_t  BATT_SAMPLE_BLOCK    = 1;    // one AdcSourceClass block per reading
+const uint16_t BATT_BLOCK_MAX       = 512;
 
 class BatteryMonitorClass {
 public:
@@ -24,31 +36,68 @@ public:
     float    calibration_factor;
 
     uint8_t  charge_status_pin;
+    uint8_t  sample_mode;           // BATT_SAMPLE_ONESHOT / BATT_SAMPLE_BLOCK
+    uint32_t block_rate_hz;
+    uint16_t block_samples;
+    uint8_t  chemistry;             // SOC_CHEM_*
+    uint16_t capacity_mah;
 
     // ctor / lifecycle
     BatteryMonitorClass();
     bool begin();                  // start the monitor task and load prefs
-    void saveSETTINGS();           // persist settings to flash
+    void saveSETTINGS();           // persist settings to flash now
+    void configCHANGED();          // settings edited in RAM; written after an idle period or SAVE
 
-    bool getBatterySTATUS(float *outVoltage, int *outPercent, bool *outCharging = nullptr);
+    bool getBatterySTATUS(float *outVoltage, int *outPercent, bool *outCharging = nullptr);   // never blocks, false until the first reading
+    bool getSNAPSHOT(BATT_SNAPSHOT* out) const;                  // same, plus the reading's timestamp
 
     // calibration & setters 
-    void calibrateUsingMEASURED_Volt(float measured_Volt);
+    void calibrateUsingMEASURED_Volt(float measured_Volt);  // adds a calibration point at the current raw
+    void clearCALIBRATION();
+    void printCALIBRATION();
     void setDEVIDER(float top, float bottom);
     void setNumberOfSAMPLES(uint8_t n);
     void setINTERVAL(uint16_t a);
     void setAdcREF(float v);
     void printCONFIG();
     void setemaALPHA(float alpha);
-    void processSerialLINE(String &s);
-    void printHELP();
+    void setSampleMODE(uint8_t mode);
+    void setBLOCK(uint32_t rate_hz, uint16_t samples);
+    void setSOURCE(AdcSourceClass* src);   // block-mode source; defaults to the DMA driver
+    void setCHEMISTRY(uint8_t chem);
+    void setCAPACITY(uint16_t mah);
+    void setLoadMA(float ma);              // estimated system load for the SoC model, not persisted
+    void setPolicyINTERVAL(uint16_t ms);   // power-policy override of interval_ms, not persisted; 0 clears
+    void registerCOMMANDS(SerialConsoleClass& console);
+    ChargeStatusClass& chargeSTATUS() { return _charge; }  // addLISTENER() to wake on plug / unplug
 private:
     // internal state
-    float _ema_voltage;
-    int   _last_percentage;
+    float _ema_voltage;             // task-owned; readers go through _snapshot
+    float _block_raw;
+    volatile uint16_t _policy_interval_ms;
+    SocEstimatorClass _soc;         // task-owned
+    volatile float _load_ma;
+    uint32_t _soc_last_ms;
+    volatile bool _config_dirty;
+    volatile uint32_t _config_changed_ms;
+    uint32_t _saved_crc;            // CRC of the blob in flash, skips identical writes
+    BattSnapshotClass _snapshot;    // last published reading
+    AdcCalibrationClass _cal;       // raw -> battery mV table, rebuilt by the task; points under _mutex
+    volatile bool _cal_stale;       // divider, ref or points changed
+    uint8_t _cal_pin;               // pin the eFuse characterisation was made for
+    ChargeStatusClass _charge;
 
     Preferences _prefs;
     SemaphoreHandle_t _mutex;
+    uint8_t _adc_ch;                // battery channel in adc; its pin / window / period follow the fields
+    uint8_t _ch_pin;
+    uint8_t _ch_window;
+    uint16_t _ch_fill_ms;
+    uint16_t _ch_period_ms;
+    bool _ch_enabled;
+    AdcDmaSOURCE _dma_source;
+    AdcSourceClass* _source;
+    uint16_t _block[BATT_BLOCK_MAX];
     TaskHandle_t  _task_handle;
 
     // internal helpers 
@@ -56,8 +105,17 @@ private:
     void _taskFUNC();
     float _adcRawToBatteryVOLTAGE(float adcAVG);
     float _sampleMedianRAW();
-    uint8_t _voltageToPERCENTAGE(float v);
-
-    // compile-time size for the table (unchanged name)
-    static const uint8_t VOLTS_TABLE_SIZE = 11;
+    bool _readCHANNEL(float* raw);
+    void _syncCHANNEL();
+    bool _readBLOCK(float* raw);
+    uint16_t _samplePERIOD();
+    uint16_t _intervalMS();
+    int _updateSOC(float v, bool charging, bool first);
+    bool _chargingNOW();
+    void _rebuildCAL();
+    void _publish(int pct, bool charging);
+    void _packCONFIG(BATT_CONFIG_DATA* c);
+    void _unpackCONFIG(const BATT_CONFIG_DATA& c);
+    void _loadCONFIG();
+    bool _commitCONFIG();
 };
\ No newline at end of file
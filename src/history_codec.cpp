@@ -0,0 +1,193 @@
+// history_codec.cpp
+#include "history_codec.h"
+#include "batt_config.h"
+#include <string.h>
+
+static const uint16_t HIST_CRC_FROM = offsetof(HIST_PAGE_HEADER, seq);
+
+static uint8_t putVARINT(uint8_t* p, uint32_t v)
+{
+    uint8_t n = 0;
+    while (v >= 0x80)
+    {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+static bool getVARINT(const uint8_t* p, uint16_t end, uint16_t* pos, uint32_t* v)
+{
+    uint32_t r = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7)
+    {
+        if (*pos >= end)
+        {
+            return false;
+        }
+        uint8_t b = p[(*pos)++];
+        r |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80))
+        {
+            *v = r;
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline uint32_t zigzag(int32_t v)   { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static inline int32_t  unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+// ----------------- stats -----------------
+void histStatsRESET(HIST_STATS* s)
+{
+    s->count = 0;
+    s->mv_min = 0xFFFF;
+    s->mv_max = 0;
+    s->mv_sum = 0;
+    s->t_first = 0;
+    s->t_last = 0;
+}
+
+void histStatsADD(HIST_STATS* s, const HIST_SAMPLE& x)
+{
+    if (!s->count || x.t < s->t_first) s->t_first = x.t;
+    if (!s->count || x.t > s->t_last)  s->t_last = x.t;
+    if (x.mv < s->mv_min) s->mv_min = x.mv;
+    if (x.mv > s->mv_max) s->mv_max = x.mv;
+    s->mv_sum += x.mv;
+    s->count++;
+}
+
+void histStatsADD_PAGE(HIST_STATS* s, const HIST_PAGE_HEADER& h)
+{
+    if (!h.count)
+    {
+        return;
+    }
+    if (!s->count || h.t_start < s->t_first) s->t_first = h.t_start;
+    if (!s->count || h.t_end > s->t_last)    s->t_last = h.t_end;
+    if (h.mv_min < s->mv_min) s->mv_min = h.mv_min;
+    if (h.mv_max > s->mv_max) s->mv_max = h.mv_max;
+    s->mv_sum += h.mv_sum;
+    s->count += h.count;
+}
+
+// ----------------- writer -----------------
+HistPageWriterClass::HistPageWriterClass()
+    :   _page(nullptr)
+{
+    memset(&_last, 0, sizeof(_last));
+}
+
+void HistPageWriterClass::begin(uint8_t* page, uint32_t seq)
+{
+    _page = page;
+    memset(_page, 0xFF, HIST_PAGE_SIZE);        // erased-flash value past the data
+    HIST_PAGE_HEADER* h = _hdr();
+    memset(h, 0, HIST_HEADER_SIZE);
+    h->magic = HIST_MAGIC;
+    h->version = HIST_VERSION;
+    h->seq = seq;
+    h->mv_min = 0xFFFF;
+}
+
+bool HistPageWriterClass::append(const HIST_SAMPLE& x)
+{
+    HIST_PAGE_HEADER* h = _hdr();
+    const HIST_SAMPLE prev = h->count ? _last : x;      // the first sample is the page's base
+    if (x.t < prev.t || x.t - prev.t >= (1u << 30) || h->count == 0xFFFF)
+    {
+        return false;                                   // time only moves forward within a page
+    }
+    uint8_t tmp[10];
+    uint8_t n = putVARINT(tmp, ((x.t - prev.t) << 2) | (x.flags & 0x03));
+    n += putVARINT(tmp + n, zigzag((int32_t)x.mv - (int32_t)prev.mv));
+    if (h->data_len + n > HIST_DATA_MAX)
+    {
+        return false;
+    }
+    memcpy(_page + HIST_HEADER_SIZE + h->data_len, tmp, n);
+    if (!h->count)
+    {
+        h->t_start = x.t;
+        h->mv_first = x.mv;
+    }
+    h->data_len += n;
+    h->count++;
+    h->t_end = x.t;
+    h->mv_sum += x.mv;
+    if (x.mv < h->mv_min) h->mv_min = x.mv;
+    if (x.mv > h->mv_max) h->mv_max = x.mv;
+    h->flags_or |= x.flags;
+    _last = x;
+    return true;
+}
+
+void HistPageWriterClass::seal()
+{
+    _hdr()->crc = histPageCRC(_page);
+}
+
+// ----------------- reader -----------------
+uint32_t histPageCRC(const uint8_t* page)
+{
+    const HIST_PAGE_HEADER* h = (const HIST_PAGE_HEADER*)page;
+    return battConfigCRC(page + HIST_CRC_FROM, HIST_HEADER_SIZE - HIST_CRC_FROM + h->data_len);
+}
+
+bool histPageVALID(const uint8_t* page)
+{
+    const HIST_PAGE_HEADER* h = (const HIST_PAGE_HEADER*)page;
+    return h->magic == HIST_MAGIC && h->version == HIST_VERSION && h->data_len <= HIST_DATA_MAX &&
+           h->crc == histPageCRC(page);
+}
+
+HistPageReaderClass::HistPageReaderClass()
+    :   _page(nullptr),
+        _pos(0),
+        _end(0),
+        _left(0)
+{
+    memset(&_last, 0, sizeof(_last));
+}
+
+bool HistPageReaderClass::begin(const uint8_t* page, bool check_crc)
+{
+    const HIST_PAGE_HEADER* h = (const HIST_PAGE_HEADER*)page;
+    _page = nullptr;
+    if (h->magic != HIST_MAGIC || h->data_len > HIST_DATA_MAX || (check_crc && !histPageVALID(page)))
+    {
+        return false;
+    }
+    _page = page;
+    _pos = HIST_HEADER_SIZE;
+    _end = HIST_HEADER_SIZE + h->data_len;
+    _left = h->count;
+    _last.t = h->t_start;
+    _last.mv = h->mv_first;
+    _last.flags = 0;
+    return true;
+}
+
+bool HistPageReaderClass::next(HIST_SAMPLE* out)
+{
+    if (!_page || !_left)
+    {
+        return false;
+    }
+    uint32_t td, dmv;
+    if (!getVARINT(_page, _end, &_pos, &td) || !getVARINT(_page, _end, &_pos, &dmv))
+    {
+        _left = 0;
+        return false;
+    }
+    _last.t += td >> 2;
+    _last.flags = (uint8_t)(td & 0x03);
+    _last.mv = (uint16_t)((int32_t)_last.mv + unzigzag(dmv));
+    _left--;
+    *out = _last;
+    return true;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Page format of the battery history log (batt_history.h); plain C++ so tools/ can test it.
+//
+// A page is one flash sector: a header with the page's summary, then samples delta-encoded
+// against the previous one (the header's t_start / mv_first for the first):
+//   varint( dt_seconds << 2 | flags )   zigzag varint( d_mV )
+// A reading a minute on a slowly moving battery costs 3 bytes, so a 4 KiB page holds about
+// 22 hours. The summary (count, min/max/sum of mV, time span) lets a query use whole pages
+// without decoding them; only pages straddling the window edges are decoded.
+// The CRC covers everything after the crc field up to the end of the data.
+
+const uint16_t HIST_PAGE_SIZE       = 4096;
+const uint16_t HIST_MAGIC           = 0x4854;
+const uint8_t  HIST_VERSION         = 1;
+
+const uint8_t  HIST_FLAG_CHARGING   = 0x01;
+const uint8_t  HIST_FLAG_BOOT       = 0x02;     // first sample after power-up; the gap before it is unknown
+
+typedef struct __attribute__((packed)) HIST_PAGE_HEADER {
+    uint16_t magic;
+    uint8_t  version;
+    uint8_t  flags_or;                          // OR of all sample flags
+    uint32_t crc;
+    uint32_t seq;                               // page sequence, the highest is the newest
+    uint32_t t_start;                           // log seconds of the first sample
+    uint32_t t_end;                             // and of the last
+    uint16_t mv_first;
+    uint16_t mv_min;
+    uint16_t mv_max;
+    uint16_t count;
+    uint32_t mv_sum;
+    uint16_t data_len;
+    uint16_t reserved;
+} HIST_PAGE_HEADER;
+
+const uint16_t HIST_HEADER_SIZE     = sizeof(HIST_PAGE_HEADER);
+const uint16_t HIST_DATA_MAX        = HIST_PAGE_SIZE - HIST_HEADER_SIZE;
+
+typedef struct HIST_SAMPLE {
+    uint32_t t;                                 // log seconds
+    uint16_t mv;
+    uint8_t  flags;                             // HIST_FLAG_*
+} HIST_SAMPLE;
+
+// running min / avg / max over any number of samples or page summaries
+typedef struct HIST_STATS {
+    uint32_t count;
+    uint16_t mv_min;
+    uint16_t mv_max;
+    uint64_t mv_sum;
+    uint32_t t_first;
+    uint32_t t_last;
+} HIST_STATS;
+
+void histStatsRESET(HIST_STATS* s);
+void histStatsADD(HIST_STATS* s, const HIST_SAMPLE& x);
+void histStatsADD_PAGE(HIST_STATS* s, const HIST_PAGE_HEADER& h);
+
+// builds one page in a caller-owned HIST_PAGE_SIZE buffer
+class HistPageWriterClass {
+public:
+    HistPageWriterClass();
+    void begin(uint8_t* page, uint32_t seq);
+    bool append(const HIST_SAMPLE& x);          // false when the page is full (nothing written)
+    void seal();                                // fills in the CRC; the page is ready for flash
+    uint16_t count() const { return _hdr()->count; }
+    bool empty() const { return !_page || _hdr()->count == 0; }
+    const HIST_PAGE_HEADER& header() const { return *_hdr(); }
+private:
+    uint8_t*    _page;
+    HIST_SAMPLE _last;
+    HIST_PAGE_HEADER* _hdr() const { return (HIST_PAGE_HEADER*)_page; }
+};
+
+// walks the samples of a page (RAM copy or sealed)
+class HistPageReaderClass {
+public:
+    HistPageReaderClass();
+    bool begin(const uint8_t* page, bool check_crc);   // false: not a valid page
+    bool next(HIST_SAMPLE* out);
+private:
+    const uint8_t* _page;
+    uint16_t       _pos;
+    uint16_t       _end;
+    uint16_t       _left;
+    HIST_SAMPLE    _last;
+};
+
+bool histPageVALID(const uint8_t* page);                // magic, version, length and CRC
+uint32_t histPageCRC(const uint8_t* page);
@@ -0,0 +1,256 @@
+// idle_manager.cpp
+#include "idle_manager.h"
+#include "serial_console.h"
+#include "esp_timer.h"
+
+IdleManagerClass idlemgr;
+
+IdleManagerClass::IdleManagerClass()
+    :   _active(false),
+        _wake_pending(false),
+        _last_input_ms(0),
+        _wake_us(0),
+        _usb_open(0),
+        _mode("off"),
+#if CONFIG_PM_ENABLE
+        _cpu_lock(NULL),
+        _input_lock(NULL),
+        _usb_lock(NULL),
+#endif
+        _wakeups(0),
+        _wake_instants(0),
+        _last_wake_tick(0),
+        _idle_entries(0),
+        _wake_count(0),
+        _wake_worst_us(0),
+        _wake_over(0),
+        _stats_ms(0),
+        _total_base(0)
+{
+    _idle_base[0] = _idle_base[1] = 0;
+}
+
+bool IdleManagerClass::begin()
+{
+#if CONFIG_PM_ENABLE
+    if (esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "input_cpu", &_cpu_lock) != ESP_OK ||
+        esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "input", &_input_lock) != ESP_OK ||
+        esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "usb_host", &_usb_lock) != ESP_OK)
+    {
+        Serial.println("IDLE::PM::lock creation failed");
+        return false;
+    }
+    if (_usb_open)
+    {
+        esp_pm_lock_acquire(_usb_lock);
+    }
+    #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    esp_pm_config_t cfg;
+    #else
+    esp_pm_config_esp32s3_t cfg;
+    #endif
+    cfg.max_freq_mhz = IDLE_MAX_FREQ_MHZ;
+    cfg.min_freq_mhz = IDLE_MIN_FREQ_MHZ;
+    #if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+    cfg.light_sleep_enable = true;
+    _mode = "DFS + light sleep";
+    #else
+    cfg.light_sleep_enable = false;
+    _mode = "DFS (core built without tickless idle)";
+    #endif
+    esp_err_t err = esp_pm_configure(&cfg);
+    if (err != ESP_OK)
+    {
+        Serial.printf("IDLE::PM::configure failed (%d)\n", (int)err);
+        _mode = "alignment only";
+    }
+#else
+    _mode = "alignment only (core built without CONFIG_PM_ENABLE)";
+#endif
+    resetSTATS();
+    Serial.printf("IDLE:: %s\n", _mode);
+    return true;
+}
+
+// first report after an idle period: full clock and no sleep before it is even decoded
+void IdleManagerClass::activity()
+{
+    _last_input_ms = millis();
+    if (_active.exchange(true, std::memory_order_relaxed))
+    {
+        return;
+    }
+#if CONFIG_PM_ENABLE
+    if (_cpu_lock)
+    {
+        esp_pm_lock_acquire(_cpu_lock);
+        esp_pm_lock_acquire(_input_lock);
+    }
+#endif
+    _wake_us = (uint32_t)esp_timer_get_time();
+    _wake_pending.store(true, std::memory_order_relaxed);
+}
+
+void IdleManagerClass::keySENT(uint32_t conn_interval_us)
+{
+    if (!_wake_pending.exchange(false, std::memory_order_relaxed))
+    {
+        return;
+    }
+    uint32_t us = (uint32_t)esp_timer_get_time() - _wake_us;
+    _wake_count++;
+    if (us > _wake_worst_us) _wake_worst_us = us;
+    if (us > conn_interval_us) _wake_over++;
+}
+
+// a report between the check and the release re-acquires; the locks are counted
+void IdleManagerClass::service(uint32_t now_ms)
+{
+    if (!_active.load(std::memory_order_relaxed) || now_ms - _last_input_ms < IDLE_ENTER_MS)
+    {
+        return;
+    }
+    bool expected = true;
+    if (!_active.compare_exchange_strong(expected, false, std::memory_order_relaxed))
+    {
+        return;
+    }
+    _wake_pending.store(false, std::memory_order_relaxed);
+    _idle_entries++;
+#if CONFIG_PM_ENABLE
+    if (_cpu_lock)
+    {
+        esp_pm_lock_release(_input_lock);
+        esp_pm_lock_release(_cpu_lock);
+    }
+#endif
+}
+
+// USB event paths; open and close of one interface never overlap
+void IdleManagerClass::usbOPENED()
+{
+#if CONFIG_PM_ENABLE
+    if (_usb_lock && _usb_open == 0)
+    {
+        esp_pm_lock_acquire(_usb_lock);
+    }
+#endif
+    _usb_open++;
+}
+
+void IdleManagerClass::usbCLOSED()
+{
+    if (_usb_open == 0)
+    {
+        return;
+    }
+    _usb_open--;
+#if CONFIG_PM_ENABLE
+    if (_usb_lock && _usb_open == 0)
+    {
+        esp_pm_lock_release(_usb_lock);
+    }
+#endif
+}
+
+TickType_t IdleManagerClass::alignedTICKS(uint32_t period_ms)
+{
+    uint32_t now = millis();
+    TickType_t t = pdMS_TO_TICKS(idleNEXT_WAKE(now, period_ms) - now);
+    return t ? t : 1;
+}
+
+void IdleManagerClass::sleepALIGNED(uint32_t period_ms)
+{
+    vTaskDelay(alignedTICKS(period_ms));
+    _noteWAKE();
+}
+
+// several tasks waking in the same tick count as one wake-up of the chip
+void IdleManagerClass::_noteWAKE()
+{
+    _wakeups.fetch_add(1, std::memory_order_relaxed);
+    TickType_t now = xTaskGetTickCount();
+    if (now != _last_wake_tick)
+    {
+        _last_wake_tick = now;
+        _wake_instants.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool IdleManagerClass::_runTIME(uint64_t* idle0, uint64_t* idle1, uint64_t* total)
+{
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS && CONFIG_FREERTOS_USE_TRACE_FACILITY
+    TaskStatus_t st;
+    vTaskGetInfo(xTaskGetIdleTaskHandleForCPU(0), &st, pdFALSE, eRunning);
+    *idle0 = st.ulRunTimeCounter;
+    vTaskGetInfo(xTaskGetIdleTaskHandleForCPU(1), &st, pdFALSE, eRunning);
+    *idle1 = st.ulRunTimeCounter;
+    *total = (uint64_t)portGET_RUN_TIME_COUNTER_VALUE();
+    return true;
+#else
+    *idle0 = *idle1 = *total = 0;
+    return false;
+#endif
+}
+
+void IdleManagerClass::resetSTATS()
+{
+    _wakeups.store(0, std::memory_order_relaxed);
+    _wake_instants.store(0, std::memory_order_relaxed);
+    _idle_entries = 0;
+    _wake_count = 0;
+    _wake_worst_us = 0;
+    _wake_over = 0;
+    _stats_ms = millis();
+    _runTIME(&_idle_base[0], &_idle_base[1], &_total_base);
+}
+
+void IdleManagerClass::printSTATS()
+{
+    uint32_t secs = (millis() - _stats_ms) / 1000;
+    if (!secs) secs = 1;
+    Serial.printf("IDLE:: %s; %s now, USB device %s\n", _mode, idle() ? "idle" : "active",
+                  _usb_open ? "attached (no light sleep)" : "absent");
+    uint64_t i0, i1, total;
+    if (_runTIME(&i0, &i1, &total) && total > _total_base)
+    {
+        // the run-time counter is 32 bits wide on the idle tasks; fine for windows under an hour
+        float span = (float)(total - _total_base);
+        Serial.printf("IDLE:: residency core0 %.1f%%, core1 %.1f%% over %u s\n",
+                      100.0f * (uint32_t)(i0 - _idle_base[0]) / span, 100.0f * (uint32_t)(i1 - _idle_base[1]) / span, secs);
+    }
+    else
+    {
+        Serial.println("IDLE:: residency n/a (core built without run-time stats)");
+    }
+    uint32_t w = _wakeups.load(std::memory_order_relaxed);
+    uint32_t wi = _wake_instants.load(std::memory_order_relaxed);
+    Serial.printf("IDLE:: periodic wake-ups %.1f/s in %.1f distinct ticks/s, %u idle periods\n",
+                  (float)w / secs, (float)wi / secs, _idle_entries);
+    Serial.printf("IDLE:: first key after idle: %u seen, worst %u us, %u slower than a connection interval\n",
+                  _wake_count, _wake_worst_us, _wake_over);
+}
+
+// ----------------- console commands -----------------
+static void cmd_IDLE(void* ctx, const CmdArgs& args)
+{
+    (void)args;
+    static_cast<IdleManagerClass*>(ctx)->printSTATS();
+}
+static void cmd_IDLE_RESET(void* ctx, const CmdArgs& args)
+{
+    (void)args;
+    static_cast<IdleManagerClass*>(ctx)->resetSTATS();
+    Serial.println("IDLE:: statistics reset");
+}
+
+static constexpr CONSOLE_CMD IDLE_COMMANDS[] = {
+    {"IDLE", nullptr, 0, cmd_IDLE, "- idle residency, wake-ups and first-key wake latency"},
+    {"IDLE", "RESET", 0, cmd_IDLE_RESET, "- restart the idle statistics window"},
+};
+
+void IdleManagerClass::registerCOMMANDS(SerialConsoleClass& console)
+{
+    console.addTABLE(IDLE_COMMANDS, this, "IDLE");
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "idle_schedule.h"
+#if CONFIG_PM_ENABLE
+#include <esp_idf_version.h>
+#include "esp_pm.h"
+#endif
+
+// Power management of the idle bridge: dynamic frequency scaling, automatic light sleep where
+// the hardware allows it, and one aligned wake-up schedule for the periodic tasks.
+//
+// Input (any USB report) makes the bridge active: a CPU_FREQ_MAX and a NO_LIGHT_SLEEP lock are
+// taken at once from the report path, so the first key is handled at full clock and never waits
+// for a sleep exit. IDLE_ENTER_MS after the last input service() drops both and the PM layer
+// scales down between interrupts. A USB device on the bus holds its own NO_LIGHT_SLEEP lock -
+// light sleep stops the OTG controller's SOFs and the keyboard would suspend - so automatic
+// light sleep (tickless idle between BLE connection events) only happens with no keyboard
+// attached; with one attached the idle gain is DFS plus fewer wake-ups. Light sleep needs a
+// core built with CONFIG_PM_ENABLE and CONFIG_FREERTOS_USE_TICKLESS_IDLE; without them begin()
+// reports what is missing and the alignment still applies.
+//
+// Residency is the idle tasks' share of run time (CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS),
+// light sleep included since it happens inside them. The wake latency is the time from the first
+// USB report after an idle period to its BLE report, checked against the connection interval.
+
+const uint16_t IDLE_ENTER_MS        = 2000;
+const uint16_t IDLE_MIN_FREQ_MHZ    = 80;
+const uint16_t IDLE_MAX_FREQ_MHZ    = 240;
+
+class SerialConsoleClass;
+
+class IdleManagerClass {
+public:
+    IdleManagerClass();
+    bool begin();
+    void service(uint32_t now_ms);              // loop(): drops the active locks after IDLE_ENTER_MS
+
+    // input path, any task
+    void activity();
+    inline bool wakePENDING() const { return _wake_pending.load(std::memory_order_relaxed); }
+    void keySENT(uint32_t conn_interval_us);    // first key after idle reached the BLE stack
+    void usbOPENED();                           // per opened interface; counted
+    void usbCLOSED();
+
+    bool idle() const { return !_active.load(std::memory_order_relaxed); }
+    // periodic tasks: sleep to the next aligned multiple of period_ms
+    TickType_t alignedTICKS(uint32_t period_ms);
+    void sleepALIGNED(uint32_t period_ms);
+
+    void printSTATS();
+    void resetSTATS();
+    void registerCOMMANDS(SerialConsoleClass& console);
+private:
+    std::atomic<bool>     _active;
+    std::atomic<bool>     _wake_pending;
+    volatile uint32_t     _last_input_ms;
+    volatile uint32_t     _wake_us;
+    uint8_t               _usb_open;            // interfaces open; >0 holds _usb_lock
+    const char*           _mode;                // what begin() could enable
+#if CONFIG_PM_ENABLE
+    esp_pm_lock_handle_t  _cpu_lock;
+    esp_pm_lock_handle_t  _input_lock;
+    esp_pm_lock_handle_t  _usb_lock;
+#endif
+
+    // statistics since resetSTATS()
+    std::atomic<uint32_t> _wakeups;             // periodic task wake-ups
+    std::atomic<uint32_t> _wake_instants;       // distinct ticks among them
+    volatile TickType_t   _last_wake_tick;
+    uint32_t              _idle_entries;
+    uint32_t              _wake_count;
+    uint32_t              _wake_worst_us;
+    uint32_t              _wake_over;           // first keys slower than one connection interval
+    uint32_t              _stats_ms;
+    uint64_t              _idle_base[2];
+    uint64_t              _total_base;
+
+    void _noteWAKE();
+    bool _runTIME(uint64_t* idle0, uint64_t* idle1, uint64_t* total);
+};
+
+extern IdleManagerClass idlemgr;
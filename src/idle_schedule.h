@@ -0,0 +1,31 @@
+#pragma once
+#include <stdint.h>
+
+// Wake-up alignment shared by every periodic task (idle_manager.h), kept free of the RTOS so
+// tools/ can simulate it.
+//
+// Periods are rounded up to whole IDLE_SLOT_MS slots and every task sleeps until the next
+// multiple of its period on the common millis() time base, so a 50 ms, a 250 ms and a 1.5 s task
+// all wake on the same slot edges: one wake-up serves all of them instead of three scattered
+// ones. The time base wraps after 49 days, which costs one short period.
+
+const uint16_t IDLE_SLOT_MS = 50;
+
+static inline uint32_t idlePERIOD(uint32_t period_ms, uint32_t slot_ms = IDLE_SLOT_MS)
+{
+    uint32_t p = (period_ms + slot_ms - 1) / slot_ms * slot_ms;
+    return p ? p : slot_ms;
+}
+
+// first multiple of the (rounded) period strictly after now
+static inline uint32_t idleNEXT_WAKE(uint32_t now_ms, uint32_t period_ms, uint32_t slot_ms = IDLE_SLOT_MS)
+{
+    const uint32_t p = idlePERIOD(period_ms, slot_ms);
+    return (now_ms / p + 1) * p;
+}
+
+// a one-off deadline pushed to the slot edge at or after it
+static inline uint32_t idleALIGN_UP(uint32_t due_ms, uint32_t slot_ms = IDLE_SLOT_MS)
+{
+    return (due_ms + slot_ms - 1) / slot_ms * slot_ms;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+
+// One key transition produced by the report diff. usage == 0 marks a modifier-only change.
+// Kept free of Arduino/ESP headers so the key-processing engines build on the host as well.
+typedef struct KB_EVENT{
+    uint8_t  usage;
+    uint8_t  mods;
+    bool     pressed;
+    uint8_t  src;           // fan-in slot of the keyboard that produced it, KB_SRC_NONE if none
+    uint32_t time_ms;       // millis() when the diff produced the event
+} KB_EVENT;
+
+const uint8_t KB_SRC_NONE = 0xFF;       // debounce re-checks and the engines after KBQueue
+
+// whole boot keyboard report as produced by the report-level output paths (macros, bulk text)
+typedef struct KB_REPORT {
+    uint8_t mods;
+    uint8_t keys[6];
+} KB_REPORT;
+
+// downstream consumer of processed events (BLE output, next engine stage, test harness)
+typedef void (*KB_EVENT_SINK)(const KB_EVENT& ev, void* arg);
+
+// Internal action usages taken from the reserved HID block 0xA5..0xAF. Layer tables may
+// produce them; TASK_BLE consumes them and never sends them to the host.
+const uint8_t KB_ACTION_FIRST       = 0xA5;
+const uint8_t KB_ACTION_MACRO_REC0  = 0xA5;   // ..REC3  = 0xA8, start/stop recording a slot
+const uint8_t KB_ACTION_MACRO_PLAY0 = 0xA9;   // ..PLAY3 = 0xAC, replay a slot
+const uint8_t KB_ACTION_LAST        = 0xAF;
+
+inline bool isKbACTION(uint8_t usage) { return usage >= KB_ACTION_FIRST && usage <= KB_ACTION_LAST; }
@@ -0,0 +1,214 @@
+// key_combos.cpp
+#include "key_combos.h"
+#include "ascii_hid.h"
+#include <string.h>
+
+const uint8_t COMBO_LEFT_SHIFT = 0x02;    // boot-report modifier bit
+
+static constexpr COMBO_DEF DEFAULT_COMBOS[] = {
+    {{0x0D, 0x0E, 0, 0},       COMBO_KIND_KEY,  0x29, 0, nullptr},   // J+K     -> Esc
+    {{0x07, 0x09, 0x0D, 0x0E}, COMBO_KIND_TEXT, 0,    0, "the "},    // D+F+J+K -> "the "
+};
+
+KeyComboClass::KeyComboClass()
+    :   _wheel(nullptr),
+        _sink(nullptr),
+        _sink_arg(nullptr),
+        _defs(DEFAULT_COMBOS),
+        _count(0),
+        _open(false),
+        _timer(-1),
+        _buffered(0),
+        _mods(0),
+        _fired(0)
+{
+    memset(_masks, 0, sizeof(_masks));
+    memset(_member, 0, sizeof(_member));
+    memset(_swallow, 0, sizeof(_swallow));
+    memset(_chord, 0, sizeof(_chord));
+
+    const uint8_t n = sizeof(DEFAULT_COMBOS) / sizeof(DEFAULT_COMBOS[0]);
+    for (uint8_t c = 0; c < n && c < COMBO_MAX; c++)
+    {
+        for (uint8_t k = 0; k < COMBO_MAX_KEYS && _defs[c].keys[k]; k++)
+        {
+            _setBIT(_masks[c], _defs[c].keys[k]);
+            _setBIT(_member, _defs[c].keys[k]);
+        }
+        _count++;
+    }
+}
+
+void KeyComboClass::begin(TimerWheelClass* wheel, KB_EVENT_SINK sink, void* sink_arg)
+{
+    _wheel = wheel;
+    _sink = sink;
+    _sink_arg = sink_arg;
+}
+
+void KeyComboClass::onEVENT(const KB_EVENT& ev)
+{
+    // releases of keys eaten by a fired combo never reach the host
+    if (ev.usage != 0 && !ev.pressed && _testBIT(_swallow, ev.usage))
+    {
+        _clearBIT(_swallow, ev.usage);
+        return;
+    }
+
+    if (_open)
+    {
+        if (ev.usage != 0 && ev.pressed && _testBIT(_member, ev.usage) && _buffered < COMBO_BUFFER)
+        {
+            _buffer[_buffered++] = ev;
+            _setBIT(_chord, ev.usage);
+            bool grow, prefix;
+            int8_t m = _match(&grow, &prefix);
+            // decide early when nothing longer can still match
+            if ((m >= 0 && !grow) || !prefix)
+            {
+                _close(ev.time_ms);
+            }
+            return;
+        }
+        if (ev.usage == 0 && _buffered < COMBO_BUFFER)
+        {
+            _buffer[_buffered++] = ev;
+            return;
+        }
+        // non-member press, release or overflow: the window is ruled out right now
+        _close(ev.time_ms);
+        if (ev.usage != 0 && !ev.pressed && _testBIT(_swallow, ev.usage))
+        {
+            _clearBIT(_swallow, ev.usage);
+            return;
+        }
+    }
+
+    if (ev.usage != 0 && ev.pressed && _testBIT(_member, ev.usage))
+    {
+        int8_t h = _wheel ? _wheel->schedule(ev.time_ms + COMBO_TERM_MS, _onTIMER, this, 0) : -1;
+        if (h >= 0)
+        {
+            memset(_chord, 0, sizeof(_chord));
+            _setBIT(_chord, ev.usage);
+            _buffer[0] = ev;
+            _buffered = 1;
+            _timer = h;
+            _open = true;
+            return;
+        }
+    }
+    if (ev.usage == 0)
+    {
+        _mods = ev.mods;
+    }
+    _emit(ev.usage, ev.mods, ev.pressed, ev.time_ms);
+}
+
+int8_t KeyComboClass::_match(bool* can_grow, bool* is_prefix) const
+{
+    int8_t exact = -1;
+    *can_grow = false;
+    *is_prefix = false;
+    for (uint8_t c = 0; c < _count; c++)
+    {
+        bool subset = true;
+        bool equal = true;
+        for (uint8_t w = 0; w < COMBO_WORDS; w++)
+        {
+            const uint32_t m = _masks[c][w];
+            const uint32_t ch = _chord[w];
+            if ((ch & m) != ch) { subset = false; break; }
+            if (ch != m) equal = false;
+        }
+        if (!subset) continue;
+        *is_prefix = true;
+        if (equal) exact = c;
+        else       *can_grow = true;
+    }
+    return exact;
+}
+
+void KeyComboClass::_onTIMER(void* owner, uint32_t tag, uint32_t now_ms)
+{
+    (void)tag;
+    KeyComboClass* self = static_cast<KeyComboClass*>(owner);
+    if (!self->_open)
+    {
+        return;
+    }
+    self->_timer = -1;      // the wheel already released this handle
+    self->_close(now_ms);
+}
+
+void KeyComboClass::_close(uint32_t now_ms)
+{
+    if (_timer >= 0 && _wheel)
+    {
+        _wheel->cancel(_timer);
+    }
+    _timer = -1;
+    _open = false;
+
+    bool grow, prefix;
+    int8_t m = _match(&grow, &prefix);
+    for (uint8_t i = 0; i < _buffered; i++)
+    {
+        const KB_EVENT& b = _buffer[i];
+        if (b.usage == 0)
+        {
+            _mods = b.mods;
+            _emit(0, b.mods, b.pressed, b.time_ms);
+        }
+        else if (m >= 0)
+        {
+            _setBIT(_swallow, b.usage);
+        }
+        else
+        {
+            _emit(b.usage, b.mods, b.pressed, b.time_ms);
+        }
+    }
+    _buffered = 0;
+    if (m >= 0)
+    {
+        _fire(m, now_ms);
+    }
+}
+
+void KeyComboClass::_fire(int8_t idx, uint32_t now_ms)
+{
+    const COMBO_DEF& d = _defs[idx];
+    _fired++;
+    if (d.kind == COMBO_KIND_KEY)
+    {
+        _emit(d.usage, _mods | d.mods, true, now_ms);
+        _emit(d.usage, _mods | d.mods, false, now_ms);
+    }
+    else if (d.text)
+    {
+        for (const char* p = d.text; *p; p++)
+        {
+            uint8_t h = asciiToHID(*p);
+            if (!h) continue;
+            uint8_t m = _mods | ((h & ASCII_HID_SHIFT) ? COMBO_LEFT_SHIFT : 0);
+            _emit(h & ASCII_HID_USAGE, m, true, now_ms);
+            _emit(h & ASCII_HID_USAGE, m, false, now_ms);
+        }
+    }
+    // put the host back on the physical modifier state
+    if (d.mods || d.kind == COMBO_KIND_TEXT)
+    {
+        _emit(0, _mods, true, now_ms);
+    }
+}
+
+void KeyComboClass::_emit(uint8_t usage, uint8_t mods, bool pressed, uint32_t now_ms)
+{
+    if (!_sink)
+    {
+        return;
+    }
+    KB_EVENT out { usage, mods, pressed, KB_SRC_NONE, now_ms };
+    _sink(out, _sink_arg);
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <stdint.h>
+#include "kb_event.h"
+#include "timer_wheel.h"
+
+// Chord/combo detection on the KB_EVENT stream, behind the layer engine.
+//
+// Every combo is precompiled into a 256-bit usage mask; the union of all masks says which keys
+// can start a combo. A press of any other key while no chord is open is forwarded immediately
+// (one bit test). A member key opens a chord window of COMBO_TERM_MS; the keys pressed inside it
+// are compared against the masks word by word. The chord fires as soon as it equals a mask that
+// no longer combo can extend, otherwise when the window closes, a non-member key is pressed or a
+// key is released. A chord that matches nothing is flushed downstream in its original order.
+// Usages are post-layer: a member key that an active layer turns into something else (J/K into
+// arrows under Fn) is no longer a member, so Fn+J+K sends the arrows, not the Esc combo.
+
+const uint8_t  COMBO_WORDS      = 8;      // 256 usages / 32
+const uint8_t  COMBO_MAX        = 16;
+const uint8_t  COMBO_MAX_KEYS   = 4;
+const uint8_t  COMBO_BUFFER     = 8;
+const uint16_t COMBO_TERM_MS    = 30;
+
+const uint8_t  COMBO_KIND_KEY   = 0;      // tap usage (+mods)
+const uint8_t  COMBO_KIND_TEXT  = 1;      // type an ASCII string
+
+typedef struct COMBO_DEF {
+    uint8_t     keys[COMBO_MAX_KEYS];     // 0-terminated when shorter
+    uint8_t     kind;
+    uint8_t     usage;
+    uint8_t     mods;
+    const char* text;
+} COMBO_DEF;
+
+class KeyComboClass {
+public:
+    KeyComboClass();
+    void begin(TimerWheelClass* wheel, KB_EVENT_SINK sink, void* sink_arg);
+    void onEVENT(const KB_EVENT& ev);
+    uint32_t firedCOUNT() const { return _fired; }
+private:
+    TimerWheelClass* _wheel;
+    KB_EVENT_SINK    _sink;
+    void*            _sink_arg;
+
+    const COMBO_DEF* _defs;
+    uint8_t          _count;
+    uint32_t         _masks[COMBO_MAX][COMBO_WORDS];
+    uint32_t         _member[COMBO_WORDS];     // union of all masks
+    uint32_t         _swallow[COMBO_WORDS];    // keys consumed by a fired combo, drop their release
+
+    // open chord
+    bool     _open;
+    uint32_t _chord[COMBO_WORDS];
+    int8_t   _timer;
+    KB_EVENT _buffer[COMBO_BUFFER];
+    uint8_t  _buffered;
+    uint8_t  _mods;                            // last modifier byte seen
+    uint32_t _fired;
+
+    static inline bool _testBIT(const uint32_t* set, uint8_t usage) { return (set[usage >> 5] >> (usage & 31)) & 1u; }
+    static inline void _setBIT(uint32_t* set, uint8_t usage)   { set[usage >> 5] |= (1u << (usage & 31)); }
+    static inline void _clearBIT(uint32_t* set, uint8_t usage) { set[usage >> 5] &= ~(1u << (usage & 31)); }
+
+    static void _onTIMER(void* owner, uint32_t tag, uint32_t now_ms);
+    int8_t _match(bool* can_grow, bool* is_prefix) const;
+    void _close(uint32_t now_ms);
+    void _fire(int8_t idx, uint32_t now_ms);
+    void _emit(uint8_t usage, uint8_t mods, bool pressed, uint32_t now_ms);
+};
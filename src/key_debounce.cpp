@@ -0,0 +1,221 @@
+// key_debounce.cpp
+#include "key_debounce.h"
+#include <string.h>
+
+const uint8_t DEBOUNCE_MOD_USAGE = 0xE0;
+
+KeyDebounceClass::KeyDebounceClass()
+    :   _mode(DEBOUNCE_OFF),
+        _window(DEBOUNCE_DEFAULT_MS),
+        _suppressed(0),
+        _n_keys(0)
+{
+    memset(_stamp, 0, sizeof(_stamp));
+    memset(_raw, 0, sizeof(_raw));
+    memset(_state, 0, sizeof(_state));
+    memset(_suppress, 0, sizeof(_suppress));
+    memset(_chatter, 0, sizeof(_chatter));
+    memset(_raw_keys, 0, sizeof(_raw_keys));
+    memset(_out_keys, 0, sizeof(_out_keys));
+}
+
+void KeyDebounceClass::setMODE(uint8_t mode)
+{
+    if (mode > DEBOUNCE_DEFER)
+    {
+        return;
+    }
+    // accepted state restarts from the raw state, nothing stays suppressed
+    memcpy(_state, _raw, sizeof(_state));
+    memset(_suppress, 0, sizeof(_suppress));
+    _mode = mode;
+}
+
+void KeyDebounceClass::resetSTATS()
+{
+    _suppressed = 0;
+    memset(_chatter, 0, sizeof(_chatter));
+}
+
+uint8_t KeyDebounceClass::worstKEY() const
+{
+    uint8_t worst = 0;
+    for (int k = 1; k < 256; k++)
+    {
+        if (_chatter[k] > _chatter[worst]) worst = (uint8_t)k;
+    }
+    return _chatter[worst] ? worst : 0;
+}
+
+void KeyDebounceClass::_expire(uint16_t now_ms)
+{
+    for (uint8_t w = 0; w < 8; w++)
+    {
+        uint32_t s = _suppress[w];
+        while (s)
+        {
+            const uint8_t b = __builtin_ctz(s);
+            s &= s - 1;
+            const uint8_t k = (uint8_t)(w * 32 + b);
+            if ((uint16_t)(now_ms - _stamp[k]) < _window) continue;
+
+            const uint32_t m = 1u << b;
+            if ((_state[w] ^ _raw[w]) & m)
+            {
+                // the window closed on a different raw state: that is the real one
+                _state[w] ^= m;
+                if (_mode == DEBOUNCE_EAGER)
+                {
+                    _stamp[k] = (uint16_t)(_stamp[k] + _window);   // new window from the expiry
+                    continue;
+                }
+            }
+            _suppress[w] &= ~m;
+        }
+    }
+}
+
+void KeyDebounceClass::_onEDGE(uint8_t k, uint16_t now_ms)
+{
+    const uint8_t w = k >> 5;
+    const uint32_t m = 1u << (k & 31);
+    const bool in_window = (_suppress[w] & m) && (uint16_t)(now_ms - _stamp[k]) < _window;
+    if (in_window)
+    {
+        _suppressed++;
+        if (_chatter[k] < 0xFF) _chatter[k]++;
+    }
+    if (_mode == DEBOUNCE_EAGER)
+    {
+        if (in_window) return;
+        _state[w] = (_state[w] & ~m) | (_raw[w] & m);
+    }
+    // DEFER: every edge restarts the stability window
+    _stamp[k] = now_ms;
+    _suppress[w] |= m;
+}
+
+static inline bool isORDERED(uint8_t k)
+{
+    return k >= 0x04 && !(k >= DEBOUNCE_MOD_USAGE && k < DEBOUNCE_MOD_USAGE + 8);
+}
+
+void KeyDebounceClass::_output(uint8_t* mods_out, uint8_t* keys_out)
+{
+    *mods_out = (uint8_t)(_state[DEBOUNCE_MOD_USAGE >> 5] & 0xFFu);
+    uint32_t done[8] = {0};
+    uint8_t out[DEBOUNCE_MAX_KEYS];
+    uint8_t n = 0;
+
+    // accepted keys in the keyboard's slot order
+    for (uint8_t i = 0; i < _n_keys; i++)
+    {
+        const uint8_t k = _raw_keys[i];
+        const uint32_t m = 1u << (k & 31);
+        if (!isORDERED(k) || !(_state[k >> 5] & m) || (done[k >> 5] & m)) continue;
+        done[k >> 5] |= m;
+        out[n++] = k;
+    }
+    // keys a window still holds down after the raw report released them go back to their slot
+    for (uint8_t i = 0; i < _n_keys && n < _n_keys; i++)
+    {
+        const uint8_t k = _out_keys[i];
+        const uint32_t m = 1u << (k & 31);
+        if (!isORDERED(k) || !(_state[k >> 5] & m) || (done[k >> 5] & m)) continue;
+        done[k >> 5] |= m;
+        const uint8_t at = i < n ? i : n;
+        memmove(out + at + 1, out + at, n - at);
+        out[at] = k;
+        n++;
+    }
+    for (uint8_t w = 0; w < 8 && n < _n_keys; w++)
+    {
+        uint32_t s = _state[w] & ~done[w];
+        if (w == (DEBOUNCE_MOD_USAGE >> 5)) s &= ~0xFFu;
+        while (s && n < _n_keys)
+        {
+            out[n++] = (uint8_t)(w * 32 + __builtin_ctz(s));
+            s &= s - 1;
+        }
+    }
+    memset(out + n, 0, _n_keys - n);
+    memcpy(_out_keys, out, _n_keys);
+    memcpy(keys_out, out, _n_keys);
+}
+
+void KeyDebounceClass::filter(uint8_t mods_in, const uint8_t* keys_in, uint8_t n_keys, uint16_t now_ms,
+                              uint8_t* mods_out, uint8_t* keys_out)
+{
+    if (n_keys > DEBOUNCE_MAX_KEYS)
+    {
+        n_keys = DEBOUNCE_MAX_KEYS;
+    }
+    uint32_t raw[8] = {0};
+    raw[DEBOUNCE_MOD_USAGE >> 5] = mods_in;
+    for (uint8_t i = 0; i < n_keys; i++)
+    {
+        // 0x00..0x03 are "no key" / error codes, not keys
+        if (keys_in[i] > 0x03) raw[keys_in[i] >> 5] |= 1u << (keys_in[i] & 31);
+    }
+
+    _n_keys = n_keys;
+    memcpy(_raw_keys, keys_in, n_keys);
+
+    if (_mode == DEBOUNCE_OFF)
+    {
+        // state is still tracked so a later setMODE() starts from it
+        memcpy(_raw, raw, sizeof(_raw));
+        memcpy(_state, raw, sizeof(_state));
+        memcpy(_out_keys, keys_in, n_keys);
+        if (keys_out != keys_in) memcpy(keys_out, keys_in, n_keys);
+        *mods_out = mods_in;
+        return;
+    }
+
+    // windows that closed before this report are settled against the previous raw state
+    _expire(now_ms);
+    for (uint8_t w = 0; w < 8; w++)
+    {
+        uint32_t e = raw[w] ^ _raw[w];
+        _raw[w] = raw[w];
+        while (e)
+        {
+            const uint8_t b = __builtin_ctz(e);
+            e &= e - 1;
+            _onEDGE((uint8_t)(w * 32 + b), now_ms);
+        }
+    }
+    _output(mods_out, keys_out);
+}
+
+void KeyDebounceClass::recheck(uint16_t now_ms, uint8_t n_keys, uint8_t* mods_out, uint8_t* keys_out)
+{
+    _expire(now_ms);
+    if (n_keys != _n_keys)
+    {
+        // no report seen with this width yet: nothing to keep the order of
+        memset(_raw_keys, 0, sizeof(_raw_keys));
+        memset(_out_keys, 0, sizeof(_out_keys));
+        _n_keys = n_keys > DEBOUNCE_MAX_KEYS ? DEBOUNCE_MAX_KEYS : n_keys;
+    }
+    _output(mods_out, keys_out);
+}
+
+uint32_t KeyDebounceClass::msUntilRECHECK(uint16_t now_ms) const
+{
+    uint32_t best = DEBOUNCE_IDLE;
+    for (uint8_t w = 0; w < 8; w++)
+    {
+        // only keys that still disagree with the raw report need a wake-up
+        uint32_t s = _suppress[w] & (_state[w] ^ _raw[w]);
+        while (s)
+        {
+            const uint8_t k = (uint8_t)(w * 32 + __builtin_ctz(s));
+            s &= s - 1;
+            uint16_t age = (uint16_t)(now_ms - _stamp[k]);
+            uint32_t left = (age >= _window) ? 0 : (uint32_t)(_window - age);
+            if (left < best) best = left;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <stdint.h>
+
+// Per-key debounce / chatter filter for the report diff.
+//
+// State is kept per HID usage: a 16-bit timestamp of the last accepted (eager) or observed
+// (deferred) edge, and bitmaps of the raw, accepted and under-suppression keys. Modifiers take
+// part as usages 0xE0..0xE7. Only keys whose raw bit flipped are visited, so the cost per
+// report is O(changed keys) plus a word scan of the small suppression set.
+//   EAGER - an edge is passed on at once, further edges of that key inside the window are
+//           suppressed; a difference left at the end of the window is applied then.
+//   DEFER - an edge is only accepted once the key has been stable for the window.
+// When a suppressed key still differs from its raw state, the caller must call recheck()
+// within msUntilRECHECK(), since boot keyboards only report on change.
+// OFF passes the report through untouched. The filtering modes keep the keyboard's slot order:
+// keys come out in the order of the last raw report, a key held down by its window where it
+// was in the previous output, so rollover and the diff see the report the keyboard meant.
+
+const uint8_t  DEBOUNCE_OFF         = 0;
+const uint8_t  DEBOUNCE_EAGER       = 1;
+const uint8_t  DEBOUNCE_DEFER       = 2;
+const uint16_t DEBOUNCE_DEFAULT_MS  = 5;
+const uint32_t DEBOUNCE_IDLE        = 0xFFFFFFFFu;
+const uint8_t  DEBOUNCE_MAX_KEYS    = 32;       // widest key array filter() takes
+
+class KeyDebounceClass {
+public:
+    KeyDebounceClass();
+    void setMODE(uint8_t mode);
+    void setWINDOW(uint16_t ms) { _window = ms ? ms : 1; }
+    uint8_t  mode() const { return _mode; }
+    uint16_t window() const { return _window; }
+
+    // raw report in, filtered report out (n_keys slots each)
+    void filter(uint8_t mods_in, const uint8_t* keys_in, uint8_t n_keys, uint16_t now_ms,
+                uint8_t* mods_out, uint8_t* keys_out);
+    // re-evaluate expired windows against the last raw report
+    void recheck(uint16_t now_ms, uint8_t n_keys, uint8_t* mods_out, uint8_t* keys_out);
+    uint32_t msUntilRECHECK(uint16_t now_ms) const;
+
+    // chatter statistics
+    uint32_t suppressedCOUNT() const { return _suppressed; }
+    uint8_t  chatterCOUNT(uint8_t usage) const { return _chatter[usage]; }
+    uint8_t  worstKEY() const;              // usage with the most suppressed edges, 0 if none
+    void     resetSTATS();
+private:
+    uint8_t  _mode;
+    uint16_t _window;
+    uint16_t _stamp[256];
+    uint32_t _raw[8];
+    uint32_t _state[8];
+    uint32_t _suppress[8];
+    uint32_t _suppressed;
+    uint8_t  _chatter[256];
+    uint8_t  _raw_keys[DEBOUNCE_MAX_KEYS];      // last raw key array, in slot order
+    uint8_t  _out_keys[DEBOUNCE_MAX_KEYS];      // last filtered key array
+    uint8_t  _n_keys;
+
+    void _expire(uint16_t now_ms);
+    void _onEDGE(uint8_t k, uint16_t now_ms);
+    void _output(uint8_t* mods_out, uint8_t* keys_out);
+};
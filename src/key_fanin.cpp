@@ -0,0 +1,122 @@
+// key_fanin.cpp
+#include "key_fanin.h"
+#include <string.h>
+
+const uint8_t FANIN_ROLLOVER    = 0x01;     // HID ErrorRollOver
+const uint8_t FANIN_FIRST_KEY   = 0x04;     // 0x00..0x03 are "no key" / error codes
+
+KeyFanInClass::KeyFanInClass()
+    :   _attached(0),
+        _depth(0)
+{
+    memset(_mods, 0, sizeof(_mods));
+    memset(_keys, 0, sizeof(_keys));
+    memset(_refused, 0, sizeof(_refused));
+    memset(_refused_keys, 0, sizeof(_refused_keys));
+    for (uint8_t i = 0; i < USB_MAX_DEVICES; i++)
+    {
+        _inflight[i].store(0);
+    }
+}
+
+void KeyFanInClass::attach(uint8_t dev)
+{
+    if (dev >= USB_MAX_DEVICES)
+    {
+        return;
+    }
+    _mods[dev] = 0;
+    memset(_keys[dev], 0, FANIN_KEYS_PER_DEV);
+    _refused[dev] = 0;
+    _attached.fetch_or((uint8_t)(1u << dev));
+}
+
+void KeyFanInClass::detach(uint8_t dev)
+{
+    if (dev >= USB_MAX_DEVICES)
+    {
+        return;
+    }
+    _attached.fetch_and((uint8_t)~(1u << dev));
+}
+
+uint8_t KeyFanInClass::count() const
+{
+    return (uint8_t)__builtin_popcount(_attached.load());
+}
+
+void KeyFanInClass::update(uint8_t dev, uint8_t mods, const uint8_t* keys)
+{
+    if (dev >= USB_MAX_DEVICES)
+    {
+        return;
+    }
+    _mods[dev] = mods;
+    if (keys[0] != FANIN_ROLLOVER)
+    {
+        memcpy(_keys[dev], keys, FANIN_KEYS_PER_DEV);
+    }
+}
+
+void KeyFanInClass::merged(uint8_t* mods_out, uint8_t* keys_out) const
+{
+    uint32_t seen[8] = {0};
+    uint8_t mods = 0;
+    uint8_t n = 0;
+    memset(keys_out, 0, FANIN_MAX_KEYS);
+    const uint8_t attached = _attached.load();
+    for (uint8_t d = 0; d < USB_MAX_DEVICES; d++)
+    {
+        if (!(attached & (1u << d))) continue;
+        mods |= _mods[d];
+        for (uint8_t i = 0; i < FANIN_KEYS_PER_DEV; i++)
+        {
+            const uint8_t k = _keys[d][i];
+            if (k < FANIN_FIRST_KEY || (seen[k >> 5] & (1u << (k & 31)))) continue;
+            seen[k >> 5] |= 1u << (k & 31);
+            keys_out[n++] = k;
+        }
+    }
+    *mods_out = mods;
+}
+
+uint16_t KeyFanInClass::share() const
+{
+    if (_depth <= FANIN_RELEASE_RESERVE)
+    {
+        return 1;
+    }
+    uint8_t n = count();
+    return (uint16_t)((_depth - FANIN_RELEASE_RESERVE) / (n ? n : 1));
+}
+
+bool KeyFanInClass::admit(uint8_t dev, uint8_t usage, bool pressed)
+{
+    const uint32_t bit = 1u << (usage & 31);
+    if (usage && !pressed && (_refused_keys[usage >> 5] & bit))
+    {
+        _refused_keys[usage >> 5] &= ~bit;
+        return false;
+    }
+    if (dev >= USB_MAX_DEVICES)
+    {
+        return true;
+    }
+    if (usage && pressed && _inflight[dev].load() >= share())
+    {
+        _refused[dev]++;
+        _refused_keys[usage >> 5] |= bit;
+        return false;
+    }
+    _inflight[dev]++;
+    return true;
+}
+
+void KeyFanInClass::done(uint8_t dev)
+{
+    if (dev >= USB_MAX_DEVICES)
+    {
+        return;
+    }
+    _inflight[dev]--;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include "report_filter.h"
+#include "kb_event.h"
+
+// Fan-in of several boot keyboards (e.g. behind a USB hub) into one logical keyboard.
+//
+// Every keyboard interface keeps its own last report in the slot ReportFilterClass gave it. The
+// logical report is the OR of all modifier bytes and the union of all key arrays, so a key held
+// on two keyboards is released only when the last of them lets go, and a modifier held on one
+// keyboard stays down while another types. An ErrorRollOver report keeps the device's previous
+// keys (boot protocol: "too many keys", not "all released"). The merged report is wider than a
+// boot report (FANIN_MAX_KEYS) and goes through debounce, remap and diff like a single one did.
+//
+// KBQueue fairness: every event the diff enqueues carries the slot whose report produced it.
+// Presses from one device may occupy at most an equal share of the queue, minus a reserve
+// that only releases and modifier changes use, so a chattering device loses its own presses
+// instead of crowding out another keyboard's keys and everyone's releases. The release of a
+// refused press is dropped as well, it would only take queue space for a key the host never
+// saw go down. admit() runs under the diff mutex, done() on the BLE task when the event leaves
+// the queue.
+
+const uint8_t  FANIN_KEYS_PER_DEV       = 6;        // boot report key array
+const uint8_t  FANIN_MAX_KEYS           = USB_MAX_DEVICES * FANIN_KEYS_PER_DEV;
+const uint16_t FANIN_RELEASE_RESERVE    = 16;       // queue entries kept for releases
+
+class KeyFanInClass {
+public:
+    KeyFanInClass();
+    void setQUEUE(uint16_t depth) { _depth = depth; }
+    void attach(uint8_t dev);                   // a keyboard interface opened in slot dev
+    void detach(uint8_t dev);                   // after update(dev, 0, no keys) released its keys
+    uint8_t count() const;
+
+    // replace the device's report (FANIN_KEYS_PER_DEV keys)
+    void update(uint8_t dev, uint8_t mods, const uint8_t* keys);
+    // logical report: FANIN_MAX_KEYS keys, zero padded
+    void merged(uint8_t* mods_out, uint8_t* keys_out) const;
+
+    // KBQueue admission; releases and modifier changes (usage 0) are only dropped for refused presses
+    bool admit(uint8_t dev, uint8_t usage, bool pressed);
+    void done(uint8_t dev);                     // the admitted event left the queue or was not queued
+    uint16_t share() const;                     // events a device may have queued before its presses are refused
+    uint16_t inFLIGHT(uint8_t dev) const { return dev < USB_MAX_DEVICES ? _inflight[dev].load() : 0; }
+    uint32_t refused(uint8_t dev) const { return dev < USB_MAX_DEVICES ? _refused[dev] : 0; }
+private:
+    std::atomic<uint8_t>  _attached;            // bit per slot
+    uint16_t              _depth;
+    uint8_t               _mods[USB_MAX_DEVICES];
+    uint8_t               _keys[USB_MAX_DEVICES][FANIN_KEYS_PER_DEV];
+    std::atomic<uint16_t> _inflight[USB_MAX_DEVICES];
+    uint32_t              _refused[USB_MAX_DEVICES];
+    uint32_t              _refused_keys[8];     // usages whose press was refused, release pending
+};
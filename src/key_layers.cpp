@@ -0,0 +1,275 @@
+// key_layers.cpp
+#include "key_layers.h"
+#include <string.h>
+
+typedef struct LAYER_PAIR {
+    uint8_t from;
+    uint8_t to;
+} LAYER_PAIR;
+
+// layer 1 (Fn): number row -> F1..F12, HJKL -> arrows, Backspace -> Delete, macro keys
+static constexpr LAYER_PAIR FN_LAYER_PAIRS[] = {
+    {0x1E, 0x3A}, {0x1F, 0x3B}, {0x20, 0x3C}, {0x21, 0x3D}, {0x22, 0x3E}, {0x23, 0x3F},
+    {0x24, 0x40}, {0x25, 0x41}, {0x26, 0x42}, {0x27, 0x43}, {0x2D, 0x44}, {0x2E, 0x45},
+    {0x0B, 0x50}, // H -> Left
+    {0x0D, 0x51}, // J -> Down
+    {0x0E, 0x52}, // K -> Up
+    {0x0F, 0x4F}, // L -> Right
+    {0x2A, 0x4C}, // Backspace -> Delete
+    {0x14, 0xA5}, {0x1A, 0xA6}, {0x08, 0xA7}, {0x15, 0xA8},   // Q W E R -> macro REC 0..3
+    {0x04, 0xA9}, {0x16, 0xAA}, {0x07, 0xAB}, {0x09, 0xAC},   // A S D F -> macro PLAY 0..3
+};
+
+static constexpr TAP_HOLD_DEF DEFAULT_TAP_HOLD[] = {
+    {0x2C, 0x2C, HOLD_KIND_LAYER, 1},   // Space: tap Space, hold Fn
+};
+
+KeyLayerClass::KeyLayerClass()
+    :   _wheel(nullptr),
+        _sink(nullptr),
+        _sink_arg(nullptr),
+        _term_ms(TAP_HOLD_TERM_MS),
+        _def_count(0),
+        _layer_mask(0x01),
+        _hold_mods(0),
+        _phys_mods(0),
+        _pending(false),
+        _pending_usage(0),
+        _pending_mods(0),
+        _pending_timer(-1),
+        _buffered(0),
+        _q_head(0),
+        _q_count(0)
+{
+    memset(_layer_map, LAYER_TRNS, sizeof(_layer_map));
+    memset(_tap_hold_idx, 0xFF, sizeof(_tap_hold_idx));
+    memset(_pressed_as, 0, sizeof(_pressed_as));
+    memset(_held_def, 0xFF, sizeof(_held_def));
+    memset(_tap_sent, 0, sizeof(_tap_sent));
+
+    for (uint8_t i = 0; i < sizeof(FN_LAYER_PAIRS) / sizeof(FN_LAYER_PAIRS[0]); i++)
+    {
+        _layer_map[1][FN_LAYER_PAIRS[i].from] = FN_LAYER_PAIRS[i].to;
+    }
+    for (uint8_t i = 0; i < sizeof(DEFAULT_TAP_HOLD) / sizeof(DEFAULT_TAP_HOLD[0]) && i < TAP_HOLD_MAX; i++)
+    {
+        _defs[i] = DEFAULT_TAP_HOLD[i];
+        _tap_hold_idx[_defs[i].usage] = i;
+        _def_count++;
+    }
+}
+
+void KeyLayerClass::begin(TimerWheelClass* wheel, KB_EVENT_SINK sink, void* sink_arg)
+{
+    _wheel = wheel;
+    _sink = sink;
+    _sink_arg = sink_arg;
+}
+
+void KeyLayerClass::onEVENT(const KB_EVENT& ev)
+{
+    if (_q_count >= LAYER_QUEUE)
+    {
+        return;     // cannot happen with LAYER_QUEUE >= 2 * LAYER_BUFFER; drop rather than corrupt
+    }
+    _queue[(_q_head + _q_count) & (LAYER_QUEUE - 1)] = ev;
+    _q_count++;
+    _pump();
+}
+
+void KeyLayerClass::_pushFRONT(const KB_EVENT& ev)
+{
+    if (_q_count >= LAYER_QUEUE)
+    {
+        return;
+    }
+    _q_head = (_q_head - 1) & (LAYER_QUEUE - 1);
+    _queue[_q_head] = ev;
+    _q_count++;
+}
+
+void KeyLayerClass::_pump()
+{
+    while (_q_count)
+    {
+        KB_EVENT ev = _queue[_q_head];
+        _q_head = (_q_head + 1) & (LAYER_QUEUE - 1);
+        _q_count--;
+        _step(ev);
+    }
+}
+
+void KeyLayerClass::_step(const KB_EVENT& ev)
+{
+    if (_pending)
+    {
+        if (!ev.pressed && ev.usage == _pending_usage)
+        {
+            _resolve(false, &ev, ev.time_ms);
+            return;
+        }
+        // permissive hold: a key pressed after the tap-hold key was also released already.
+        // A key the hold layer leaves transparent comes out the same either way, so a fast
+        // Space-N roll keeps waiting and is decided by the Space release (tap) or the term
+        if (!ev.pressed && ev.usage != 0 && _holdCHANGES(ev.usage))
+        {
+            for (uint8_t i = 0; i < _buffered; i++)
+            {
+                if (_buffer[i].pressed && _buffer[i].usage == ev.usage)
+                {
+                    _resolve(true, &ev, ev.time_ms);
+                    return;
+                }
+            }
+        }
+        if (_buffered < LAYER_BUFFER)
+        {
+            _buffer[_buffered++] = ev;
+            return;
+        }
+        _resolve(true, &ev, ev.time_ms);
+        return;
+    }
+
+    if (ev.usage != 0 && _tap_hold_idx[ev.usage] != 0xFF)
+    {
+        const uint8_t u = ev.usage;
+        if (ev.pressed)
+        {
+            int8_t h = _wheel ? _wheel->schedule(ev.time_ms + _term_ms, _onTIMER, this, u) : -1;
+            if (h < 0)
+            {
+                // no timer slot: degrade to a plain tap key rather than leave it undecided
+                _tap_sent[u] = _defs[_tap_hold_idx[u]].tap_usage;
+                _emit(_tap_sent[u], ev.mods, true, ev.time_ms);
+                return;
+            }
+            _pending = true;
+            _pending_usage = u;
+            _pending_mods = ev.mods;
+            _pending_timer = h;
+            _buffered = 0;
+            return;
+        }
+        if (_held_def[u] != 0xFF)
+        {
+            _applyHOLD(_held_def[u], false, ev.time_ms);
+            _held_def[u] = 0xFF;
+        }
+        else if (_tap_sent[u])
+        {
+            _emit(_tap_sent[u], ev.mods, false, ev.time_ms);
+            _tap_sent[u] = 0;
+        }
+        return;
+    }
+    _process(ev);
+}
+
+bool KeyLayerClass::_holdCHANGES(uint8_t usage) const
+{
+    const TAP_HOLD_DEF& d = _defs[_tap_hold_idx[_pending_usage]];
+    if (d.hold_kind != HOLD_KIND_LAYER)
+    {
+        return true;
+    }
+    return d.hold_value < LAYER_COUNT && _layer_map[d.hold_value][usage] != LAYER_TRNS;
+}
+
+void KeyLayerClass::_resolve(bool hold, const KB_EVENT* trigger, uint32_t now_ms)
+{
+    if (_pending_timer >= 0 && _wheel)
+    {
+        _wheel->cancel(_pending_timer);
+    }
+    _pending_timer = -1;
+    _pending = false;
+
+    const uint8_t u = _pending_usage;
+    const uint8_t d = _tap_hold_idx[u];
+    if (hold)
+    {
+        _held_def[u] = d;
+        _applyHOLD(d, true, now_ms);
+    }
+    else
+    {
+        _tap_sent[u] = _defs[d].tap_usage;
+        _emit(_tap_sent[u], _pending_mods, true, now_ms);
+    }
+
+    // re-run the trigger and everything buffered behind the pending key, oldest first
+    if (trigger)
+    {
+        _pushFRONT(*trigger);
+    }
+    for (uint8_t i = _buffered; i-- > 0;)
+    {
+        _pushFRONT(_buffer[i]);
+    }
+    _buffered = 0;
+}
+
+void KeyLayerClass::_onTIMER(void* owner, uint32_t tag, uint32_t now_ms)
+{
+    KeyLayerClass* self = static_cast<KeyLayerClass*>(owner);
+    if (!self->_pending || tag != self->_pending_usage)
+    {
+        return;
+    }
+    self->_pending_timer = -1;     // the wheel already released this handle
+    self->_resolve(true, nullptr, now_ms);
+    self->_pump();
+}
+
+void KeyLayerClass::_applyHOLD(uint8_t def, bool on, uint32_t now_ms)
+{
+    const TAP_HOLD_DEF& d = _defs[def];
+    if (d.hold_kind == HOLD_KIND_LAYER)
+    {
+        if (on) _layer_mask |= (uint8_t)(1u << d.hold_value);
+        else    _layer_mask &= (uint8_t)~(1u << d.hold_value);
+        _layer_mask |= 0x01;
+        return;
+    }
+    if (on) _hold_mods |= d.hold_value;
+    else    _hold_mods &= (uint8_t)~d.hold_value;
+    _emit(0, _phys_mods, true, now_ms);
+}
+
+void KeyLayerClass::_process(const KB_EVENT& ev)
+{
+    _phys_mods = ev.mods;
+    if (ev.usage == 0)
+    {
+        _emit(0, ev.mods, ev.pressed, ev.time_ms);
+        return;
+    }
+    if (ev.pressed)
+    {
+        uint8_t out = ev.usage;
+        for (uint8_t l = LAYER_COUNT - 1; l >= 1; l--)
+        {
+            if (!(_layer_mask & (1u << l))) continue;
+            uint8_t t = _layer_map[l][ev.usage];
+            if (t != LAYER_TRNS) { out = t; break; }
+        }
+        _pressed_as[ev.usage] = out;
+        _emit(out, ev.mods, true, ev.time_ms);
+        return;
+    }
+    // release what was actually pressed, even if the layer changed in between
+    uint8_t out = _pressed_as[ev.usage] ? _pressed_as[ev.usage] : ev.usage;
+    _pressed_as[ev.usage] = 0;
+    _emit(out, ev.mods, false, ev.time_ms);
+}
+
+void KeyLayerClass::_emit(uint8_t usage, uint8_t mods, bool pressed, uint32_t now_ms)
+{
+    if (!_sink)
+    {
+        return;
+    }
+    KB_EVENT out { usage, (uint8_t)(mods | _hold_mods), pressed, KB_SRC_NONE, now_ms };
+    _sink(out, _sink_arg);
+}
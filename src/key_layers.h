@@ -0,0 +1,84 @@
+#pragma once
+#include <stdint.h>
+#include "kb_event.h"
+#include "timer_wheel.h"
+
+// QMK-style layers and tap-hold keys on top of the KB_EVENT stream.
+//
+// Plain keys go straight through (one table load per active layer), so they see no added
+// latency. A tap-hold key parks in a single pending slot and events that arrive after it are
+// buffered in order; the pending key resolves as
+//   TAP  - it is released before its term expires,
+//   HOLD - its term expires, or a key pressed after it is released first (permissive hold),
+// so its latency is bounded by the configured term. Permissive hold only counts keys the hold
+// changes: a key transparent on a layer hold (N under Space/Fn) waits for the release or term.
+// Deadlines live in the shared timer wheel. Everything is driven by the caller's clock, which
+// keeps the engine host-testable.
+
+const uint8_t LAYER_COUNT       = 4;
+const uint8_t LAYER_TRNS        = 0x00;   // layer table entry: fall through to the layer below
+const uint8_t LAYER_BUFFER      = 16;     // events held while a tap-hold key is undecided
+const uint8_t LAYER_QUEUE       = 32;     // input fifo, power of two, >= 2 * LAYER_BUFFER
+const uint8_t TAP_HOLD_MAX      = 8;
+const uint16_t TAP_HOLD_TERM_MS = 200;
+
+// what a tap-hold key does when held
+const uint8_t HOLD_KIND_LAYER   = 0;
+const uint8_t HOLD_KIND_MODS    = 1;
+
+typedef struct TAP_HOLD_DEF {
+    uint8_t  usage;         // physical (post-remap) usage
+    uint8_t  tap_usage;     // sent on tap
+    uint8_t  hold_kind;     // HOLD_KIND_*
+    uint8_t  hold_value;    // layer number or modifier bits
+} TAP_HOLD_DEF;
+
+class KeyLayerClass {
+public:
+    KeyLayerClass();
+    void begin(TimerWheelClass* wheel, KB_EVENT_SINK sink, void* sink_arg);
+    void onEVENT(const KB_EVENT& ev);           // ev.time_ms is the engine clock
+    void setTapTERM(uint16_t ms) { _term_ms = ms; }
+    uint8_t activeLAYERS() const { return _layer_mask; }
+private:
+    TimerWheelClass* _wheel;
+    KB_EVENT_SINK    _sink;
+    void*            _sink_arg;
+    uint16_t         _term_ms;
+
+    uint8_t _layer_map[LAYER_COUNT][256];   // [0] unused, layer 0 is the identity
+    uint8_t _tap_hold_idx[256];             // index into _defs, 0xFF = plain key
+    TAP_HOLD_DEF _defs[TAP_HOLD_MAX];
+    uint8_t _def_count;
+
+    uint8_t _layer_mask;                    // bit n = layer n active (bit 0 always set)
+    uint8_t _hold_mods;                     // modifiers held by HOLD_KIND_MODS keys
+    uint8_t _phys_mods;                     // modifier byte of the last processed event
+    uint8_t _pressed_as[256];               // what each physical usage was sent as
+    uint8_t _held_def[256];                 // def index of keys currently resolved as HOLD
+    uint8_t _tap_sent[256];                 // tap usage sent for a resolved TAP, until release
+
+    // single undecided tap-hold key
+    bool     _pending;
+    uint8_t  _pending_usage;
+    uint8_t  _pending_mods;
+    int8_t   _pending_timer;
+    KB_EVENT _buffer[LAYER_BUFFER];
+    uint8_t  _buffered;
+
+    // input fifo; a resolution pushes the buffered events back to its front so they are
+    // re-evaluated in order without recursion
+    KB_EVENT _queue[LAYER_QUEUE];
+    uint8_t  _q_head;
+    uint8_t  _q_count;
+
+    static void _onTIMER(void* owner, uint32_t tag, uint32_t now_ms);
+    void _pump();
+    void _step(const KB_EVENT& ev);
+    bool _holdCHANGES(uint8_t usage) const;
+    void _resolve(bool hold, const KB_EVENT* trigger, uint32_t now_ms);
+    void _pushFRONT(const KB_EVENT& ev);
+    void _applyHOLD(uint8_t def, bool on, uint32_t now_ms);
+    void _process(const KB_EVENT& ev);
+    void _emit(uint8_t usage, uint8_t mods, bool pressed, uint32_t now_ms);
+};
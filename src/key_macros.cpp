@@ -0,0 +1,251 @@
+// key_macros.cpp
+#include "key_macros.h"
+#include <cstring>
+
+KeyMacroClass::KeyMacroClass()
+    :   _dirty(0),
+        _rec_slot(-1),
+        _rec_mods(0),
+        _rec_pending(0),
+        _play_slot(-1),
+        _play_pos(0),
+        _play_tap(0)
+{
+    memset(_len, 0, sizeof(_len));
+    memset(&_report, 0, sizeof(_report));
+    for (uint8_t s = 0; s < MACRO_SLOTS; s++)
+    {
+        _gen[s].store(0);
+    }
+}
+
+bool KeyMacroClass::loadSLOT(uint8_t slot, const uint8_t* data, uint16_t len)
+{
+    if (slot >= MACRO_SLOTS || len > MACRO_MAX_BYTES || recording() || playing())
+    {
+        return false;
+    }
+    memcpy(_data[slot], data, len);
+    _len[slot] = len;
+    return true;
+}
+
+bool KeyMacroClass::copySLOT(uint8_t slot, uint8_t* out, uint16_t* len) const
+{
+    if (slot >= MACRO_SLOTS)
+    {
+        return false;
+    }
+    const uint32_t gen = _gen[slot].load();
+    if (gen & 1)
+    {
+        return false;
+    }
+    const uint16_t n = _len[slot];
+    memcpy(out, _data[slot], n);
+    *len = n;
+    return _gen[slot].load() == gen;
+}
+
+// ----------------- recording -----------------
+bool KeyMacroClass::startRECORD(uint8_t slot)
+{
+    if (slot >= MACRO_SLOTS || playing())
+    {
+        return false;
+    }
+    _gen[slot]++;                               // odd: copySLOT() keeps off
+    _rec_slot = slot;
+    _len[slot] = 0;
+    _rec_mods = 0;
+    _rec_pending = 0;
+    return true;
+}
+
+void KeyMacroClass::stopRECORD()
+{
+    if (_rec_slot < 0)
+    {
+        return;
+    }
+    // a key still down when recording stops is stored as a tap
+    if (_rec_pending)
+    {
+        _put(_rec_pending);
+        _rec_pending = 0;
+    }
+    const uint8_t slot = _rec_slot;
+    _rec_slot = -1;
+    _gen[slot]++;
+    // the flash write is left to the caller's low-priority task, not the key path
+    _dirty.fetch_or((uint8_t)(1u << slot));
+}
+
+bool KeyMacroClass::_put(uint8_t b)
+{
+    uint16_t& n = _len[_rec_slot];
+    if (n >= MACRO_MAX_BYTES)
+    {
+        return false;
+    }
+    _data[_rec_slot][n++] = b;
+    return true;
+}
+
+bool KeyMacroClass::_put2(uint8_t op, uint8_t arg)
+{
+    // both bytes or neither, so a full slot never ends in half an opcode
+    if (_len[_rec_slot] + 2 > MACRO_MAX_BYTES)
+    {
+        return false;
+    }
+    _put(op);
+    _put(arg);
+    return true;
+}
+
+void KeyMacroClass::_flushPENDING()
+{
+    if (_rec_pending)
+    {
+        _put2(MACRO_OP_PRESS, _rec_pending);
+        _rec_pending = 0;
+    }
+}
+
+void KeyMacroClass::recordEVENT(const KB_EVENT& ev)
+{
+    if (_rec_slot < 0)
+    {
+        return;
+    }
+    if (_len[_rec_slot] + 3 > MACRO_MAX_BYTES)
+    {
+        stopRECORD();       // slot full: keep what fits
+        return;
+    }
+    if (ev.usage == 0)
+    {
+        if (ev.mods != _rec_mods)
+        {
+            _flushPENDING();
+            _put2(MACRO_OP_MODS, ev.mods);
+            _rec_mods = ev.mods;
+        }
+        return;
+    }
+    if (ev.usage < MACRO_OP_FIRST_TAP || isKbACTION(ev.usage))
+    {
+        return;
+    }
+    if (ev.pressed)
+    {
+        _flushPENDING();
+        if (ev.mods != _rec_mods)
+        {
+            _put2(MACRO_OP_MODS, ev.mods);
+            _rec_mods = ev.mods;
+        }
+        _rec_pending = ev.usage;
+        return;
+    }
+    // release events carry the modifier byte from before the report, so mods are ignored here
+    if (_rec_pending == ev.usage)
+    {
+        _put(ev.usage);
+        _rec_pending = 0;
+        return;
+    }
+    _flushPENDING();
+    _put2(MACRO_OP_RELEASE, ev.usage);
+}
+
+// ----------------- playback -----------------
+bool KeyMacroClass::startPLAYBACK(uint8_t slot)
+{
+    if (slot >= MACRO_SLOTS || recording() || playing() || !_len[slot])
+    {
+        return false;
+    }
+    _play_slot = slot;
+    _play_pos = 0;
+    _play_tap = 0;
+    memset(&_report, 0, sizeof(_report));
+    return true;
+}
+
+void KeyMacroClass::stopPLAYBACK()
+{
+    _play_slot = -1;
+    _play_tap = 0;
+    memset(&_report, 0, sizeof(_report));
+}
+
+void KeyMacroClass::_addKEY(uint8_t usage)
+{
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        if (_report.keys[i] == usage) return;
+    }
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        if (_report.keys[i] == 0) { _report.keys[i] = usage; return; }
+    }
+}
+
+void KeyMacroClass::_removeKEY(uint8_t usage)
+{
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        if (_report.keys[i] == usage) _report.keys[i] = 0;
+    }
+}
+
+bool KeyMacroClass::nextREPORT(KB_REPORT* out)
+{
+    if (_play_slot < 0)
+    {
+        return false;
+    }
+    // second half of a tap: the release always gets its own report, so "ll" cannot merge
+    if (_play_tap)
+    {
+        _removeKEY(_play_tap);
+        _play_tap = 0;
+        *out = _report;
+        return true;
+    }
+
+    const uint8_t* d = _data[_play_slot];
+    const uint16_t n = _len[_play_slot];
+    while (_play_pos < n)
+    {
+        uint8_t op = d[_play_pos++];
+        if (op == MACRO_OP_MODS || op == MACRO_OP_PRESS || op == MACRO_OP_RELEASE)
+        {
+            if (_play_pos >= n) break;
+            uint8_t arg = d[_play_pos++];
+            if (op == MACRO_OP_MODS)
+            {
+                _report.mods = arg;     // folded into the next key report, saves a notification
+                continue;
+            }
+            if (op == MACRO_OP_PRESS) _addKEY(arg);
+            else                      _removeKEY(arg);
+            *out = _report;
+            return true;
+        }
+        if (op >= MACRO_OP_FIRST_TAP)
+        {
+            _addKEY(op);
+            _play_tap = op;
+            *out = _report;
+            return true;
+        }
+    }
+
+    // end of stream: everything up, playback done
+    stopPLAYBACK();
+    *out = _report;
+    return true;
+}
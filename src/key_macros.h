@@ -0,0 +1,72 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include "kb_event.h"
+
+// On-device macro recorder / player.
+//
+// Recording taps the processed KB_EVENT stream (after layers and combos) and encodes it as a
+// byte stream where the common case - a key pressed and released with nothing in between -
+// costs one byte:
+//   0x00 M   modifier byte becomes M
+//   0x01 U   press U
+//   0x02 U   release U
+//   U        tap U (U >= 0x04; 0x00..0x03 are not key usages in HID)
+// Slots are kept in RAM; this class never touches flash, so it builds on the host. A recording
+// that closes marks its slot dirty and MacroStoreClass (macro_store.h) writes it to NVS from a
+// low-priority task. Playback decodes to whole boot reports one at a time; the caller decides
+// when the link can take the next one.
+
+const uint8_t  MACRO_SLOTS          = 4;
+const uint16_t MACRO_MAX_BYTES      = 256;
+
+const uint8_t  MACRO_OP_MODS        = 0x00;
+const uint8_t  MACRO_OP_PRESS       = 0x01;
+const uint8_t  MACRO_OP_RELEASE     = 0x02;
+const uint8_t  MACRO_OP_FIRST_TAP   = 0x04;
+
+class KeyMacroClass {
+public:
+    KeyMacroClass();
+    bool loadSLOT(uint8_t slot, const uint8_t* data, uint16_t len);    // at boot, before any event
+
+    // recording
+    bool startRECORD(uint8_t slot);
+    void stopRECORD();                          // closes the stream and marks the slot dirty
+    bool recording() const { return _rec_slot >= 0; }
+    void recordEVENT(const KB_EVENT& ev);
+
+    // playback
+    bool startPLAYBACK(uint8_t slot);
+    void stopPLAYBACK();
+    bool playing() const { return _play_slot >= 0; }
+    bool nextREPORT(KB_REPORT* out);            // the last report is all-up and ends playback
+    uint16_t slotLENGTH(uint8_t slot) const { return slot < MACRO_SLOTS ? _len[slot] : 0; }
+
+    // persistence, from another task: takeDIRTY() hands out the slots to save and clears them,
+    // copySLOT() fails while the slot is being recorded or was re-recorded during the copy
+    uint8_t takeDIRTY() { return _dirty.exchange(0); }
+    void    markDIRTY(uint8_t mask) { _dirty.fetch_or(mask); }
+    bool    dirty() const { return _dirty.load() != 0; }
+    bool    copySLOT(uint8_t slot, uint8_t* out, uint16_t* len) const;
+private:
+    uint8_t  _data[MACRO_SLOTS][MACRO_MAX_BYTES];
+    uint16_t _len[MACRO_SLOTS];
+    std::atomic<uint32_t> _gen[MACRO_SLOTS];    // odd while the slot is being recorded
+    std::atomic<uint8_t>  _dirty;               // bit per slot, closed but not saved
+
+    int8_t   _rec_slot;
+    uint8_t  _rec_mods;
+    uint8_t  _rec_pending;                      // press not written yet, may become a tap
+
+    int8_t   _play_slot;
+    uint16_t _play_pos;
+    uint8_t  _play_tap;                         // key whose release is the next report
+    KB_REPORT _report;
+
+    bool _put(uint8_t b);
+    bool _put2(uint8_t op, uint8_t arg);
+    void _flushPENDING();
+    void _addKEY(uint8_t usage);
+    void _removeKEY(uint8_t usage);
+};
@@ -0,0 +1,271 @@
+// key_remap.cpp
+#include "key_remap.h"
+#include <cstring>
+
+#define REMAP_PREF_NAMESPACE    "KEYREMAP_V1"      // NVS namespaces are limited to 15 chars
+
+// physical QWERTY position -> usage the host should see
+static constexpr REMAP_PAIR COLEMAK_PAIRS[] = {
+    {0x08, 0x09}, // E -> F
+    {0x15, 0x13}, // R -> P
+    {0x17, 0x0A}, // T -> G
+    {0x1C, 0x0D}, // Y -> J
+    {0x18, 0x0F}, // U -> L
+    {0x0C, 0x18}, // I -> U
+    {0x12, 0x1C}, // O -> Y
+    {0x13, 0x33}, // P -> ;
+    {0x16, 0x15}, // S -> R
+    {0x07, 0x16}, // D -> S
+    {0x09, 0x17}, // F -> T
+    {0x0A, 0x07}, // G -> D
+    {0x0D, 0x11}, // J -> N
+    {0x0E, 0x08}, // K -> E
+    {0x0F, 0x0C}, // L -> I
+    {0x33, 0x12}, // ; -> O
+    {0x11, 0x0E}, // N -> K
+};
+
+static constexpr REMAP_PAIR CAPS_TO_CTRL_PAIRS[] = {
+    {0x39, 0xE0}, // Caps Lock -> Left Control
+};
+
+static constexpr REMAP_PAIR SWAP_ALT_GUI_PAIRS[] = {
+    {0xE2, 0xE3}, {0xE3, 0xE2},   // left  Alt <-> GUI
+    {0xE6, 0xE7}, {0xE7, 0xE6},   // right Alt <-> GUI
+};
+
+typedef struct REMAP_LAYOUT_DESC {
+    const char* name;
+    const REMAP_PAIR* pairs;
+    uint8_t count;
+} REMAP_LAYOUT_DESC;
+
+static constexpr REMAP_LAYOUT_DESC REMAP_LAYOUTS[REMAP_LAYOUT_COUNT] = {
+    {"QWERTY",  nullptr,       0},
+    {"COLEMAK", COLEMAK_PAIRS, sizeof(COLEMAK_PAIRS) / sizeof(COLEMAK_PAIRS[0])},
+};
+
+static void _applyPAIRS(uint8_t* table, const uint8_t* base, const REMAP_PAIR* pairs, uint8_t count)
+{
+    // pairs are applied against the table as it was before this list, so swaps work
+    for (uint8_t i = 0; i < count; i++)
+    {
+        table[pairs[i].from] = base[pairs[i].to];
+    }
+}
+
+KeyRemapClass::KeyRemapClass()
+    :   _active(_tables[0]),
+        _lock(NULL),
+        _layout(REMAP_LAYOUT_QWERTY),
+        _options(0),
+        _override_count(0),
+        _prefs()
+{
+    for (int i = 0; i < 256; i++)
+    {
+        _tables[0][i] = (uint8_t)i;
+        _tables[1][i] = (uint8_t)i;
+    }
+}
+
+bool KeyRemapClass::begin()
+{
+    if (!_prefs.begin(REMAP_PREF_NAMESPACE, false))
+    {
+        Serial.println("KEYREMAP::PREFS::Open failed, using built-in QWERTY");
+        _compileTABLE();
+        return false;
+    }
+    _layout = _prefs.getUChar("layout", _layout);
+    _options = _prefs.getUChar("opts", _options);
+    if (_layout >= REMAP_LAYOUT_COUNT)
+    {
+        _layout = REMAP_LAYOUT_QWERTY;
+    }
+
+    // override blob is a packed array of REMAP_PAIR
+    size_t len = _prefs.getBytesLength("ovr");
+    if (len > 0 && len <= sizeof(_overrides) && (len % sizeof(REMAP_PAIR)) == 0)
+    {
+        _prefs.getBytes("ovr", _overrides, len);
+        // a blob written before overrides were validated may hold pairs that would map a key
+        // onto an error code or remap the error codes themselves; drop those
+        uint8_t kept = 0;
+        for (uint8_t i = 0; i < len / sizeof(REMAP_PAIR); i++)
+        {
+            if (validOVERRIDE(_overrides[i].from, _overrides[i].to))
+            {
+                _overrides[kept++] = _overrides[i];
+            }
+        }
+        if (kept != len / sizeof(REMAP_PAIR))
+        {
+            Serial.printf("KEYREMAP::PREFS::Dropped %u invalid overrides\n", (unsigned)(len / sizeof(REMAP_PAIR) - kept));
+        }
+        _override_count = kept;
+    }
+    _compileTABLE();
+    return true;
+}
+
+void KeyRemapClass::saveSETTINGS()
+{
+    _prefs.putUChar("layout", _layout);
+    _prefs.putUChar("opts", _options);
+    if (_override_count)
+    {
+        _prefs.putBytes("ovr", _overrides, _override_count * sizeof(REMAP_PAIR));
+    }
+    else
+    {
+        _prefs.remove("ovr");
+    }
+    Serial.println("KEYREMAP:Prefarance settings saved.");
+}
+
+void KeyRemapClass::setLAYOUT(uint8_t layout)
+{
+    if (layout >= REMAP_LAYOUT_COUNT)
+    {
+        return;
+    }
+    _layout = layout;
+    _compileTABLE();
+}
+
+void KeyRemapClass::setOPTIONS(uint8_t options)
+{
+    _options = options;
+    _compileTABLE();
+}
+
+// 0x00..0x03 in a report mean "no key" / rollover / POST fail / undefined: they can be neither
+// the source of an override nor its target, only 0 is accepted as "disable the key"
+bool KeyRemapClass::validOVERRIDE(uint8_t from, uint8_t to)
+{
+    return from >= REMAP_FIRST_KEY && (to == 0 || to >= REMAP_FIRST_KEY);
+}
+
+bool KeyRemapClass::setOVERRIDE(uint8_t from, uint8_t to)
+{
+    if (!validOVERRIDE(from, to))
+    {
+        return false;
+    }
+    for (uint8_t i = 0; i < _override_count; i++)
+    {
+        if (_overrides[i].from == from)
+        {
+            _overrides[i].to = to;
+            _compileTABLE();
+            return true;
+        }
+    }
+    if (_override_count >= REMAP_MAX_OVERRIDES)
+    {
+        return false;
+    }
+    _overrides[_override_count].from = from;
+    _overrides[_override_count].to = to;
+    _override_count++;
+    _compileTABLE();
+    return true;
+}
+
+void KeyRemapClass::clearOVERRIDES()
+{
+    _override_count = 0;
+    _compileTABLE();
+}
+
+const char* KeyRemapClass::layoutNAME(uint8_t layout)
+{
+    return layout < REMAP_LAYOUT_COUNT ? REMAP_LAYOUTS[layout].name : "?";
+}
+
+void KeyRemapClass::printCONFIG()
+{
+    Serial.println("----Key Remap Configuration----");
+    Serial.printf("Layout : %s\n", REMAP_LAYOUTS[_layout].name);
+    Serial.printf("Caps->Ctrl : %s\tSwap Alt/GUI : %s\n",
+                  (_options & REMAP_OPT_CAPS_TO_CTRL) ? "YES" : "NO",
+                  (_options & REMAP_OPT_SWAP_ALT_GUI) ? "YES" : "NO");
+    Serial.printf("Overrides : %u\n", _override_count);
+    for (uint8_t i = 0; i < _override_count; i++)
+    {
+        Serial.printf("  0x%02X -> 0x%02X\n", _overrides[i].from, _overrides[i].to);
+    }
+    Serial.println("------------------DONE-----------------");
+}
+
+void KeyRemapClass::_compileTABLE()
+{
+    if (_lock)
+    {
+        xSemaphoreTake(_lock, portMAX_DELAY);
+    }
+    // build into whichever table the callback is not reading, then publish it
+    uint8_t* next = (_active == _tables[0]) ? _tables[1] : _tables[0];
+    uint8_t base[256];
+
+    for (int i = 0; i < 256; i++)
+    {
+        next[i] = (uint8_t)i;
+    }
+    const REMAP_LAYOUT_DESC& desc = REMAP_LAYOUTS[_layout];
+    memcpy(base, next, sizeof(base));
+    _applyPAIRS(next, base, desc.pairs, desc.count);
+
+    if (_options & REMAP_OPT_CAPS_TO_CTRL)
+    {
+        memcpy(base, next, sizeof(base));
+        _applyPAIRS(next, base, CAPS_TO_CTRL_PAIRS, sizeof(CAPS_TO_CTRL_PAIRS) / sizeof(CAPS_TO_CTRL_PAIRS[0]));
+    }
+    if (_options & REMAP_OPT_SWAP_ALT_GUI)
+    {
+        memcpy(base, next, sizeof(base));
+        _applyPAIRS(next, base, SWAP_ALT_GUI_PAIRS, sizeof(SWAP_ALT_GUI_PAIRS) / sizeof(SWAP_ALT_GUI_PAIRS[0]));
+    }
+
+    // user overrides are absolute (physical usage -> output usage) and win over everything
+    for (uint8_t i = 0; i < _override_count; i++)
+    {
+        next[_overrides[i].from] = _overrides[i].to;
+    }
+    _active = next;
+    if (_lock)
+    {
+        xSemaphoreGive(_lock);
+    }
+}
+
+void KeyRemapClass::remapREPORT(uint8_t mods_in, const uint8_t* keys_in, uint8_t n_keys,
+                                uint8_t* mods_out, uint8_t* keys_out) const
+{
+    const uint8_t* table = _active;
+    uint8_t mods = 0;
+    uint8_t n = 0;
+
+    memset(keys_out, 0, n_keys);
+    for (uint8_t bit = 0; bit < 8; bit++)
+    {
+        if (!(mods_in & (1u << bit))) continue;
+        uint8_t t = table[REMAP_MOD_USAGE_FIRST + bit];
+        if (t >= REMAP_MOD_USAGE_FIRST && t <= REMAP_MOD_USAGE_LAST) {
+            mods |= (uint8_t)(1u << (t - REMAP_MOD_USAGE_FIRST));
+        } else if (t != 0 && n < n_keys) {
+            keys_out[n++] = t;
+        }
+    }
+    for (uint8_t i = 0; i < n_keys; i++)
+    {
+        uint8_t t = table[keys_in[i]];
+        if (t >= REMAP_MOD_USAGE_FIRST && t <= REMAP_MOD_USAGE_LAST) {
+            mods |= (uint8_t)(1u << (t - REMAP_MOD_USAGE_FIRST));
+        } else if (t != 0 && n < n_keys) {
+            keys_out[n++] = t;
+        }
+    }
+    *mods_out = mods;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <Arduino.h>
+#include <Preferences.h>
+
+// Keymap remapping stage. Built-in layouts are constexpr (from,to) usage lists that are
+// compiled together with the option bits and the user overrides into one flat 256-entry
+// usage->usage table, so a lookup is a single indexed load whatever layout is active.
+// Modifiers take part through their HID usages 0xE0..0xE7 (bit n of the boot-report
+// modifier byte == usage 0xE0+n), which is what makes Caps->Ctrl a plain table entry.
+
+const uint8_t REMAP_MOD_USAGE_FIRST = 0xE0;   // Left Control
+const uint8_t REMAP_MOD_USAGE_LAST  = 0xE7;   // Right GUI
+const uint8_t REMAP_MAX_OVERRIDES   = 64;
+const uint8_t REMAP_FIRST_KEY       = 0x04;   // 0x01..0x03 are report error codes, not keys
+
+// layouts (value stored in NVS, keep stable)
+const uint8_t REMAP_LAYOUT_QWERTY   = 0;
+const uint8_t REMAP_LAYOUT_COLEMAK  = 1;
+const uint8_t REMAP_LAYOUT_COUNT    = 2;
+
+// option bits (stored in NVS, keep stable)
+const uint8_t REMAP_OPT_CAPS_TO_CTRL = 0x01;
+const uint8_t REMAP_OPT_SWAP_ALT_GUI = 0x02;   // Mac hosts
+
+typedef struct REMAP_PAIR {
+    uint8_t from;
+    uint8_t to;
+} REMAP_PAIR;
+
+class KeyRemapClass {
+public:
+    KeyRemapClass();
+    bool begin();                   // load layout/options/overrides from NVS and compile
+    void setLOCK(SemaphoreHandle_t lock) { _lock = lock; }    // held by the reader around remapREPORT()
+    void saveSETTINGS();            // persist layout, options and override blob
+
+    void setLAYOUT(uint8_t layout);
+    void setOPTIONS(uint8_t options);
+    bool setOVERRIDE(uint8_t from, uint8_t to);   // to == 0 disables the key; false when full or invalid
+    static bool validOVERRIDE(uint8_t from, uint8_t to);
+    void clearOVERRIDES();
+    void printCONFIG();
+    uint8_t layout() const { return _layout; }
+    uint8_t options() const { return _options; }
+    static const char* layoutNAME(uint8_t layout);
+
+    // hot path: one load per key, no branching on layout
+    inline uint8_t lookup(uint8_t usage) const { return _active[usage]; }
+
+    // Remap a boot report (modifier byte + key array). Keys that land on a modifier usage are
+    // folded into *mods_out, modifiers that land on a normal key take a free key slot.
+    void remapREPORT(uint8_t mods_in, const uint8_t* keys_in, uint8_t n_keys,
+                     uint8_t* mods_out, uint8_t* keys_out) const;
+private:
+    // two tables so a recompile never exposes a half-written table to the USB callback, and
+    // _lock so a second recompile cannot rewrite the one it is still reading
+    uint8_t _tables[2][256];
+    const uint8_t* volatile _active;
+    SemaphoreHandle_t _lock;
+
+    uint8_t _layout;
+    uint8_t _options;
+    uint8_t _override_count;
+    REMAP_PAIR _overrides[REMAP_MAX_OVERRIDES];
+    Preferences _prefs;
+
+    void _compileTABLE();
+};
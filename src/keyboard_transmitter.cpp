@@ -12,8 +12,40 @@ USBTOBLEKBbridge::USBTOBLEKBbridge()
     BleKBd(BLE_DEVICE_NAME),
     BleTaskHandle(nullptr),
     active_mods(0),
+    remap(),
+    wheel(),
+    layers(),
+    combos(),
+    macros(),
+    macro_store(),
+    pacer(),
+    BulkStream(nullptr),
+    bulk(),
+    bulk_active(false),
+    bulk_reset_req(false),
+    bulk_end_req(false),
+    bulk_chars(0),
+    bulk_cps(0),
+    debounce(),
+    KBDiffMutex(nullptr),
+    debounce_due_ms(0),
+    key_events(0),
+    key_drops(0),
+    batt_sent_pct(-1),
+    batt_sent_charging(false),
+    batt_delta(BLE_BATTERY_DELTA),
+    telem_key_drops(0),
+    telem_suppressed(0),
+    telem_redundant(0),
+    reports(),
+    fanin(),
+    recovery(),
+    telem_usb_faults(0),
+    open_ifaces(0),
     hid_host_event_queue(nullptr)
-{}
+{
+  for (uint8_t i = 0; i < HID_MAX_OPEN_IFACES; i++) closing[i].store(nullptr);
+}
 
 // Static instance pointer definition
 USBTOBLEKBbridge* USBTOBLEKBbridge::s_instance_ptr = nullptr;
@@ -29,11 +61,27 @@ void USBTOBLEKBbridge::set_instance(USBTOBLEKBbridge* p) {
 // ----------------- begin() -----------------
 bool USBTOBLEKBbridge::begin() {
 
+  // load the keymap before any report can arrive; a missing NVS namespace falls back to QWERTY
+  remap.begin();
+  macro_store.begin(macros);
+  debounce.setWINDOW(KB_DEBOUNCE_MS);
+  debounce.setMODE(KB_DEBOUNCE_MODE);
+  fanin.setQUEUE(KEYQUEUE_DEPTH);
 
   KBQueue = xQueueCreate(KEYQUEUE_DEPTH, sizeof(KB_EVENT));
   if (!KBQueue) {
     return false;
   }
+  BulkStream = xStreamBufferCreate(BULK_STREAM_SIZE, 1);
+  if (!BulkStream) {
+    return false;
+  }
+  // report callback (HID driver task) and debounce re-check (HID worker) share the diff state
+  KBDiffMutex = xSemaphoreCreateMutex();
+  if (!KBDiffMutex) {
+    return false;
+  }
+  remap.setLOCK(KBDiffMutex);     // console keymap edits recompile under it
 
   // BLE task pinned to core 0
   xTaskCreatePinnedToCore(
@@ -74,7 +122,7 @@ bool USBTOBLEKBbridge::begin() {
   ESP_ERROR_CHECK(hid_host_install(&HHD_cfg));
 
   // create hid-host event queue
-  hid_host_event_queue = xQueueCreate(10, sizeof(HidKB_host_Event_Queue_t));
+  hid_host_event_queue = xQueueCreate(HID_EVENT_QUEUE_DEPTH, sizeof(HidKB_host_Event_Queue_t));
   if (!hid_host_event_queue) {
     return false;
   }
@@ -93,9 +141,12 @@ bool USBTOBLEKBbridge::begin() {
 }
 
 // ----------------- enqueueKey (ISR safe) -----------------
-void USBTOBLEKBbridge::enqueueKey(uint8_t usage, uint8_t mods, bool pressed) {
+void USBTOBLEKBbridge::enqueueKey(uint8_t usage, uint8_t mods, bool pressed, uint8_t src) {
   if (!KBQueue) return;
-  KB_EVENT event { usage, mods, pressed };
+  // a device over its share of the queue loses its own presses; other releases always get in
+  if (!fanin.admit(src, usage, pressed)) return;
+  KB_EVENT event { usage, mods, pressed, src, (uint32_t)millis() };
+  key_events = key_events + 1;
 
   BaseType_t inISR = pdFALSE;
 #if defined(xPortIsInsideInterrupt)
@@ -104,12 +155,21 @@ void USBTOBLEKBbridge::enqueueKey(uint8_t usage, uint8_t mods, bool pressed) {
   inISR = xPortInIsrContext();
 #endif
 
+  // TASK_BLE sleeps on its notification (not on the queue) so it can also wake for timer deadlines
   if (inISR) {
     BaseType_t woken = pdFALSE;
-    xQueueSendFromISR(KBQueue, &event, &woken);
+    if (xQueueSendFromISR(KBQueue, &event, &woken) != pdTRUE) {
+      key_drops = key_drops + 1;
+      fanin.done(src);
+    }
+    if (BleTaskHandle) vTaskNotifyGiveFromISR(BleTaskHandle, &woken);
     portYIELD_FROM_ISR(woken);
   } else {
-    xQueueSend(KBQueue, &event, 0);
+    if (xQueueSend(KBQueue, &event, 0) != pdTRUE) {
+      key_drops = key_drops + 1;
+      fanin.done(src);
+    }
+    if (BleTaskHandle) xTaskNotifyGive(BleTaskHandle);
   }
 }
 
@@ -154,10 +214,37 @@ void USBTOBLEKBbridge::Hid_Host_Device_Callback(hid_host_device_handle_t hdh, co
 void USBTOBLEKBbridge::TASK_Hid_WORKER() {
   HidKB_host_Event_Queue_t event;
   while (true) {
-    if (xQueueReceive(hid_host_event_queue, &event, pdMS_TO_TICKS(50))) {
-      // dispatch to the handler that opens the interface / starts transfer
-      hid_Host_Device_EVENT(event.hdh, event.event, event.arg);
+    // device events, unplugs, diff_KB_REPORT and faults wake us; only a debounce window holding back a
+    // key state (the keyboard will not send another report because it closed) and a recovery
+    // backoff need a timeout
+    TickType_t wait = portMAX_DELAY;
+    uint32_t now = millis();
+    uint32_t due = debounce_due_ms;
+    if (due) {
+      int32_t left = (int32_t)(due - now);
+      if (left <= 0) wait = 0;
+      else wait = pdMS_TO_TICKS(left) + 1;
+    }
+    uint32_t rec_ms = recovery.msUntilNEXT(now);
+    if (rec_ms != USB_REC_IDLE && pdMS_TO_TICKS(rec_ms) + 1 < wait) {
+      wait = rec_ms ? pdMS_TO_TICKS(rec_ms) + 1 : 0;
+    }
+    if (xQueueReceive(hid_host_event_queue, &event, wait)) {
+      // hdh == NULL is only a wake-up from an unplug, diff_KB_REPORT or a fault
+      if (event.hdh) {
+        // dispatch to the handler that opens the interface / starts transfer
+        hid_Host_Device_EVENT(event.hdh, event.event, event.arg);
+      }
+    }
+    due = debounce_due_ms;
+    if (due && (int32_t)((uint32_t)millis() - due) >= 0) {
+      diff_KB_REPORT(KB_SRC_NONE, 0, nullptr);
     }
+    // before recovery, so no action runs on an unplugged handle
+    close_PENDING();
+    service_RECOVERY();
+    // a macro recording closed on TASK_BLE; the NVS write happens here, at low priority
+    if (macros.dirty()) macro_store.saveDIRTY(macros);
   }
 }
 
@@ -189,90 +276,322 @@ bool USBTOBLEKBbridge::is_SHIFT(uint8_t mods) {
 }
 
 // ----------------- HID device-level event (open/start interface) -----------------
+static const hid_host_device_config_t HID_DEVICE_CONFIG = {
+  .callback = hid_host_interface_callback_cwrap,
+  .callback_arg = NULL
+};
+
+// runs on the HID worker; a failure is a fault for the recovery state machine, never an abort
 void USBTOBLEKBbridge::hid_Host_Device_EVENT(hid_host_device_handle_t hdh, const hid_host_driver_event_t event, void* arg) {
+  USBTOBLEKBbridge* self = instance();
   hid_host_dev_params_t dev_params;
-  ESP_ERROR_CHECK(hid_host_device_get_params(hdh, &dev_params));
-
-  const hid_host_device_config_t dev_config = {
-    .callback = hid_host_interface_callback_cwrap,
-    .callback_arg = NULL
-  };
+  esp_err_t err = hid_host_device_get_params(hdh, &dev_params);
+  if (!self || err != ESP_OK) {
+    DLOG_W("USB:: get_params failed 0x%x", err);
+    return;
+  }
 
   switch (event) {
-    case HID_HOST_DRIVER_EVENT_CONNECTED:
-      ESP_ERROR_CHECK(hid_host_device_open(hdh, &dev_config));
-      if (dev_params.sub_class == HID_SUBCLASS_BOOT_INTERFACE) {
-        ESP_ERROR_CHECK(hid_class_request_set_protocol(hdh, HID_REPORT_PROTOCOL_BOOT));
-        if (dev_params.proto == HID_PROTOCOL_KEYBOARD) {
-          ESP_ERROR_CHECK(hid_class_request_set_idle(hdh, 0, 0));
-        }
+    case HID_HOST_DRIVER_EVENT_CONNECTED: {
+      // the slot exists before the first report; a full table only loses the fast path, and
+      // for a keyboard its keys, since the fan-in merges per slot
+      uint8_t kind = report_KIND(dev_params);
+      uint8_t slot = self->reports.attach(hdh, kind, millis());
+      if (slot == REPORT_NO_SLOT) {
+        DLOG_W("USB:: no slot for device %u interface %u", dev_params.addr, dev_params.iface_num);
+      } else {
+        self->recovery.attach(slot);
+        if (kind == REPORT_KIND_KEYBOARD) self->fanin.attach(slot);
+      }
+      // a DISCONNECTED must always find a place in the close list
+      err = self->open_ifaces < HID_MAX_OPEN_IFACES ? hid_host_device_open(hdh, &HID_DEVICE_CONFIG) : ESP_ERR_NO_MEM;
+      if (err != ESP_OK) {
+        // nothing to restart without an open interface; a replug starts over
+        DLOG_W("USB:: open failed 0x%x", err);
+        self->fanin.detach(slot);
+        self->recovery.detach(slot);
+        self->reports.detach(hdh);
+        break;
+      }
+      self->open_ifaces++;
+      idlemgr.usbOPENED();      // the OTG host must keep its SOFs going: no light sleep
+      err = start_DEVICE(hdh);
+      if (err != ESP_OK) {
+        DLOG_W("USB:: start failed 0x%x", err);
+        self->recovery.fault(slot);
       }
-      ESP_ERROR_CHECK(hid_host_device_start(hdh));
       break;
+    }
     default:
       break;
   }
 }
 
+// boot protocol, no idle repeats, interrupt IN transfers running
+esp_err_t USBTOBLEKBbridge::start_DEVICE(hid_host_device_handle_t hdh) {
+  hid_host_dev_params_t params;
+  esp_err_t err = hid_host_device_get_params(hdh, &params);
+  if (err != ESP_OK) return err;
+  if (params.sub_class == HID_SUBCLASS_BOOT_INTERFACE) {
+    err = hid_class_request_set_protocol(hdh, HID_REPORT_PROTOCOL_BOOT);
+    if (err != ESP_OK) return err;
+    if (params.proto == HID_PROTOCOL_KEYBOARD) {
+      err = hid_class_request_set_idle(hdh, 0, 0);
+      if (err != ESP_OK) return err;
+    }
+  }
+  return hid_host_device_start(hdh);
+}
+
+// unplug: keys still held on the keyboard are released unless another keyboard holds them,
+// then the slot is freed. Runs once per opened interface (its DISCONNECTED), so the PM lock
+// goes even when the close fails because a REOPEN left the interface closed.
+void USBTOBLEKBbridge::close_DEVICE(hid_host_device_handle_t hdh) {
+  uint8_t slot = reports.find(hdh);
+  if (slot != REPORT_NO_SLOT && reports.kind(slot) == REPORT_KIND_KEYBOARD) {
+    static const uint8_t no_keys[FANIN_KEYS_PER_DEV] = {0};
+    diff_KB_REPORT(slot, 0, no_keys);
+    fanin.detach(slot);
+  }
+  recovery.detach(slot);
+  reports.detach(hdh);
+  esp_err_t err = hid_host_device_close(hdh);
+  if (err != ESP_OK) DLOG_W("USB:: close failed 0x%x", err);
+  if (open_ifaces) open_ifaces--;
+  idlemgr.usbCLOSED();
+}
+
+// HID worker: interfaces the driver task reported gone since the last pass
+void USBTOBLEKBbridge::close_PENDING() {
+  for (uint8_t i = 0; i < HID_MAX_OPEN_IFACES; i++) {
+    hid_host_device_handle_t hdh = closing[i].exchange(nullptr);
+    if (hdh) close_DEVICE(hdh);
+  }
+}
+
+// ----------------- transfer-error recovery -----------------
+void USBTOBLEKBbridge::wake_WORKER() {
+  if (!hid_host_event_queue) return;
+  HidKB_host_Event_Queue_t wake;
+  wake.hdh = NULL;
+  wake.event = HID_HOST_DRIVER_EVENT_CONNECTED;
+  wake.arg = NULL;
+  xQueueSend(hid_host_event_queue, &wake, 0);
+}
+
+// HID worker only: every open, close and recovery action happens on this task
+void USBTOBLEKBbridge::service_RECOVERY() {
+  for (uint8_t slot = 0; slot < USB_MAX_DEVICES; slot++) {
+    uint8_t action = recovery.service(slot, millis());
+    if (action == USB_REC_NONE) continue;
+    hid_host_device_handle_t hdh = (hid_host_device_handle_t)reports.device(slot);
+    if (!hdh) continue;
+    DLOG_W("USB:: slot %u recovery level %u", slot, action);
+    esp_err_t err = ESP_OK;
+    switch (action) {
+      case USB_REC_RESTART:
+        hid_host_device_stop(hdh);          // fails harmlessly when the transfer is already gone
+        err = hid_host_device_start(hdh);
+        break;
+      case USB_REC_REOPEN:
+        hid_host_device_close(hdh);
+        err = hid_host_device_open(hdh, &HID_DEVICE_CONFIG);
+        if (err == ESP_OK) err = start_DEVICE(hdh);
+        break;
+    }
+    if (err != ESP_OK) DLOG_W("USB:: slot %u recovery failed 0x%x", slot, err);
+    recovery.result(slot, err == ESP_OK, millis());
+    if (recovery.failed(slot) && reports.kind(slot) == REPORT_KIND_KEYBOARD) {
+      // given up until replugged: nothing it held may stay down on the host
+      static const uint8_t no_keys[FANIN_KEYS_PER_DEV] = {0};
+      DLOG_E("USB:: slot %u failed, replug the device", slot);
+      diff_KB_REPORT(slot, 0, no_keys);
+    }
+  }
+}
+
+uint8_t USBTOBLEKBbridge::report_KIND(const hid_host_dev_params_t& params) {
+  if (params.sub_class != HID_SUBCLASS_BOOT_INTERFACE) return REPORT_KIND_GENERIC;
+  if (params.proto == HID_PROTOCOL_KEYBOARD) return REPORT_KIND_KEYBOARD;
+  if (params.proto == HID_PROTOCOL_MOUSE) return REPORT_KIND_MOUSE;
+  return REPORT_KIND_GENERIC;
+}
+
 // ----------------- hid keyboard report parser -----------------
-void USBTOBLEKBbridge::hid_KB_Report_CALLBACK(const uint8_t* const data, const int len) {
+void USBTOBLEKBbridge::hid_KB_Report_CALLBACK(uint8_t slot, const uint8_t* const data, const int len) {
   if (len < (int)sizeof(hid_keyboard_input_report_boot_t)) return;
   const hid_keyboard_input_report_boot_t* KB_report_ptr = (const hid_keyboard_input_report_boot_t*)data;
 
-  // show raw report on OLED for debugging (kept as before)
-  {
-    char buf[128];
-    int n = snprintf(buf, sizeof(buf), "RAW : 0x%02x", KB_report_ptr->modifier.val);
-    for (size_t i = 0; i < HID_KEYBOARD_KEY_MAX && n < (int)sizeof(buf)-4; ++i) {
-      n += snprintf(buf + n, sizeof(buf) - n, " %02x", KB_report_ptr->key[i]);
-    }
+  // raw report for debugging; formatted by the log task, gone unless built with DLOG_LEVEL 4
+  DLOG_D("RAW : 0x%02x %02x %02x %02x %02x %02x %02x", KB_report_ptr->modifier.val, KB_report_ptr->key[0],
+         KB_report_ptr->key[1], KB_report_ptr->key[2], KB_report_ptr->key[3], KB_report_ptr->key[4], KB_report_ptr->key[5]);
+
+  if (instance()) {
+    instance()->diff_KB_REPORT(slot, KB_report_ptr->modifier.val, KB_report_ptr->key);
   }
+}
 
-  static uint8_t prev[HID_KEYBOARD_KEY_MAX] = {0};
+// ----------------- fan-in -> debounce -> remap -> diff -----------------
+// dev is the fan-in slot the report came from; keys_in == nullptr re-evaluates the last
+// merged report once a debounce window has closed
+void USBTOBLEKBbridge::diff_KB_REPORT(uint8_t dev, uint8_t mods_in, const uint8_t* keys_in) {
+  static uint8_t prev[FANIN_MAX_KEYS] = {0};
   static uint8_t prev_mods = 0;
-  uint8_t curr_mods = KB_report_ptr->modifier.val;
+
+  xSemaphoreTake(KBDiffMutex, portMAX_DELAY);
+
+  // fan-in stage: this device's report replaces its share of the logical keyboard
+  uint8_t src = KB_SRC_NONE;
+  uint8_t in_keys[FANIN_MAX_KEYS];
+  uint8_t in_mods;
+  if (keys_in) {
+    fanin.update(dev, mods_in, keys_in);
+    fanin.merged(&in_mods, in_keys);
+    src = dev;
+  }
+
+  // debounce stage: physical usages, before the keymap
+  const uint16_t now16 = (uint16_t)millis();
+  uint8_t deb_keys[FANIN_MAX_KEYS];
+  uint8_t deb_mods;
+  if (keys_in) {
+    debounce.filter(in_mods, in_keys, FANIN_MAX_KEYS, now16, &deb_mods, deb_keys);
+  } else {
+    debounce.recheck(now16, FANIN_MAX_KEYS, &deb_mods, deb_keys);
+  }
+
+  // remap stage: the whole report goes through the compiled table before diffing, so a key that
+  // becomes a modifier (Caps->Ctrl) shows up in curr_mods and releases stay paired with presses
+  uint8_t curr_keys[FANIN_MAX_KEYS];
+  uint8_t curr_mods;
+  remap.remapREPORT(deb_mods, deb_keys, FANIN_MAX_KEYS, &curr_mods, curr_keys);
 
   // --- NEW: if modifier byte changed, enqueue a synthetic event (usage==0)
   // This ensures TASK_BLE will see modifier-only changes (presses/releases).
   if (curr_mods != prev_mods) {
-    if (instance()) {
-      // usage == 0 marks this as "modifier-only" event; TASK_BLE processes mods before checking usage==0.
-      instance()->enqueueKey(0, curr_mods, true);
-    }
+    // usage == 0 marks this as "modifier-only" event; TASK_BLE processes mods before checking usage==0.
+    enqueueKey(0, curr_mods, true, src);
     // do NOT update prev_mods yet — keep prev_mods for key-release events below,
     // we'll set prev_mods = curr_mods at the end (same semantic as original).
   }
 
   // releases: present in prev[] but not in current report
-  for (size_t i = 0; i < HID_KEYBOARD_KEY_MAX; ++i) {
+  for (size_t i = 0; i < FANIN_MAX_KEYS; ++i) {
     uint8_t pk = prev[i];
     if (pk > HID_KEY_ERROR_UNDEFINED) {
       bool still = false;
-      for (size_t j = 0; j < HID_KEYBOARD_KEY_MAX; ++j) {
-        if (KB_report_ptr->key[j] == pk) { still = true; break; }
+      for (size_t j = 0; j < FANIN_MAX_KEYS; ++j) {
+        if (curr_keys[j] == pk) { still = true; break; }
       }
       if (!still) {
-        if (instance()) instance()->enqueueKey(pk, prev_mods, false);
+        enqueueKey(pk, prev_mods, false, src);
       }
     }
   }
 
   // presses: present now but not earlier
-  for (size_t i = 0; i < HID_KEYBOARD_KEY_MAX; ++i) {
-    uint8_t k = KB_report_ptr->key[i];
+  for (size_t i = 0; i < FANIN_MAX_KEYS; ++i) {
+    uint8_t k = curr_keys[i];
     if (k > HID_KEY_ERROR_UNDEFINED) {
       bool was = false;
-      for (size_t j = 0; j < HID_KEYBOARD_KEY_MAX; ++j) {
+      for (size_t j = 0; j < FANIN_MAX_KEYS; ++j) {
         if (prev[j] == k) { was = true; break; }
       }
       if (!was) {
-        if (instance()) instance()->enqueueKey(k, curr_mods, true);
+        enqueueKey(k, curr_mods, true, src);
       }
     }
   }
 
-  memcpy(prev, KB_report_ptr->key, HID_KEYBOARD_KEY_MAX);
+  memcpy(prev, curr_keys, FANIN_MAX_KEYS);
   prev_mods = curr_mods;   // update modifier snapshot for next report
+
+  // a key still held back by its window needs a re-check even if no report follows
+  const uint32_t left = debounce.msUntilRECHECK(now16);
+  const bool was_idle = (debounce_due_ms == 0);
+  uint32_t due = 0;
+  if (left != DEBOUNCE_IDLE) {
+    due = (uint32_t)millis() + left;
+    if (!due) due = 1;
+  }
+  debounce_due_ms = due;
+  xSemaphoreGive(KBDiffMutex);
+
+  if (due && was_idle) {
+    wake_WORKER();
+  }
+}
+
+// ----------------- power tier -> radio -----------------
+// nearest level at or below the request; these exist on every ESP32 variant
+esp_power_level_t USBTOBLEKBbridge::tx_POWER_LEVEL(int8_t dbm) {
+  if (dbm >= 9)  return ESP_PWR_LVL_P9;
+  if (dbm >= 6)  return ESP_PWR_LVL_P6;
+  if (dbm >= 3)  return ESP_PWR_LVL_P3;
+  if (dbm >= 0)  return ESP_PWR_LVL_N0;
+  if (dbm >= -3) return ESP_PWR_LVL_N3;
+  if (dbm >= -6) return ESP_PWR_LVL_N6;
+  if (dbm >= -9) return ESP_PWR_LVL_N9;
+  return ESP_PWR_LVL_N12;
+}
+
+void USBTOBLEKBbridge::applyPOWER(const POWER_TIER_PARAMS& p) {
+  NimBLEDevice::setPower(tx_POWER_LEVEL(p.tx_dbm));
+  NimBLEAdvertising* adv = NimBLEDevice::getAdvertising();
+  if (adv) {
+    // takes effect the next time advertising starts (after a disconnect)
+    adv->setMinInterval(p.adv_min);
+    adv->setMaxInterval(p.adv_max);
+    adv->setPreferredParams(p.conn_min, p.conn_max);
+  }
+  NimBLEServer* server = NimBLEDevice::getServer();
+  if (server && server->getConnectedCount()) {
+    server->updateConnParams(server->getPeerInfo(0).getConnHandle(), p.conn_min, p.conn_max,
+                             p.conn_latency, p.sup_timeout);
+  }
+}
+
+bool USBTOBLEKBbridge::bleCONNECTED() {
+  return BleKBd.isConnected();
+}
+
+// ----------------- BLE Battery Service -----------------
+// every setBatteryLevel() is a notification to a subscribed host, so small wobbles stay local;
+// the ends of the range and a charger edge always go out so the host indicator is never stale
+bool USBTOBLEKBbridge::reportBATTERY(uint8_t percent, bool charging) {
+  if (percent > 100) percent = 100;
+  bool send = batt_sent_pct < 0 || charging != batt_sent_charging;
+  if (!send) {
+    int16_t moved = (int16_t)percent - batt_sent_pct;
+    if (moved < 0) moved = -moved;
+    send = moved >= batt_delta || ((percent == 0 || percent == 100) && moved);
+  }
+  if (!send) return false;
+  BleKBd.setBatteryLevel(percent);
+  batt_sent_pct = percent;
+  batt_sent_charging = charging;
+  return true;
+}
+
+// ----------------- debounce settings / chatter statistics -----------------
+void USBTOBLEKBbridge::setDEBOUNCE(uint8_t mode, uint16_t window_ms) {
+  if (!KBDiffMutex) {
+    debounce.setWINDOW(window_ms);
+    debounce.setMODE(mode);
+    return;
+  }
+  xSemaphoreTake(KBDiffMutex, portMAX_DELAY);
+  debounce.setWINDOW(window_ms);
+  debounce.setMODE(mode);
+  xSemaphoreGive(KBDiffMutex);
+}
+
+void USBTOBLEKBbridge::debounce_STATS(uint32_t* suppressed, uint8_t* worst_usage, uint8_t* worst_count) {
+  if (KBDiffMutex) xSemaphoreTake(KBDiffMutex, portMAX_DELAY);
+  *suppressed = debounce.suppressedCOUNT();
+  *worst_usage = debounce.worstKEY();
+  *worst_count = debounce.chatterCOUNT(*worst_usage);
+  if (KBDiffMutex) xSemaphoreGive(KBDiffMutex);
 }
 
 // ----------------- hid mouse report -----------------
@@ -284,11 +603,8 @@ void USBTOBLEKBbridge::hid_MOUSE_Report_CALLBACK(const uint8_t *const data, cons
 
 // ----------------- generic report -----------------
 void USBTOBLEKBbridge::hid_Host_Generic_Report_CALLBACK(const uint8_t *const data, const int len) {
-  char buf[128];
-  int n = snprintf(buf, sizeof(buf), "GENERIC %d:", len);
-  for (int i = 0; i < min(10, len) && n < (int)sizeof(buf) - 3; ++i) {
-    n += snprintf(buf + n, sizeof(buf) - n, " %02X", data[i]);
-  }
+  // first 10 bytes, packed four to an argument
+  DLOG_D("GENERIC %d: %08X %08X %04X", len, dlogPACK(data, len), dlogPACK(data + 4, len - 4), dlogPACK(data + 8, len - 8) >> 16);
 }
 void USBTOBLEKBbridge::hid_host_Interface_callback_FORWARD(hid_host_device_handle_t hdh, const hid_host_interface_event_t event, void* arg)
 {
@@ -306,27 +622,56 @@ extern "C" void hid_host_interface_callback_cwrap(hid_host_device_handle_t hdh,
 
 // ----------------- interface callback (parses input reports) -----------------
 void USBTOBLEKBbridge::hid_Host_Interface_CALLBACK(hid_host_device_handle_t hdh, const hid_host_interface_event_t event, void* arg) {
-  uint8_t data[64]; size_t data_len = 0;
-  hid_host_dev_params_t marks_params;
-  ESP_ERROR_CHECK(hid_host_device_get_params(hdh, &marks_params));
+  USBTOBLEKBbridge* self = instance();
+  uint8_t data[REPORT_MAX_BYTES]; size_t data_len = 0;
 
   switch (event) {
-    case HID_HOST_INTERFACE_EVENT_INPUT_REPORT:
-      ESP_ERROR_CHECK(hid_host_device_get_raw_input_report_data(hdh, data, sizeof(data), &data_len));
-      if (marks_params.sub_class == HID_SUBCLASS_BOOT_INTERFACE && marks_params.proto == HID_PROTOCOL_KEYBOARD) {
-        hid_KB_Report_CALLBACK(data, (int)data_len);
-      } else if (marks_params.sub_class == HID_SUBCLASS_BOOT_INTERFACE && marks_params.proto == HID_PROTOCOL_MOUSE) {
+    case HID_HOST_INTERFACE_EVENT_INPUT_REPORT: {
+      if (hid_host_device_get_raw_input_report_data(hdh, data, sizeof(data), &data_len) != ESP_OK) {
+        self->recovery.fault(self->reports.find(hdh));
+        self->wake_WORKER();
+        break;
+      }
+      // a 1 kHz keyboard repeats its last report every frame: drop repeats before any decoding,
+      // and before activity(), so an idle gaming keyboard does not hold the CPU at full clock
+      uint8_t slot = self->reports.find(hdh);
+      if (!self->reports.changed(slot, data, (uint8_t)data_len, millis())) break;
+      idlemgr.activity();
+      uint8_t kind;
+      if (slot != REPORT_NO_SLOT) {
+        kind = self->reports.kind(slot);
+      } else {
+        hid_host_dev_params_t params;
+        if (hid_host_device_get_params(hdh, &params) != ESP_OK) break;
+        kind = report_KIND(params);
+      }
+      if (kind == REPORT_KIND_KEYBOARD) {
+        hid_KB_Report_CALLBACK(slot, data, (int)data_len);
+      } else if (kind == REPORT_KIND_MOUSE) {
         hid_MOUSE_Report_CALLBACK(data, (int)data_len);
       } else {
         hid_Host_Generic_Report_CALLBACK(data, (int)data_len);
       }
       break;
+    }
 
-    case HID_HOST_INTERFACE_EVENT_DISCONNECTED:
-      ESP_ERROR_CHECK(hid_host_device_close(hdh));
+    case HID_HOST_INTERFACE_EVENT_DISCONNECTED: {
+      // closed on the HID worker, which also runs the recovery actions on this handle. This
+      // task never blocks here (the worker may be waiting on a control transfer it completes)
+      // and never closes: the handle goes into the close list, which has a place for every open
+      // interface. A wake-up lost to a full queue is harmless, the worker has events to take.
+      for (uint8_t i = 0; i < HID_MAX_OPEN_IFACES; i++) {
+        hid_host_device_handle_t none = nullptr;
+        if (self->closing[i].compare_exchange_strong(none, hdh)) break;
+      }
+      self->wake_WORKER();
       break;
+    }
 
     case HID_HOST_INTERFACE_EVENT_TRANSFER_ERROR:
+      // counted here, handled with backoff on the HID worker
+      self->recovery.fault(self->reports.find(hdh));
+      self->wake_WORKER();
       break;
 
     default:
@@ -388,73 +733,438 @@ char USBTOBLEKBbridge::usage_TO_ASCII(uint8_t usage, uint8_t mods) {
 void USBTOBLEKBbridge::TASK_BLE() {
   setNimBLE_PREF();
   BleKBd.begin();
+  wheel.reset(millis());
+  // combos match what the layers made of the keys, so a layer key never completes a base chord
+  layers.begin(&wheel, combo_Event_SINK, this);
+  combos.begin(&wheel, ble_Event_SINK, this);
+
+  pacer.setRESERVE(BLE_NOTIFY_RESERVE);
 
   KB_EVENT event;
   for (;;) {
-    if (xQueueReceive(KBQueue, &event, portMAX_DELAY) == pdTRUE) {
-
-      if (!BleKBd.isConnected()) continue;
-
-      uint8_t new_mods = event.mods;
-      if (new_mods != active_mods) {
-        uint8_t release_mask = active_mods & ~new_mods;
-        // use plain if (not else-if) so multiple modifier bits are handled
-        if (release_mask & HID_LEFT_CONTROL)  BleKBd.release(KEY_LEFT_CTRL);
-        if (release_mask & HID_RIGHT_CONTROL) BleKBd.release(KEY_RIGHT_CTRL);
-        if (release_mask & HID_LEFT_SHIFT)    BleKBd.release(KEY_LEFT_SHIFT);
-        if (release_mask & HID_RIGHT_SHIFT)   BleKBd.release(KEY_RIGHT_SHIFT);
-        if (release_mask & HID_LEFT_ALT)      BleKBd.release(KEY_LEFT_ALT);
-        if (release_mask & HID_RIGHT_ALT)     BleKBd.release(KEY_RIGHT_ALT);
-        if (release_mask & HID_LEFT_GUI)      BleKBd.release(KEY_LEFT_GUI);
-        if (release_mask & HID_RIGHT_GUI)     BleKBd.release(KEY_RIGHT_GUI);
-
-        uint8_t press_mask = new_mods & ~active_mods;
-        if (press_mask & HID_LEFT_CONTROL)  BleKBd.press(KEY_LEFT_CTRL);
-        if (press_mask & HID_RIGHT_CONTROL) BleKBd.press(KEY_RIGHT_CTRL);
-        if (press_mask & HID_LEFT_SHIFT)    BleKBd.press(KEY_LEFT_SHIFT);
-        if (press_mask & HID_RIGHT_SHIFT)   BleKBd.press(KEY_RIGHT_SHIFT);
-        if (press_mask & HID_LEFT_ALT)      BleKBd.press(KEY_LEFT_ALT);
-        if (press_mask & HID_RIGHT_ALT)     BleKBd.press(KEY_RIGHT_ALT);
-        if (press_mask & HID_LEFT_GUI)      BleKBd.press(KEY_LEFT_GUI);
-        if (press_mask & HID_RIGHT_GUI)     BleKBd.press(KEY_RIGHT_GUI);
-
-        active_mods = new_mods;
-      }
+    // sleep until enqueueKey() notifies us, the next tap-hold deadline is due or,
+    // during macro playback, the link has room for the next report
+    uint32_t wait_ms = wheel.msUntilNEXT(millis());
+    if (macros.playing() || bulk_active) {
+      uint32_t credit_ms = (pacer.usUntilCREDIT(micros()) + 999) / 1000;
+      if (credit_ms < wait_ms) wait_ms = credit_ms;
+    }
+    ulTaskNotifyTake(pdTRUE, wait_ms == WHEEL_IDLE ? portMAX_DELAY : pdMS_TO_TICKS(wait_ms));
+
+    // live keys wait in KBQueue while a macro or bulk text owns the report
+    while (!macros.playing() && !bulk_active && xQueueReceive(KBQueue, &event, 0) == pdTRUE) {
+      fanin.done(event.src);
+      // deadlines that passed before this key was produced resolve first, keeping order
+      wheel.advance(event.time_ms);
+      layers.onEVENT(event);
+    }
+    wheel.advance(millis());
+    play_MACRO_STEP();
+    if (!macros.playing()) play_BULK_STEP();
+  } // for
+}
 
-      if (event.usage == 0) continue;
+// NimBLE host: controller ACL buffers free for the next packet. Set from LE Read Buffer Size and
+// given back by Number Of Completed Packets, once the peer acknowledged the packet; every
+// notification takes one. Not in the public headers, hence the plain extern.
+extern "C" uint16_t ble_hs_hci_avail_pkts;
 
-      char ch = usage_TO_ASCII(event.usage, event.mods);
-      if (ch) {
-        if (event.pressed) BleKBd.write(ch);
-      } else {
-        if (event.pressed) {
-          switch (event.usage) {
-            case HID_KEY_ESC:        BleKBd.press(KEY_ESC); BleKBd.release(KEY_ESC); break;
-            case HID_KEY_CAPS_LOCK:  BleKBd.write(KEY_CAPS_LOCK); BleKBd.release(KEY_CAPS_LOCK); break;
-            case HID_KEY_DEL:        BleKBd.write(KEY_BACKSPACE); BleKBd.release(KEY_BACKSPACE); break;
-            case HID_KEY_DELETE:     BleKBd.press(KEY_DELETE); BleKBd.release(KEY_DELETE);
-            case HID_KEY_TAB:        BleKBd.press(KEY_TAB); BleKBd.release(KEY_TAB); break;
-            case HID_KEY_F1:         BleKBd.press(KEY_F1), BleKBd.release(KEY_F1); break;
-            case HID_KEY_F2:         BleKBd.press(KEY_F2), BleKBd.release(KEY_F2); break;
-            case HID_KEY_F3:         BleKBd.press(KEY_F3), BleKBd.release(KEY_F3); break;
-            case HID_KEY_F4:         BleKBd.press(KEY_F4), BleKBd.release(KEY_F4); break;
-            case HID_KEY_F5:         BleKBd.press(KEY_F5), BleKBd.release(KEY_F5); break;
-            case HID_KEY_F6:         BleKBd.press(KEY_F6), BleKBd.release(KEY_F6); break;
-            case HID_KEY_F7:         BleKBd.press(KEY_F7), BleKBd.release(KEY_F7); break;
-            case HID_KEY_F8:         BleKBd.press(KEY_F8), BleKBd.release(KEY_F8); break;
-            case HID_KEY_F9:         BleKBd.press(KEY_F9), BleKBd.release(KEY_F9); break;
-            case HID_KEY_F10:        BleKBd.press(KEY_F10), BleKBd.release(KEY_F10); break;
-            case HID_KEY_F11:        BleKBd.press(KEY_F11), BleKBd.release(KEY_F11); break;
-            case HID_KEY_F12:        BleKBd.press(KEY_F12), BleKBd.release(KEY_F12); break;
-            case HID_KEY_LEFT:       BleKBd.press(KEY_LEFT_ARROW), BleKBd.release(KEY_LEFT_ARROW); break;
-            case HID_KEY_RIGHT:      BleKBd.press(KEY_RIGHT_ARROW), BleKBd.release(KEY_RIGHT_ARROW); break;
-            case HID_KEY_UP:         BleKBd.press(KEY_UP_ARROW), BleKBd.release(KEY_UP_ARROW); break;
-            case HID_KEY_DOWN:       BleKBd.press(KEY_DOWN_ARROW), BleKBd.release(KEY_DOWN_ARROW); break;
-            default:
-              break;
-          }
-        }
+uint16_t USBTOBLEKBbridge::ble_NOTIFY_FREE() {
+  return ble_hs_hci_avail_pkts;
+}
+
+uint32_t USBTOBLEKBbridge::ble_Conn_INTERVAL_US() {
+  NimBLEServer* server = NimBLEDevice::getServer();
+  if (server && server->getConnectedCount()) {
+    return (uint32_t)server->getPeerInfo(0).getConnInterval() * 1250;   // 1.25 ms units
+  }
+  return (uint32_t)PREF_MAX_INTERVAL * 1250;
+}
+
+void USBTOBLEKBbridge::handle_KB_ACTION(uint8_t usage) {
+  if (usage >= KB_ACTION_MACRO_REC0 && usage < KB_ACTION_MACRO_REC0 + MACRO_SLOTS) {
+    if (macros.recording()) {
+      macros.stopRECORD();
+      wake_WORKER();      // the HID worker saves the slot
+    } else {
+      macros.startRECORD(usage - KB_ACTION_MACRO_REC0);
+    }
+    return;
+  }
+  if (usage >= KB_ACTION_MACRO_PLAY0 && usage < KB_ACTION_MACRO_PLAY0 + MACRO_SLOTS) {
+    if (bulk_active || !BleKBd.isConnected()) return;
+    if (macros.startPLAYBACK(usage - KB_ACTION_MACRO_PLAY0)) begin_REPORT_BURST();
+  }
+}
+
+// ----------------- paced report bursts (macros, bulk text) -----------------
+void USBTOBLEKBbridge::begin_REPORT_BURST() {
+  // the burst sends whole reports itself; start from all-up and let the pacer do the waiting
+  BleKBd.releaseAll();
+  active_mods = 0;
+  BleKBd.setDelay(0);
+  pacer.setINTERVAL(ble_Conn_INTERVAL_US());
+  pacer.reset(micros());
+}
+
+void USBTOBLEKBbridge::end_REPORT_BURST() {
+  // hand the report back to the live path
+  BleKBd.setDelay(BLE_KEY_DELAY_MS);
+}
+
+void USBTOBLEKBbridge::send_KB_REPORT(const KB_REPORT& r) {
+  KeyReport report;
+  report.modifiers = r.mods;
+  report.reserved = 0;
+  memcpy(report.keys, r.keys, sizeof(report.keys));
+  BleKBd.sendReport(&report);
+}
+
+void USBTOBLEKBbridge::play_MACRO_STEP() {
+  if (!macros.playing()) return;
+  while (macros.playing()) {
+    if (!BleKBd.isConnected()) {
+      macros.stopPLAYBACK();
+      break;
+    }
+    if (!pacer.take(micros(), ble_NOTIFY_FREE())) return;
+
+    KB_REPORT r;
+    macros.nextREPORT(&r);
+    send_KB_REPORT(r);
+  }
+  end_REPORT_BURST();
+}
+
+void USBTOBLEKBbridge::play_BULK_STEP() {
+  if (bulk_reset_req.exchange(false)) bulk.resetSTATS();
+  uint8_t chunk[BULK_LOOKAHEAD];
+  size_t n = xStreamBufferReceive(BulkStream, chunk, bulk.space(), 0);
+  for (size_t i = 0; i < n; i++) bulk.push((char)chunk[i]);
+
+  if (!BleKBd.isConnected()) {
+    // nobody to type into: drop the backlog instead of typing stale text on reconnect
+    bulk.clear();
+    while (xStreamBufferReceive(BulkStream, chunk, sizeof(chunk), 0)) {}
+    if (bulk_active) {
+      bulk_active = false;
+      end_REPORT_BURST();
+    }
+    bulk_FINISHED();
+    return;
+  }
+  if (!bulk_active) {
+    if (bulk.idle()) {
+      bulk_FINISHED();
+      return;
+    }
+    bulk_active = true;
+    begin_REPORT_BURST();
+  }
+
+  while (!bulk.idle()) {
+    if (!pacer.take(micros(), ble_NOTIFY_FREE())) return;
+    KB_REPORT r;
+    if (bulk.nextREPORT(&r, millis())) send_KB_REPORT(r);
+    n = xStreamBufferReceive(BulkStream, chunk, bulk.space(), 0);
+    for (size_t i = 0; i < n; i++) bulk.push((char)chunk[i]);
+  }
+  bulk_active = false;
+  end_REPORT_BURST();
+  bulk_FINISHED();
+}
+
+// TASK_BLE, with nothing left to type: reports a stream whose end of input has arrived. The
+// flag is taken before the emptiness check, so every byte written before it is already seen
+void USBTOBLEKBbridge::bulk_FINISHED() {
+  if (!bulk_end_req.exchange(false)) return;
+  if (!bulk.idle() || !xStreamBufferIsEmpty(BulkStream)) {
+    bulk_end_req.store(true);
+    return;
+  }
+  bulk_chars.store(bulk.charsSENT());
+  bulk_cps.store(bulk.charsPerSEC());
+  Serial.printf("BULK:: %u chars typed, %u chars/s\n", bulk_chars.load(), bulk_cps.load());
+}
+
+size_t USBTOBLEKBbridge::bulk_WRITE(const uint8_t* data, size_t len) {
+  if (!BulkStream) return 0;
+  size_t n = xStreamBufferSend(BulkStream, data, len, 0);
+  if (n && BleTaskHandle) xTaskNotifyGive(BleTaskHandle);
+  return n;
+}
+
+size_t USBTOBLEKBbridge::bulk_SPACE() {
+  return BulkStream ? xStreamBufferSpacesAvailable(BulkStream) : 0;
+}
+
+void USBTOBLEKBbridge::bulk_END() {
+  bulk_end_req.store(true);
+  if (BleTaskHandle) xTaskNotifyGive(BleTaskHandle);
+}
+
+void USBTOBLEKBbridge::bulk_STATS(uint32_t* chars, uint32_t* chars_per_sec) {
+  if (chars) *chars = bulk_chars.load();
+  if (chars_per_sec) *chars_per_sec = bulk_cps.load();
+}
+
+void USBTOBLEKBbridge::bulk_RESET_STATS() {
+  bulk_reset_req.store(true);
+}
+
+void USBTOBLEKBbridge::ble_Event_SINK(const KB_EVENT& event, void* arg) {
+  static_cast<USBTOBLEKBbridge*>(arg)->send_KB_EVENT(event);
+}
+
+void USBTOBLEKBbridge::combo_Event_SINK(const KB_EVENT& event, void* arg) {
+  static_cast<USBTOBLEKBbridge*>(arg)->combos.onEVENT(event);
+}
+
+void USBTOBLEKBbridge::send_KB_EVENT(const KB_EVENT& event) {
+  if (isKbACTION(event.usage)) {
+    if (event.pressed) handle_KB_ACTION(event.usage);
+    return;
+  }
+  if (macros.recording()) {
+    macros.recordEVENT(event);
+    if (!macros.recording()) wake_WORKER();   // slot full, recording closed itself
+  }
+  if (!BleKBd.isConnected()) return;
+
+  uint8_t new_mods = event.mods;
+  if (new_mods != active_mods) {
+    uint8_t release_mask = active_mods & ~new_mods;
+    // use plain if (not else-if) so multiple modifier bits are handled
+    if (release_mask & HID_LEFT_CONTROL)  BleKBd.release(KEY_LEFT_CTRL);
+    if (release_mask & HID_RIGHT_CONTROL) BleKBd.release(KEY_RIGHT_CTRL);
+    if (release_mask & HID_LEFT_SHIFT)    BleKBd.release(KEY_LEFT_SHIFT);
+    if (release_mask & HID_RIGHT_SHIFT)   BleKBd.release(KEY_RIGHT_SHIFT);
+    if (release_mask & HID_LEFT_ALT)      BleKBd.release(KEY_LEFT_ALT);
+    if (release_mask & HID_RIGHT_ALT)     BleKBd.release(KEY_RIGHT_ALT);
+    if (release_mask & HID_LEFT_GUI)      BleKBd.release(KEY_LEFT_GUI);
+    if (release_mask & HID_RIGHT_GUI)     BleKBd.release(KEY_RIGHT_GUI);
+
+    uint8_t press_mask = new_mods & ~active_mods;
+    if (press_mask & HID_LEFT_CONTROL)  BleKBd.press(KEY_LEFT_CTRL);
+    if (press_mask & HID_RIGHT_CONTROL) BleKBd.press(KEY_RIGHT_CTRL);
+    if (press_mask & HID_LEFT_SHIFT)    BleKBd.press(KEY_LEFT_SHIFT);
+    if (press_mask & HID_RIGHT_SHIFT)   BleKBd.press(KEY_RIGHT_SHIFT);
+    if (press_mask & HID_LEFT_ALT)      BleKBd.press(KEY_LEFT_ALT);
+    if (press_mask & HID_RIGHT_ALT)     BleKBd.press(KEY_RIGHT_ALT);
+    if (press_mask & HID_LEFT_GUI)      BleKBd.press(KEY_LEFT_GUI);
+    if (press_mask & HID_RIGHT_GUI)     BleKBd.press(KEY_RIGHT_GUI);
+
+    active_mods = new_mods;
+  }
+
+  if (event.usage == 0) return;
+  // KB_EVENT.time_ms is stamped in enqueueKey(), i.e. when the USB report was diffed
+  const uint32_t lat_ms = (uint32_t)millis() - event.time_ms;
+  telemetry.emit(TELEM_LATENCY, event.pressed, lat_ms, event.usage);
+  latency.record(lat_ms);
+  if (idlemgr.wakePENDING()) idlemgr.keySENT(ble_Conn_INTERVAL_US());
+
+  char ch = usage_TO_ASCII(event.usage, event.mods);
+  if (ch) {
+    if (event.pressed) BleKBd.write(ch);
+  } else {
+    if (event.pressed) {
+      switch (event.usage) {
+        case HID_KEY_ESC:        BleKBd.press(KEY_ESC); BleKBd.release(KEY_ESC); break;
+        case HID_KEY_CAPS_LOCK:  BleKBd.write(KEY_CAPS_LOCK); BleKBd.release(KEY_CAPS_LOCK); break;
+        case HID_KEY_DEL:        BleKBd.write(KEY_BACKSPACE); BleKBd.release(KEY_BACKSPACE); break;
+        case HID_KEY_DELETE:     BleKBd.press(KEY_DELETE); BleKBd.release(KEY_DELETE); break;
+        case HID_KEY_TAB:        BleKBd.press(KEY_TAB); BleKBd.release(KEY_TAB); break;
+        case HID_KEY_F1:         BleKBd.press(KEY_F1), BleKBd.release(KEY_F1); break;
+        case HID_KEY_F2:         BleKBd.press(KEY_F2), BleKBd.release(KEY_F2); break;
+        case HID_KEY_F3:         BleKBd.press(KEY_F3), BleKBd.release(KEY_F3); break;
+        case HID_KEY_F4:         BleKBd.press(KEY_F4), BleKBd.release(KEY_F4); break;
+        case HID_KEY_F5:         BleKBd.press(KEY_F5), BleKBd.release(KEY_F5); break;
+        case HID_KEY_F6:         BleKBd.press(KEY_F6), BleKBd.release(KEY_F6); break;
+        case HID_KEY_F7:         BleKBd.press(KEY_F7), BleKBd.release(KEY_F7); break;
+        case HID_KEY_F8:         BleKBd.press(KEY_F8), BleKBd.release(KEY_F8); break;
+        case HID_KEY_F9:         BleKBd.press(KEY_F9), BleKBd.release(KEY_F9); break;
+        case HID_KEY_F10:        BleKBd.press(KEY_F10), BleKBd.release(KEY_F10); break;
+        case HID_KEY_F11:        BleKBd.press(KEY_F11), BleKBd.release(KEY_F11); break;
+        case HID_KEY_F12:        BleKBd.press(KEY_F12), BleKBd.release(KEY_F12); break;
+        case HID_KEY_LEFT:       BleKBd.press(KEY_LEFT_ARROW), BleKBd.release(KEY_LEFT_ARROW); break;
+        case HID_KEY_RIGHT:      BleKBd.press(KEY_RIGHT_ARROW), BleKBd.release(KEY_RIGHT_ARROW); break;
+        case HID_KEY_UP:         BleKBd.press(KEY_UP_ARROW), BleKBd.release(KEY_UP_ARROW); break;
+        case HID_KEY_DOWN:       BleKBd.press(KEY_DOWN_ARROW), BleKBd.release(KEY_DOWN_ARROW); break;
+        default:
+          break;
       }
-    } // xQueueReceive
-  } // for
+    }
+  }
+}
+
+// ----------------- console commands -----------------
+static size_t bulk_RAW_WRITE(void* ctx, const uint8_t* data, size_t len) {
+  return static_cast<USBTOBLEKBbridge*>(ctx)->bulk_WRITE(data, len);
+}
+static size_t bulk_RAW_SPACE(void* ctx) {
+  return static_cast<USBTOBLEKBbridge*>(ctx)->bulk_SPACE();
+}
+static void bulk_RAW_END(void* ctx) {
+  // up to a stream buffer of text may still be untyped; TASK_BLE prints the stats when it is
+  static_cast<USBTOBLEKBbridge*>(ctx)->bulk_END();
+}
+
+static void cmd_TYPE(void* ctx, const CmdArgs& args) {
+  static CONSOLE_RAW raw = { bulk_RAW_WRITE, bulk_RAW_SPACE, bulk_RAW_END, nullptr };
+  USBTOBLEKBbridge* bridge = static_cast<USBTOBLEKBbridge*>(ctx);
+  raw.ctx = bridge;
+  bridge->bulk_RESET_STATS();
+  Serial.println("BULK:: streaming, end with Ctrl-D");
+  args.console().startRAW(&raw);    // everything after this line is text to type
+}
+
+static void cmd_DEBOUNCE(void* ctx, const CmdArgs& args) {
+  long mode;
+  long ms = KB_DEBOUNCE_MS;
+  if (!args.toINT(0, &mode) || mode < DEBOUNCE_OFF || mode > DEBOUNCE_DEFER ||
+      (args.count() > 1 && (!args.toINT(1, &ms) || ms < 1 || ms > 1000))) {
+    Serial.println("DEBOUNCE:: mode 0 off, 1 eager, 2 defer; window 1..1000 ms");
+    return;
+  }
+  static_cast<USBTOBLEKBbridge*>(ctx)->setDEBOUNCE((uint8_t)mode, (uint16_t)ms);
+}
+
+static void cmd_DEBOUNCE_STATS(void* ctx, const CmdArgs& args) {
+  (void)args;
+  uint32_t suppressed;
+  uint8_t worst, worst_count;
+  static_cast<USBTOBLEKBbridge*>(ctx)->debounce_STATS(&suppressed, &worst, &worst_count);
+  Serial.printf("DEBOUNCE:: %u edges suppressed, worst key 0x%02x (%u)\n", suppressed, worst, worst_count);
+}
+
+static void cmd_KEYMAP(void* ctx, const CmdArgs& args) {
+  (void)args;
+  static_cast<USBTOBLEKBbridge*>(ctx)->keyREMAP().printCONFIG();
+}
+
+static void cmd_KEYMAP_LAYOUT(void* ctx, const CmdArgs& args) {
+  long v;
+  if (!args.toINT(0, &v) || v < 0 || v > 255) { Serial.println("KEYREMAP: layout number expected"); return; }
+  static_cast<USBTOBLEKBbridge*>(ctx)->keyREMAP().setLAYOUT((uint8_t)v);
+}
+
+static void cmd_KEYMAP_OPTS(void* ctx, const CmdArgs& args) {
+  long v;
+  if (!args.toINT(0, &v) || v < 0 || v > 255) { Serial.println("KEYREMAP: option bits expected"); return; }
+  static_cast<USBTOBLEKBbridge*>(ctx)->keyREMAP().setOPTIONS((uint8_t)v);
+}
+
+static void cmd_KEYMAP_MAP(void* ctx, const CmdArgs& args) {
+  long from, to;
+  if (!args.toINT(0, &from) || !args.toINT(1, &to) || from < 0 || from > 255 || to < 0 || to > 255) {
+    Serial.println("KEYREMAP: usages 0..255 expected (0x.. accepted)");
+    return;
+  }
+  if (!KeyRemapClass::validOVERRIDE((uint8_t)from, (uint8_t)to)) {
+    Serial.println("KEYREMAP: from must be a key (0x04..), to a key or 0 to disable");
+    return;
+  }
+  if (!static_cast<USBTOBLEKBbridge*>(ctx)->keyREMAP().setOVERRIDE((uint8_t)from, (uint8_t)to)) {
+    Serial.println("KEYREMAP: override table full");
+  }
+}
+
+static void cmd_KEYMAP_CLEAR(void* ctx, const CmdArgs& args) {
+  (void)args;
+  static_cast<USBTOBLEKBbridge*>(ctx)->keyREMAP().clearOVERRIDES();
+}
+
+static void cmd_KEYMAP_SAVE(void* ctx, const CmdArgs& args) {
+  (void)args;
+  static_cast<USBTOBLEKBbridge*>(ctx)->keyREMAP().saveSETTINGS();
+}
+
+static void cmd_USB(void* ctx, const CmdArgs& args) {
+  (void)args;
+  static const char* kinds[] = {"keyboard", "mouse", "generic"};
+  const ReportFilterClass& f = static_cast<USBTOBLEKBbridge*>(ctx)->reportFILTER();
+  const KeyFanInClass& fan = static_cast<USBTOBLEKBbridge*>(ctx)->keyFANIN();
+  const uint32_t now = millis();
+  Serial.println("USB:: dev kind      reports/s changed/s    reports  redundant  queued  refused");
+  for (uint8_t i = 0; i < USB_MAX_DEVICES; i++) {
+    REPORT_DEV_STATS st;
+    if (!f.stats(i, now, &st)) continue;
+    Serial.printf("USB:: %3u %-8s  %9u %9u %10u %10u  %6u %8u\n", i, kinds[st.kind < 3 ? st.kind : 2],
+                  st.reports_per_s, st.changed_per_s, st.reports, st.redundant, fan.inFLIGHT(i), fan.refused(i));
+  }
+  Serial.printf("USB:: %u keyboards merged, %u queued presses each at most\n", fan.count(), fan.share());
+  const UsbRecoveryClass& rec = static_cast<USBTOBLEKBbridge*>(ctx)->usbRECOVERY();
+  Serial.println("USB:: dev state     faults restarts reopens recovered");
+  for (uint8_t i = 0; i < USB_MAX_DEVICES; i++) {
+    USB_REC_STATS rs;
+    if (!rec.stats(i, &rs)) continue;
+    Serial.printf("USB:: %3u %-8s %7u %8u %7u %9u\n", i, UsbRecoveryClass::levelNAME(rs.level), rs.faults,
+                  rs.actions[USB_REC_RESTART], rs.actions[USB_REC_REOPEN], rs.recovered);
+  }
+}
+
+static void cmd_USB_RESET(void* ctx, const CmdArgs& args) {
+  (void)args;
+  static_cast<USBTOBLEKBbridge*>(ctx)->resetReportSTATS();
+}
+
+static constexpr CONSOLE_CMD BRIDGE_COMMANDS[] = {
+  {"TYPE",     nullptr, 0, cmd_TYPE,           "- type the following text over BLE, end with Ctrl-D"},
+  {"DEBOUNCE", "STATS", 0, cmd_DEBOUNCE_STATS, "- suppressed chatter edges and the worst key"},
+  {"DEBOUNCE", nullptr, 1, cmd_DEBOUNCE,       "<mode> [ms]  - 0 off, 1 eager, 2 defer"},
+  {"KEYMAP",   "LAYOUT",1, cmd_KEYMAP_LAYOUT,  "<n>  - 0 QWERTY, 1 Colemak"},
+  {"KEYMAP",   "OPTS",  1, cmd_KEYMAP_OPTS,    "<bits>  - 1 Caps->Ctrl, 2 swap Alt/GUI"},
+  {"KEYMAP",   "MAP",   2, cmd_KEYMAP_MAP,     "<from> <to>  - override one usage (to 0 disables)"},
+  {"KEYMAP",   "CLEAR", 0, cmd_KEYMAP_CLEAR,   "- drop all overrides"},
+  {"KEYMAP",   "SAVE",  0, cmd_KEYMAP_SAVE,    "- persist the keymap"},
+  {"KEYMAP",   nullptr, 0, cmd_KEYMAP,         "- print the keymap"},
+  {"USB",      "RESET", 0, cmd_USB_RESET,      "- clear the per-device report counters"},
+  {"USB",      nullptr, 0, cmd_USB,            "- per-device report rates, queue share and error recovery"},
+};
+
+void USBTOBLEKBbridge::registerCOMMANDS(SerialConsoleClass& console) {
+  console.addTABLE(BRIDGE_COMMANDS, this, "BRIDGE");
+}
+
+// ----------------- telemetry -----------------
+// once a second on the telemetry task: queue depths and error counters
+void USBTOBLEKBbridge::telemetry_SAMPLE(void* ctx) {
+  USBTOBLEKBbridge* self = static_cast<USBTOBLEKBbridge*>(ctx);
+  const uint32_t now = millis();
+  if (self->KBQueue) {
+    telemetry.emitAT(TELEM_QUEUE, TELEM_Q_KEYS, uxQueueMessagesWaiting(self->KBQueue), KEYQUEUE_DEPTH, now);
+  }
+  if (self->hid_host_event_queue) {
+    telemetry.emitAT(TELEM_QUEUE, TELEM_Q_HID, uxQueueMessagesWaiting(self->hid_host_event_queue), HID_EVENT_QUEUE_DEPTH, now);
+  }
+  if (self->BulkStream) {
+    telemetry.emitAT(TELEM_QUEUE, TELEM_Q_BULK, xStreamBufferBytesAvailable(self->BulkStream), BULK_STREAM_SIZE, now);
+  }
+  uint32_t drops = self->key_drops;
+  if (drops != self->telem_key_drops) {
+    telemetry.emitAT(TELEM_COUNTER, TELEM_C_KEY_DROPS, drops, drops - self->telem_key_drops, now);
+    self->telem_key_drops = drops;
+  }
+  uint32_t suppressed;
+  uint8_t worst, worst_count;
+  self->debounce_STATS(&suppressed, &worst, &worst_count);
+  if (suppressed != self->telem_suppressed) {
+    telemetry.emitAT(TELEM_COUNTER, TELEM_C_DEBOUNCE, suppressed, suppressed - self->telem_suppressed, now);
+    self->telem_suppressed = suppressed;
+  }
+  uint32_t redundant = self->reports.redundantTOTAL();
+  if (redundant != self->telem_redundant) {
+    telemetry.emitAT(TELEM_COUNTER, TELEM_C_REDUNDANT, redundant, redundant - self->telem_redundant, now);
+    self->telem_redundant = redundant;
+  }
+  uint32_t faults = self->recovery.faultTOTAL();
+  if (faults != self->telem_usb_faults) {
+    telemetry.emitAT(TELEM_COUNTER, TELEM_C_USB_FAULTS, faults, faults - self->telem_usb_faults, now);
+    self->telem_usb_faults = faults;
+  }
+}
+
+void USBTOBLEKBbridge::registerTELEMETRY(TelemetryClass& t) {
+  t.addSAMPLER(telemetry_SAMPLE, this);
 }
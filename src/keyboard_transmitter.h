@@ -6,9 +6,31 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/queue.h>
 #include <freertos/task.h>
+#include <freertos/stream_buffer.h>
+#include <freertos/semphr.h>
+#include <atomic>
 
 #include <OledLogger.h>
 #include "helper_keyboard_ble.h"
+#include "key_remap.h"
+#include "key_debounce.h"
+#include "kb_event.h"
+#include "timer_wheel.h"
+#include "key_layers.h"
+#include "key_combos.h"
+#include "key_macros.h"
+#include "macro_store.h"
+#include "link_pacer.h"
+#include "bulk_text.h"
+#include "power_policy.h"
+#include "serial_console.h"
+#include "telemetry.h"
+#include "deferred_log.h"
+#include "latency_hist.h"
+#include "idle_manager.h"
+#include "report_filter.h"
+#include "key_fanin.h"
+#include "usb_recovery.h"
 #include "usb/usb_host.h"
 #include "hid_host.h"
 #include "hid_usage_keyboard.h"
@@ -17,10 +39,18 @@
 // -------------------- user config --------------------
 #define BLE_DEVICE_NAME   "ESP_USB2BLE"
 #define KEYQUEUE_DEPTH    256
+#define HID_EVENT_QUEUE_DEPTH       10      // USB host driver events -> HID worker
+#define HID_MAX_OPEN_IFACES         8       // interfaces open at once, each with a place in the close list
 #define BLE_TASK_STACK    4096
 #define USB_EVENT_STACK   4096
 #define HID_HOST_DRIVER_STACK       8192
 #define HID_WORKER_STACK            4096
+#define BLE_NOTIFY_RESERVE          1       // paced bursts: controller buffers left to the rest of the stack
+#define BLE_KEY_DELAY_MS            7       // BleKeyboard's own per-report delay (library default)
+#define BULK_STREAM_SIZE            2048    // serial -> BLE bulk text buffer
+#define KB_DEBOUNCE_MODE            DEBOUNCE_OFF    // DEBOUNCE_EAGER / DEBOUNCE_DEFER for chattering boards
+#define KB_DEBOUNCE_MS              5
+#define BLE_BATTERY_DELTA           5       // Battery Service: notify when the level moved this many %
 // #define HID_ALPHABET_START          0x04
 // #define HID_ALPHABET_ENDING         0x1D
 // #define HID_TOP_ROW_NS_START        0x1E
@@ -60,11 +90,6 @@ const uint16_t  PREFERED_MTU      = 247;
 const char TOPROW_NORMAL[] = "1234567890";
 const char TOPROW_SHIFTED[] = "!@#$%^&*()";
 
-typedef struct KB_EVENT{
-    uint8_t usage;
-    uint8_t mods;
-    bool pressed;
-};
 // Forward declaration of C wrapper for HID driver callback (we install this as the callback)
 extern "C" void hid_host_device_callback_cwrap(hid_host_device_handle_t hid_device_handle, const hid_host_driver_event_t event, void *arg);
 
@@ -74,7 +99,7 @@ class USBTOBLEKBbridge{
 public:
     USBTOBLEKBbridge();
     bool begin();
-    void enqueueKey(uint8_t usage,uint8_t mods,bool pressed);
+    void enqueueKey(uint8_t usage,uint8_t mods,bool pressed,uint8_t src = KB_SRC_NONE);
     static void TASK_Ble_Wrapper(void* pv);
     static void TASK_Usb_lib_Wrapper(void* pv);
     static void Hid_Worker_Wrapper(void* pv);
@@ -82,11 +107,72 @@ public:
     static USBTOBLEKBbridge* instance();
     static void set_instance(USBTOBLEKBbridge* p);
     static void hid_host_Interface_callback_FORWARD(hid_host_device_handle_t hdh, const hid_host_interface_event_t event,void* arg);
+    KeyRemapClass& keyREMAP() { return remap; }
+    void registerCOMMANDS(SerialConsoleClass& console);
+    // bulk text injection (single writer, e.g. the serial console task)
+    size_t bulk_WRITE(const uint8_t* data, size_t len);    // non-blocking, returns bytes taken
+    size_t bulk_SPACE();
+    void   bulk_END();                                      // end of input; stats print once it is typed
+    void   bulk_STATS(uint32_t* chars, uint32_t* chars_per_sec);   // as of the last finished stream
+    void   bulk_RESET_STATS();                              // applied by TASK_BLE before the next text
+    // per-key debounce of incoming reports (mode: DEBOUNCE_OFF / _EAGER / _DEFER)
+    void   setDEBOUNCE(uint8_t mode, uint16_t window_ms);
+    void   debounce_STATS(uint32_t* suppressed, uint8_t* worst_usage, uint8_t* worst_count);
+    // radio settings of a power tier: TX power, advertising and (when connected) connection params
+    void   applyPOWER(const POWER_TIER_PARAMS& p);
+    bool   bleCONNECTED();
+    uint32_t keyEVENTS() const { return key_events; }     // key events produced so far (activity estimate)
+    // BLE Battery Service: pushes the level only on a delta crossing or a charging edge
+    bool   reportBATTERY(uint8_t percent, bool charging);
+    void   setBatteryDELTA(uint8_t percent) { batt_delta = percent ? percent : 1; }
+    // queue depths and drop counters as binary telemetry records, sampled once a second
+    void   registerTELEMETRY(TelemetryClass& t);
+    // report-to-BLE latency of key events, written by TASK_BLE; readers take windowed percentiles
+    const LatencyHistClass& latencyHIST() const { return latency; }
+    // per-device report rates; redundant reports are dropped before decoding
+    const ReportFilterClass& reportFILTER() const { return reports; }
+    void   resetReportSTATS() { reports.resetSTATS(); }
+    // keyboards merged into the logical keyboard and their share of KBQueue
+    const KeyFanInClass& keyFANIN() const { return fanin; }
+    // per-device transfer errors and the restart / reopen actions taken for them
+    const UsbRecoveryClass& usbRECOVERY() const { return recovery; }
 private:
     QueueHandle_t           KBQueue;
     BleKeyboard             BleKBd;
     TaskHandle_t            BleTaskHandle;
     uint8_t                 active_mods;
+    KeyRemapClass           remap;
+    TimerWheelClass         wheel;          // owned and advanced by TASK_BLE only
+    KeyLayerClass           layers;         // KBQueue -> layers -> combos -> BLE
+    KeyComboClass           combos;
+    KeyMacroClass           macros;
+    MacroStoreClass         macro_store;    // NVS side of macros, saveDIRTY() on the HID worker
+    LinkPacerClass          pacer;          // paces macro playback / bulk text to the negotiated link
+    StreamBufferHandle_t    BulkStream;
+    BulkTextClass           bulk;
+    bool                    bulk_active;
+    std::atomic<bool>       bulk_reset_req;     // console -> TASK_BLE, which owns `bulk`
+    std::atomic<bool>       bulk_end_req;
+    std::atomic<uint32_t>   bulk_chars;         // published by TASK_BLE when a stream is done
+    std::atomic<uint32_t>   bulk_cps;
+    KeyDebounceClass        debounce;       // owned by diff_KB_REPORT, under KBDiffMutex
+    SemaphoreHandle_t       KBDiffMutex;
+    volatile uint32_t       debounce_due_ms;    // millis() of the next re-check, 0 = none
+    volatile uint32_t       key_events;
+    volatile uint32_t       key_drops;          // enqueueKey() found KBQueue full
+    int16_t                 batt_sent_pct;      // last level given to the Battery Service, -1 = none
+    bool                    batt_sent_charging;
+    uint8_t                 batt_delta;
+    uint32_t                telem_key_drops;    // counter values last sent as telemetry
+    uint32_t                telem_suppressed;
+    uint32_t                telem_redundant;
+    LatencyHistClass        latency;
+    ReportFilterClass       reports;        // changed() on the USB driver task only
+    KeyFanInClass           fanin;          // update() / admit() under KBDiffMutex
+    UsbRecoveryClass        recovery;       // fault() from any task, the rest on the HID worker
+    uint32_t                telem_usb_faults;
+    std::atomic<hid_host_device_handle_t> closing[HID_MAX_OPEN_IFACES];    // DISCONNECTED, closed by the HID worker
+    uint8_t                 open_ifaces;    // HID worker only
     typedef struct HidKB_host_Event_Queue_t{
         hid_host_device_handle_t hdh;
         hid_host_driver_event_t event;
@@ -95,14 +181,35 @@ private:
     QueueHandle_t hid_host_event_queue;
     static USBTOBLEKBbridge* s_instance_ptr;
     void TASK_BLE();
+    void send_KB_EVENT(const KB_EVENT& event);
+    static void ble_Event_SINK(const KB_EVENT& event, void* arg);
+    static void combo_Event_SINK(const KB_EVENT& event, void* arg);
+    void handle_KB_ACTION(uint8_t usage);
+    void play_MACRO_STEP();
+    void play_BULK_STEP();
+    void bulk_FINISHED();
+    void begin_REPORT_BURST();
+    void end_REPORT_BURST();
+    void send_KB_REPORT(const KB_REPORT& r);
+    static uint32_t ble_Conn_INTERVAL_US();
+    static uint16_t ble_NOTIFY_FREE();
     void TASK_Hid_WORKER();
     static void TASK_Usb_LIBRARY(void* arg);
     static bool is_SHIFT(uint8_t mods);
     static char usage_TO_ASCII(uint8_t usage, uint8_t mods);
     static void hid_Host_Interface_CALLBACK(hid_host_device_handle_t hdh,hid_host_interface_event_t event,void* arg);
+    static uint8_t report_KIND(const hid_host_dev_params_t& params);
+    static esp_err_t start_DEVICE(hid_host_device_handle_t hdh);
+    void close_DEVICE(hid_host_device_handle_t hdh);
+    void close_PENDING();
+    void wake_WORKER();
+    void service_RECOVERY();
     static void hid_Host_Device_EVENT(hid_host_device_handle_t hdh, const hid_host_driver_event_t event,void* arg);    
-    static void hid_KB_Report_CALLBACK(const uint8_t *const data, const int len);
+    static void hid_KB_Report_CALLBACK(uint8_t slot, const uint8_t *const data, const int len);
+    void diff_KB_REPORT(uint8_t dev, uint8_t mods_in, const uint8_t* keys_in);
     static void hid_MOUSE_Report_CALLBACK(const uint8_t *const data, const int length);
     static void setNimBLE_PREF();
+    static esp_power_level_t tx_POWER_LEVEL(int8_t dbm);
     static void hid_Host_Generic_Report_CALLBACK(const uint8_t *const data, const int len);
+    static void telemetry_SAMPLE(void* ctx);
 };
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+// Millisecond latency histogram with one writer and any number of windowed readers.
+//
+// 1 ms buckets up to 31 ms, 8 ms buckets up to 287 ms, then one overflow bucket. The writer only
+// increments cumulative counters; a reader keeps its own copy from the previous look and works
+// on the difference, so nobody ever resets the counters under the writer.
+
+const uint8_t  LAT_HIST_FINE        = 32;
+const uint8_t  LAT_HIST_COARSE_MS   = 8;
+const uint8_t  LAT_HIST_BUCKETS     = 65;
+const uint16_t LAT_HIST_NONE        = 0xFFFF;
+
+class LatencyHistClass {
+public:
+    LatencyHistClass()
+    {
+        for (uint8_t i = 0; i < LAT_HIST_BUCKETS; i++) _count[i].store(0, std::memory_order_relaxed);
+    }
+    // writer
+    inline void record(uint32_t ms)
+    {
+        std::atomic<uint32_t>& c = _count[bucket(ms)];
+        c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    // reader: bucket counts since *last (updated), then the upper edge of the bucket holding the
+    // given per-mille rank; LAT_HIST_NONE when nothing was recorded
+    uint16_t windowPERCENTILE(uint32_t* last, uint16_t per_mille, uint32_t* samples = nullptr) const
+    {
+        uint32_t d[LAT_HIST_BUCKETS];
+        uint32_t total = 0;
+        for (uint8_t i = 0; i < LAT_HIST_BUCKETS; i++)
+        {
+            uint32_t now = _count[i].load(std::memory_order_relaxed);
+            d[i] = now - last[i];
+            last[i] = now;
+            total += d[i];
+        }
+        if (samples) *samples = total;
+        if (!total) return LAT_HIST_NONE;
+        uint32_t rank = (uint32_t)(((uint64_t)total * per_mille + 999) / 1000);
+        uint32_t seen = 0;
+        for (uint8_t i = 0; i < LAT_HIST_BUCKETS; i++)
+        {
+            seen += d[i];
+            if (seen >= rank) return upperMS(i);
+        }
+        return upperMS(LAT_HIST_BUCKETS - 1);
+    }
+    static inline uint8_t bucket(uint32_t ms)
+    {
+        if (ms < LAT_HIST_FINE) return (uint8_t)ms;
+        uint32_t b = LAT_HIST_FINE + (ms - LAT_HIST_FINE) / LAT_HIST_COARSE_MS;
+        return b < LAT_HIST_BUCKETS - 1 ? (uint8_t)b : LAT_HIST_BUCKETS - 1;
+    }
+    static inline uint16_t upperMS(uint8_t b)
+    {
+        if (b < LAT_HIST_FINE) return b;
+        return (uint16_t)(LAT_HIST_FINE + (b - LAT_HIST_FINE + 1) * LAT_HIST_COARSE_MS - 1);
+    }
+private:
+    std::atomic<uint32_t> _count[LAT_HIST_BUCKETS];
+};
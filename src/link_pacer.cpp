@@ -0,0 +1,51 @@
+// link_pacer.cpp
+#include "link_pacer.h"
+
+LinkPacerClass::LinkPacerClass()
+    :   _interval_us(7500),
+        _reserve(1),
+        _stalled(false),
+        _stall_us(0),
+        _stalls(0)
+{
+}
+
+void LinkPacerClass::setINTERVAL(uint32_t interval_us)
+{
+    // 7.5 ms is the shortest interval BLE allows; also guards against a zero from a dead link
+    _interval_us = (interval_us < 7500) ? 7500 : interval_us;
+}
+
+void LinkPacerClass::reset(uint32_t now_us)
+{
+    (void)now_us;
+    _stalled = false;
+    _stalls = 0;
+}
+
+bool LinkPacerClass::take(uint32_t now_us, uint16_t stack_free)
+{
+    if (stack_free > _reserve)
+    {
+        _stalled = false;
+        return true;
+    }
+    // the wait restarts only once it has run out, so polling early does not push it back
+    if (!_stalled || now_us - _stall_us >= _interval_us)
+    {
+        _stalled = true;
+        _stall_us = now_us;
+        _stalls++;
+    }
+    return false;
+}
+
+uint32_t LinkPacerClass::usUntilCREDIT(uint32_t now_us) const
+{
+    if (!_stalled)
+    {
+        return 0;
+    }
+    uint32_t waited = now_us - _stall_us;
+    return waited >= _interval_us ? 0 : _interval_us - waited;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <stdint.h>
+
+// Pacing of HID notification bursts (macro playback, bulk text) by the BLE stack's own credits.
+//
+// Every notification takes one of the controller's ACL buffers; the host gets the buffer back
+// when the controller reports the packet completed, i.e. acknowledged by the peer in a
+// connection event. take() is handed the host's free-buffer count and leaves `reserve` of them
+// to the rest of the stack (battery level, ATT responses), so a burst runs exactly as fast as
+// the negotiated link drains and never piles packets up in the host. When nothing is free,
+// buffers can only come back in a later connection event: usUntilCREDIT() waits one interval
+// from the stall, the event anchor being unknown here. Pure logic on a caller-supplied
+// microsecond clock.
+
+class LinkPacerClass {
+public:
+    LinkPacerClass();
+    void     setINTERVAL(uint32_t interval_us);              // negotiated connection interval
+    void     setRESERVE(uint8_t reserve) { _reserve = reserve; }
+    void     reset(uint32_t now_us);
+    bool     take(uint32_t now_us, uint16_t stack_free);     // true: send one notification now
+    uint32_t usUntilCREDIT(uint32_t now_us) const;
+    uint32_t intervalUS() const { return _interval_us; }
+    uint32_t stalls() const { return _stalls; }              // waits for the link since reset()
+private:
+    uint32_t _interval_us;
+    uint8_t  _reserve;
+    bool     _stalled;
+    uint32_t _stall_us;
+    uint32_t _stalls;
+};
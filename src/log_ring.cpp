@@ -0,0 +1,60 @@
+// log_ring.cpp
+#include "log_ring.h"
+#include <stdio.h>
+
+bool LogRingClass::push(uint8_t level, uint32_t time_ms, const char* fmt, const uint32_t* args, uint8_t nargs)
+{
+    if (nargs > DLOG_MAX_ARGS)
+    {
+        nargs = DLOG_MAX_ARGS;
+    }
+    return _ring.emplace([=](DLOG_RECORD& r, uint32_t)
+    {
+        r.fmt = fmt;
+        r.time_ms = time_ms;
+        r.level = level;
+        r.nargs = nargs;
+        for (uint8_t i = 0; i < nargs; i++)
+        {
+            r.args[i] = args[i];
+        }
+    });
+}
+
+const char* LogRingClass::levelNAME(uint8_t level)
+{
+    static const char* const NAMES[] = {"-", "E", "W", "I", "D"};
+    return level <= DLOG_LEVEL_DEBUG ? NAMES[level] : "?";
+}
+
+// unused argument slots are passed as well; printf ignores surplus arguments
+size_t LogRingClass::format(const DLOG_RECORD& r, char* out, size_t cap)
+{
+    uint32_t a[DLOG_MAX_ARGS] = {0};
+    for (uint8_t i = 0; i < r.nargs && i < DLOG_MAX_ARGS; i++)
+    {
+        a[i] = r.args[i];
+    }
+    int n = snprintf(out, cap, "%5u.%03u %s ", (unsigned)(r.time_ms / 1000), (unsigned)(r.time_ms % 1000), levelNAME(r.level));
+    if (n < 0 || (size_t)n >= cap)
+    {
+        return 0;
+    }
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wformat-nonliteral"
+    #pragma GCC diagnostic ignored "-Wformat-security"
+    int m = snprintf(out + n, cap - n, r.fmt, a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]);
+    #pragma GCC diagnostic pop
+    if (m < 0)
+    {
+        m = 0;
+    }
+    size_t len = (size_t)n + (size_t)m;
+    if (len > cap - 2)
+    {
+        len = cap - 2;                  // truncated: keep the newline
+    }
+    out[len++] = '\n';
+    out[len] = 0;
+    return len;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "mpmc_ring.h"
+
+// Lock-free store for deferred log records, independent of the RTOS so tools/ can bench it.
+//
+// A record is the format string's address, a level, a timestamp and up to DLOG_MAX_ARGS
+// integer arguments - nothing is formatted on the producer side. Format strings must be
+// literals (they are read when the record is drained) and may only use integer conversions
+// (%d %u %x %c with flags and width); pack bytes or scale floats at the call site. The ring
+// is an MpmcRing (mpmc_ring.h), the same queue the telemetry records go through.
+
+const uint8_t  DLOG_LEVEL_NONE      = 0;
+const uint8_t  DLOG_LEVEL_ERROR     = 1;
+const uint8_t  DLOG_LEVEL_WARN      = 2;
+const uint8_t  DLOG_LEVEL_INFO      = 3;
+const uint8_t  DLOG_LEVEL_DEBUG     = 4;
+
+const uint8_t  DLOG_MAX_ARGS        = 8;
+const uint16_t DLOG_RING_SIZE       = 64;       // records, power of two
+const uint8_t  DLOG_LINE_MAX        = 128;
+
+typedef struct DLOG_RECORD {
+    const char* fmt;
+    uint32_t    time_ms;
+    uint8_t     level;
+    uint8_t     nargs;
+    uint32_t    args[DLOG_MAX_ARGS];
+} DLOG_RECORD;
+
+// up to four bytes big-endian in one argument, so "%08X" prints them in order; zero past len
+static inline uint32_t dlogPACK(const uint8_t* p, int len)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        v = (v << 8) | (i < len ? p[i] : 0);
+    }
+    return v;
+}
+
+class LogRingClass {
+public:
+    // producer side: any task, any core; false if the ring was full
+    bool push(uint8_t level, uint32_t time_ms, const char* fmt, const uint32_t* args, uint8_t nargs);
+    // consumer side: one task only
+    bool pop(DLOG_RECORD* out) { return _ring.pop(out); }
+    uint32_t dropped() const { return _ring.dropped(); }
+
+    static const char* levelNAME(uint8_t level);
+    static size_t format(const DLOG_RECORD& r, char* out, size_t cap);     // "  12.345 D text\n"
+private:
+    MpmcRing<DLOG_RECORD, DLOG_RING_SIZE> _ring;
+};
@@ -0,0 +1,76 @@
+// macro_store.cpp
+#include "macro_store.h"
+
+#define MACRO_PREF_NAMESPACE    "KEYMACRO_V1"
+
+MacroStoreClass::MacroStoreClass()
+    :   _prefs(),
+        _open(false)
+{
+}
+
+void MacroStoreClass::_slotKEY(uint8_t slot, char* key)
+{
+    key[0] = 'm';
+    key[1] = (char)('0' + slot);
+    key[2] = '\0';
+}
+
+bool MacroStoreClass::begin(KeyMacroClass& macros)
+{
+    if (!_prefs.begin(MACRO_PREF_NAMESPACE, false))
+    {
+        Serial.println("KEYMACRO::PREFS::Open failed");
+        return false;
+    }
+    _open = true;
+    uint8_t buf[MACRO_MAX_BYTES];
+    for (uint8_t s = 0; s < MACRO_SLOTS; s++)
+    {
+        char key[4];
+        _slotKEY(s, key);
+        size_t len = _prefs.getBytesLength(key);
+        if (len > 0 && len <= MACRO_MAX_BYTES)
+        {
+            macros.loadSLOT(s, buf, (uint16_t)_prefs.getBytes(key, buf, len));
+        }
+    }
+    return true;
+}
+
+uint8_t MacroStoreClass::saveDIRTY(KeyMacroClass& macros)
+{
+    const uint8_t dirty = macros.takeDIRTY();
+    if (!dirty || !_open)
+    {
+        return 0;
+    }
+    uint8_t saved = 0;
+    uint8_t retry = 0;
+    uint8_t buf[MACRO_MAX_BYTES];
+    for (uint8_t s = 0; s < MACRO_SLOTS; s++)
+    {
+        if (!(dirty & (1u << s))) continue;
+        uint16_t len;
+        if (!macros.copySLOT(s, buf, &len))
+        {
+            retry |= (uint8_t)(1u << s);
+            continue;
+        }
+        char key[4];
+        _slotKEY(s, key);
+        if (len)
+        {
+            _prefs.putBytes(key, buf, len);
+        }
+        else
+        {
+            _prefs.remove(key);
+        }
+        Serial.printf("KEYMACRO:Slot %u saved (%u bytes)\n", s, len);
+        saved++;
+    }
+    // being recorded again: its stopRECORD() marks it dirty anyway, this covers a copy that raced
+    macros.markDIRTY(retry);
+    return saved;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <Arduino.h>
+#include <Preferences.h>
+#include "key_macros.h"
+
+// NVS persistence of the macro slots, one blob per slot ("m0".."m3").
+//
+// Kept apart from KeyMacroClass so the recorder and player stay plain C++. begin() loads the
+// slots before the BLE task starts; saveDIRTY() writes the slots whose recording closed since
+// the last call and runs on the HID worker, so the flash erase / write never stalls TASK_BLE.
+// A slot that is being re-recorded while it is copied stays dirty and is saved next time.
+
+class MacroStoreClass {
+public:
+    MacroStoreClass();
+    bool    begin(KeyMacroClass& macros);
+    uint8_t saveDIRTY(KeyMacroClass& macros);   // slots written
+private:
+    Preferences _prefs;
+    bool        _open;
+
+    static void _slotKEY(uint8_t slot, char* key);
+};
@@ -1,11 +1,150 @@
 #include "helper_keyboard_ble.h"
 #include <keyboard_transmitter.h>
+#include "batt_history.h"
+#include "adc_service.h"
+#include "dashboard.h"
+#include "idle_manager.h"
+#define POWER_POLL_MS           1000
+#define DASH_STATS_WINDOW_MS    5000            // p99 and key rate are recomputed this often
+// extra scheduler channels; ADC_PIN_NONE on boards without the divider / thermistor
+#define ADC_PIN_NONE            0xFF
+#define VBUS_ADC_PIN            ADC_PIN_NONE
+#define VBUS_DIVIDER            2.0f            // (top + bottom) / bottom
+#define NTC_ADC_PIN             ADC_PIN_NONE
+#define NTC_R_FIXED             10000.0f        // NTC from the pin to GND, fixed resistor to 3V3
+#define NTC_R25                 10000.0f
+#define NTC_BETA                3950.0f
 BatteryMonitorClass batmon;
-static String _line;
+static PowerPolicyClass power;
+static uint32_t power_last_poll = 0;
+static bool power_connected = false;
+static uint32_t power_last_events = 0;
 static USBTOBLEKBbridge global_bridge;
+static SerialConsoleClass console;
+static BattHistoryClass history;
+static DashboardClass dashboard;
+
+// battery state -> power tier; re-applied after every reconnect since the central picks new params
+static void service_POWER()
+{
+  uint32_t now = millis();
+  uint32_t dt = now - power_last_poll;
+  power_last_poll = now;
+
+  float volts;
+  int pct;
+  bool charging = false;
+  if (!batmon.getBatterySTATUS(&volts, &pct, &charging)) return;
+  bool changed = power.update(pct, charging);
+  history.record((uint16_t)(volts * 1000.0f), charging);
+  global_bridge.reportBATTERY((uint8_t)constrain(pct, 0, 100), charging);
+  bool connected = global_bridge.bleCONNECTED();
+
+  // each key event is roughly one input report on the link
+  uint32_t events = global_bridge.keyEVENTS();
+  float rps = dt ? (events - power_last_events) * 1000.0f / dt : 0.0f;
+  power_last_events = events;
+  batmon.setLoadMA(PowerPolicyClass::projectedLOAD_MA(power.params(), rps, connected));
+  if (changed || (connected && !power_connected)) {
+    global_bridge.applyPOWER(power.params());
+    batmon.setPolicyINTERVAL(power.params().batt_interval_ms);
+  }
+  // the cell may not last until the history page fills or times out
+  if (changed && power.tier() == POWER_TIER_CRITICAL) history.flush();
+  if (changed) {
+    Serial.printf("POWER:: tier %s (%d%%%s)\n", PowerPolicyClass::tierNAME(power.tier()), pct, charging ? ", charging" : "");
+  }
+  power_connected = connected;
+}
+
+// filtered raw -> VBUS mV; linear 11 dB scale, a few % is enough to tell 5 V from absent
+static float convert_VBUS(float raw, void* ctx)
+{
+  (void)ctx;
+  return raw * (3300.0f / 4095.0f) * VBUS_DIVIDER;
+}
+
+// filtered raw -> degC by the Beta equation; ratiometric to the 3V3 rail
+static float convert_NTC(float raw, void* ctx)
+{
+  (void)ctx;
+  float ratio = raw / 4095.0f;
+  if (ratio <= 0.001f || ratio >= 0.999f) return NAN;   // open or shorted
+  float r = NTC_R_FIXED * ratio / (1.0f - ratio);
+  return 1.0f / (logf(r / NTC_R25) / NTC_BETA + 1.0f / 298.15f) - 273.15f;
+}
+
+static void begin_ADC_CHANNELS()
+{
+  if (VBUS_ADC_PIN != ADC_PIN_NONE) {
+    ADC_CHANNEL_DEF vbus = {"vbus", VBUS_ADC_PIN, 250, 5, 5, 0.5f, convert_VBUS, nullptr};
+    adc.addCHANNEL(vbus);
+  }
+  if (NTC_ADC_PIN != ADC_PIN_NONE) {
+    ADC_CHANNEL_DEF ntc = {"ntc", NTC_ADC_PIN, 2000, 5, 5, 0.2f, convert_NTC, nullptr};
+    adc.addCHANNEL(ntc);
+  }
+}
+
+// runs on the dashboard task; only atomics, lock-free snapshots and plain loads
+static void fill_DASHBOARD(DASH_STATE* s, void* ctx)
+{
+  (void)ctx;
+  static uint32_t lat_last[LAT_HIST_BUCKETS] = {0};
+  static uint32_t window_start = 0;
+  static uint32_t window_events = 0;
+  static uint16_t p99 = DASH_NONE;
+  static uint16_t rate_x10 = 0;
+  uint32_t now = millis();
+  if (now - window_start >= DASH_STATS_WINDOW_MS) {
+    uint16_t p = global_bridge.latencyHIST().windowPERCENTILE(lat_last, 990);
+    p99 = (p == LAT_HIST_NONE) ? DASH_NONE : p;
+    uint32_t events = global_bridge.keyEVENTS();
+    rate_x10 = (uint16_t)((events - window_events) * 10000u / (now - window_start));
+    window_events = events;
+    window_start = now;
+  }
+
+  const KeyRemapClass& remap = global_bridge.keyREMAP();
+  s->ble_connected = global_bridge.bleCONNECTED();
+  s->host_layout = KeyRemapClass::layoutNAME(remap.layout());
+  s->host_mac = (remap.options() & REMAP_OPT_SWAP_ALT_GUI) != 0;
+  BATT_SNAPSHOT b;
+  s->have_battery = batmon.getSNAPSHOT(&b);
+  s->battery_mv = s->have_battery ? (uint16_t)(b.voltage * 1000.0f) : 0;
+  s->battery_pct = s->have_battery ? (uint8_t)constrain(b.percent, 0, 100) : 0;
+  s->charging = batmon.chargeSTATUS().valid() ? batmon.chargeSTATUS().charging() : (s->have_battery && b.charging);
+  s->latency_p99_ms = p99;
+  s->keys_per_s_x10 = rate_x10;
+  s->power_tier = PowerPolicyClass::tierNAME(power.tier());
+  s->uptime_s = now / 1000;
+}
+
+static void cmd_POWER(void* ctx, const CmdArgs& args)
+{
+  (void)ctx;
+  (void)args;
+  Serial.printf("POWER:: current tier %s\n", PowerPolicyClass::tierNAME(power.tier()));
+  Serial.println("POWER:: tier      tx  conn ms      duty idle / 10 rps / adv");
+  for (uint8_t t = 0; t < POWER_TIER_COUNT; t++) {
+    const POWER_TIER_PARAMS& p = PowerPolicyClass::paramsFOR(t);
+    Serial.printf("POWER:: %-8s %+3d  %5.1f-%-5.1f %6.3f%% / %6.3f%% / %6.3f%%\n",
+                  PowerPolicyClass::tierNAME(t), p.tx_dbm, p.conn_min * 1.25f, p.conn_max * 1.25f,
+                  100.0f * PowerPolicyClass::projectedDUTY(p, 0.0f, true),
+                  100.0f * PowerPolicyClass::projectedDUTY(p, 10.0f, true),
+                  100.0f * PowerPolicyClass::projectedDUTY(p, 0.0f, false));
+  }
+}
+
+static constexpr CONSOLE_CMD MAIN_COMMANDS[] = {
+  {"POWER", nullptr, 0, cmd_POWER, "- power tier and projected radio duty per tier"},
+};
 
 void setup()
 {
+    Serial.begin(115200);
+    // PM locks exist before the first USB device opens
+    idlemgr.begin();
     //Initiate keyboard
     USBTOBLEKBbridge::set_instance(&global_bridge);
     if (!global_bridge.begin())
@@ -14,14 +153,43 @@ void setup()
       {
         vTaskDelay(pdMS_TO_TICKS(1000));
       }
-      
+
     }
-    
+    // one task owns the ADC; the battery monitor registers its channel with it
+    adc.begin();
+    begin_ADC_CHANNELS();
+    // battery monitor feeds the power policy; the bridge keeps working without it
+    batmon.begin();
+    // loop() sleeps on its notification, so a charger plug / unplug re-runs the policy at once
+    batmon.chargeSTATUS().addLISTENER(xTaskGetCurrentTaskHandle());
+    // without the battlog partition the history stays off; nothing else depends on it
+    history.begin();
+    // optional; without a panel on the bus the dashboard stays off
+    dashboard.begin(fill_DASHBOARD, nullptr);
+
+    global_bridge.registerTELEMETRY(telemetry);
+    telemetry.begin(Serial);
+    dlog.begin(Serial);
+
+    // one console task serves every subsystem
+    global_bridge.registerCOMMANDS(console);
+    batmon.registerCOMMANDS(console);
+    adc.registerCOMMANDS(console);
+    telemetry.registerCOMMANDS(console);
+    dlog.registerCOMMANDS(console);
+    history.registerCOMMANDS(console);
+    dashboard.registerCOMMANDS(console);
+    idlemgr.registerCOMMANDS(console);
+    console.addTABLE(MAIN_COMMANDS, nullptr, "SYSTEM");
+    console.begin(Serial);
+    // typed bytes wake the console, which then polls only on the slow idle schedule
+    Serial.onReceive([]() { console.wake(); });
+
 }
 
 void loop()
 {
-  vTaskDelay(pdMS_TO_TICKS(1000));
- 
-
-}
\ No newline at end of file
+  service_POWER();
+  idlemgr.service(millis());
+  ulTaskNotifyTake(pdTRUE, idlemgr.alignedTICKS(POWER_POLL_MS));
+}
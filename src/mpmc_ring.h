@@ -0,0 +1,86 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+// Bounded lock-free queue of fixed-size records: producers on any task or core, one consumer.
+//
+// Every slot carries a sequence word. A producer claims the slot whose sequence equals the head
+// position with one compare-and-swap on the head, fills the record in place and releases the
+// slot by storing pos + 1. A lower sequence means the consumer has not freed the slot yet, i.e.
+// the ring is full: the new record is dropped and counted, so producers never wait. The
+// consumer takes a slot once its sequence is tail + 1 and hands it back with tail + N.
+
+template <typename T, uint16_t N>
+class MpmcRing {
+public:
+    MpmcRing()
+        :   _head(0),
+            _tail(0),
+            _dropped(0)
+    {
+        for (uint16_t i = 0; i < N; i++)
+        {
+            _ring[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // producer side: fill(T& rec, uint32_t pos) writes the claimed record; false if the ring was full
+    template <typename FILL>
+    bool emplace(FILL fill)
+    {
+        uint32_t pos = _head.load(std::memory_order_relaxed);
+        SLOT* slot;
+        for (;;)
+        {
+            slot = &_ring[pos & (N - 1)];
+            int32_t dif = (int32_t)(slot->seq.load(std::memory_order_acquire) - pos);
+            if (dif == 0)
+            {
+                if (_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (dif < 0)
+            {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                pos = _head.load(std::memory_order_relaxed);
+            }
+        }
+        fill(slot->rec, pos);
+        slot->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side: one task only
+    bool pop(T* out)
+    {
+        SLOT& slot = _ring[_tail & (N - 1)];
+        if (slot.seq.load(std::memory_order_acquire) != _tail + 1)
+        {
+            return false;
+        }
+        *out = slot.rec;
+        slot.seq.store(_tail + N, std::memory_order_release);
+        _tail++;
+        return true;
+    }
+
+    uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+private:
+    static_assert(N && (N & (N - 1)) == 0, "MpmcRing size must be a power of two");
+
+    typedef struct SLOT {
+        std::atomic<uint32_t> seq;
+        T                     rec;
+    } SLOT;
+
+    SLOT                  _ring[N];
+    std::atomic<uint32_t> _head;                // next position to claim
+    uint32_t              _tail;                // consumer only
+    std::atomic<uint32_t> _dropped;
+};
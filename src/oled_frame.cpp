@@ -0,0 +1,122 @@
+// oled_frame.cpp
+#include "oled_frame.h"
+#include <string.h>
+
+// 5x7, ASCII 0x20..0x7E, one byte per column, bit 0 at the top
+static const uint8_t FONT_5X7[][5] = {
+    {0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5F,0x00,0x00}, {0x00,0x07,0x00,0x07,0x00}, {0x14,0x7F,0x14,0x7F,0x14}, // ' ' ! " #
+    {0x24,0x2A,0x7F,0x2A,0x12}, {0x23,0x13,0x08,0x64,0x62}, {0x36,0x49,0x55,0x22,0x50}, {0x00,0x05,0x03,0x00,0x00}, // $ % & '
+    {0x00,0x1C,0x22,0x41,0x00}, {0x00,0x41,0x22,0x1C,0x00}, {0x08,0x2A,0x1C,0x2A,0x08}, {0x08,0x08,0x3E,0x08,0x08}, // ( ) * +
+    {0x00,0x50,0x30,0x00,0x00}, {0x08,0x08,0x08,0x08,0x08}, {0x00,0x60,0x60,0x00,0x00}, {0x20,0x10,0x08,0x04,0x02}, // , - . /
+    {0x3E,0x51,0x49,0x45,0x3E}, {0x00,0x42,0x7F,0x40,0x00}, {0x42,0x61,0x51,0x49,0x46}, {0x21,0x41,0x45,0x4B,0x31}, // 0 1 2 3
+    {0x18,0x14,0x12,0x7F,0x10}, {0x27,0x45,0x45,0x45,0x39}, {0x3C,0x4A,0x49,0x49,0x30}, {0x01,0x71,0x09,0x05,0x03}, // 4 5 6 7
+    {0x36,0x49,0x49,0x49,0x36}, {0x06,0x49,0x49,0x29,0x1E}, {0x00,0x36,0x36,0x00,0x00}, {0x00,0x56,0x36,0x00,0x00}, // 8 9 : ;
+    {0x00,0x08,0x14,0x22,0x41}, {0x14,0x14,0x14,0x14,0x14}, {0x41,0x22,0x14,0x08,0x00}, {0x02,0x01,0x51,0x09,0x06}, // < = > ?
+    {0x32,0x49,0x79,0x41,0x3E}, {0x7E,0x11,0x11,0x11,0x7E}, {0x7F,0x49,0x49,0x49,0x36}, {0x3E,0x41,0x41,0x41,0x22}, // @ A B C
+    {0x7F,0x41,0x41,0x22,0x1C}, {0x7F,0x49,0x49,0x49,0x41}, {0x7F,0x09,0x09,0x01,0x01}, {0x3E,0x41,0x41,0x51,0x32}, // D E F G
+    {0x7F,0x08,0x08,0x08,0x7F}, {0x00,0x41,0x7F,0x41,0x00}, {0x20,0x40,0x41,0x3F,0x01}, {0x7F,0x08,0x14,0x22,0x41}, // H I J K
+    {0x7F,0x40,0x40,0x40,0x40}, {0x7F,0x02,0x04,0x02,0x7F}, {0x7F,0x04,0x08,0x10,0x7F}, {0x3E,0x41,0x41,0x41,0x3E}, // L M N O
+    {0x7F,0x09,0x09,0x09,0x06}, {0x3E,0x41,0x51,0x21,0x5E}, {0x7F,0x09,0x19,0x29,0x46}, {0x46,0x49,0x49,0x49,0x31}, // P Q R S
+    {0x01,0x01,0x7F,0x01,0x01}, {0x3F,0x40,0x40,0x40,0x3F}, {0x1F,0x20,0x40,0x20,0x1F}, {0x7F,0x20,0x18,0x20,0x7F}, // T U V W
+    {0x63,0x14,0x08,0x14,0x63}, {0x03,0x04,0x78,0x04,0x03}, {0x61,0x51,0x49,0x45,0x43}, {0x00,0x00,0x7F,0x41,0x41}, // X Y Z [
+    {0x02,0x04,0x08,0x10,0x20}, {0x41,0x41,0x7F,0x00,0x00}, {0x04,0x02,0x01,0x02,0x04}, {0x40,0x40,0x40,0x40,0x40}, // \ ] ^ _
+    {0x00,0x01,0x02,0x04,0x00}, {0x20,0x54,0x54,0x54,0x78}, {0x7F,0x48,0x44,0x44,0x38}, {0x38,0x44,0x44,0x44,0x20}, // ` a b c
+    {0x38,0x44,0x44,0x48,0x7F}, {0x38,0x54,0x54,0x54,0x18}, {0x08,0x7E,0x09,0x01,0x02}, {0x08,0x14,0x54,0x54,0x3C}, // d e f g
+    {0x7F,0x08,0x04,0x04,0x78}, {0x00,0x44,0x7D,0x40,0x00}, {0x20,0x40,0x44,0x3D,0x00}, {0x00,0x7F,0x10,0x28,0x44}, // h i j k
+    {0x00,0x41,0x7F,0x40,0x00}, {0x7C,0x04,0x18,0x04,0x78}, {0x7C,0x08,0x04,0x04,0x78}, {0x38,0x44,0x44,0x44,0x38}, // l m n o
+    {0x7C,0x14,0x14,0x14,0x08}, {0x08,0x14,0x14,0x18,0x7C}, {0x7C,0x08,0x04,0x04,0x08}, {0x48,0x54,0x54,0x54,0x20}, // p q r s
+    {0x04,0x3F,0x44,0x40,0x20}, {0x3C,0x40,0x40,0x20,0x7C}, {0x1C,0x20,0x40,0x20,0x1C}, {0x3C,0x40,0x30,0x40,0x3C}, // t u v w
+    {0x44,0x28,0x10,0x28,0x44}, {0x0C,0x50,0x50,0x50,0x3C}, {0x44,0x64,0x54,0x4C,0x44}, {0x00,0x08,0x36,0x41,0x00}, // x y z {
+    {0x00,0x00,0x7F,0x00,0x00}, {0x00,0x41,0x36,0x08,0x00}, {0x08,0x08,0x2A,0x1C,0x08},                             // | } ~
+};
+static const char FONT_FIRST = 0x20;
+static const char FONT_LAST = 0x7E;
+
+OledFrameClass::OledFrameClass()
+{
+    clear();
+}
+
+void OledFrameClass::clear()
+{
+    memset(_buf, 0, sizeof(_buf));
+}
+
+uint8_t OledFrameClass::text(uint8_t x, uint8_t page, const char* s, bool invert)
+{
+    if (page >= OLED_PAGES)
+    {
+        return x;
+    }
+    const uint8_t mask = invert ? 0xFF : 0x00;
+    for (; *s && x + OLED_CHAR_W <= OLED_WIDTH; s++)
+    {
+        char c = (*s < FONT_FIRST || *s > FONT_LAST) ? '?' : *s;
+        const uint8_t* g = FONT_5X7[c - FONT_FIRST];
+        for (uint8_t i = 0; i < 5; i++)
+        {
+            _buf[page][x++] = g[i] ^ mask;
+        }
+        _buf[page][x++] = mask;     // spacing column
+    }
+    return x;
+}
+
+void OledFrameClass::fillPAGE(uint8_t x, uint8_t page, uint8_t w, uint8_t pattern)
+{
+    if (page >= OLED_PAGES || x >= OLED_WIDTH)
+    {
+        return;
+    }
+    if (w > OLED_WIDTH - x)
+    {
+        w = OLED_WIDTH - x;
+    }
+    memset(&_buf[page][x], pattern, w);
+}
+
+void OledFrameClass::bar(uint8_t x, uint8_t page, uint8_t w, uint8_t percent)
+{
+    if (page >= OLED_PAGES || x >= OLED_WIDTH || w < 3)
+    {
+        return;
+    }
+    if (w > OLED_WIDTH - x)
+    {
+        w = OLED_WIDTH - x;
+    }
+    if (percent > 100)
+    {
+        percent = 100;
+    }
+    const uint8_t inner = w - 2;
+    const uint8_t filled = (uint8_t)((inner * percent + 50) / 100);
+    _buf[page][x] = 0x7F;
+    for (uint8_t i = 0; i < inner; i++)
+    {
+        _buf[page][x + 1 + i] = i < filled ? 0x7F : 0x41;
+    }
+    _buf[page][x + w - 1] = 0x7F;
+}
+
+bool OledFrameClass::dirtyRANGE(const OledFrameClass& a, const OledFrameClass& b, uint8_t page, uint8_t* x0, uint8_t* x1)
+{
+    const uint8_t* pa = a._buf[page];
+    const uint8_t* pb = b._buf[page];
+    uint8_t lo = 0;
+    while (lo < OLED_WIDTH && pa[lo] == pb[lo]) lo++;
+    if (lo == OLED_WIDTH)
+    {
+        return false;
+    }
+    uint8_t hi = OLED_WIDTH - 1;
+    while (pa[hi] == pb[hi]) hi--;
+    *x0 = lo;
+    *x1 = hi;
+    return true;
+}
+
+void OledFrameClass::copyPAGE(const OledFrameClass& from, uint8_t page, uint8_t x0, uint8_t x1)
+{
+    memcpy(&_buf[page][x0], &from._buf[page][x0], (size_t)(x1 - x0 + 1));
+}
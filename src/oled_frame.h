@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// 128x64 monochrome framebuffer in the SSD1306's own memory layout, independent of Arduino so
+// tools/ can render and diff frames.
+//
+// Byte [page][x] holds column x of the 8-pixel band `page`, bit 0 at the top - exactly what the
+// controller takes in horizontal addressing mode, so a column range of one page goes out as is.
+// Text is the classic 5x7 font on a 6-pixel pitch, one text row per page (21 x 8 characters).
+// dirtyRANGE() compares two frames page by page; the display then only receives the columns
+// between the first and the last changed byte of each page.
+
+const uint8_t OLED_WIDTH        = 128;
+const uint8_t OLED_PAGES        = 8;
+const uint8_t OLED_CHAR_W       = 6;
+const uint8_t OLED_COLS         = OLED_WIDTH / OLED_CHAR_W;
+
+class OledFrameClass {
+public:
+    OledFrameClass();
+    void clear();
+    // text at pixel column x of a page; stops at the right edge, returns the x after the last char
+    uint8_t text(uint8_t x, uint8_t page, const char* s, bool invert = false);
+    void fillPAGE(uint8_t x, uint8_t page, uint8_t w, uint8_t pattern);
+    void bar(uint8_t x, uint8_t page, uint8_t w, uint8_t percent);      // outlined, filled to percent
+
+    const uint8_t* page(uint8_t p) const { return _buf[p]; }
+    uint8_t at(uint8_t x, uint8_t page) const { return _buf[page][x]; }
+    // false when the page is identical in both frames
+    static bool dirtyRANGE(const OledFrameClass& a, const OledFrameClass& b, uint8_t page, uint8_t* x0, uint8_t* x1);
+    void copyPAGE(const OledFrameClass& from, uint8_t page, uint8_t x0, uint8_t x1);
+private:
+    uint8_t _buf[OLED_PAGES][OLED_WIDTH];
+};
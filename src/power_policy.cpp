@@ -0,0 +1,88 @@
+// power_policy.cpp
+#include "power_policy.h"
+
+static constexpr POWER_TIER_PARAMS POWER_TIERS[POWER_TIER_COUNT] = {
+    // tx   conn_min conn_max lat  sup   adv_min adv_max batt_ms
+    {  9,   6,       12,      0,   400,  32,     48,     1500  },    // PLUGGED : 7.5-15 ms, 20-30 ms adv
+    {  3,   6,       24,      4,   400,  160,    240,    3000  },    // NORMAL  : 7.5-30 ms, 100-150 ms adv
+    {  0,   24,      40,      8,   400,  800,    1000,   10000 },    // LOW     : 30-50 ms, 0.5-0.6 s adv
+    { -6,   40,      80,      10,  600,  1600,   3200,   30000 },    // CRITICAL: 50-100 ms, 1-2 s adv
+};
+
+static const char* const POWER_TIER_NAMES[POWER_TIER_COUNT] = {
+    "PLUGGED", "NORMAL", "LOW", "CRITICAL"
+};
+
+PowerPolicyClass::PowerPolicyClass()
+    :   _tier(POWER_TIER_COUNT)
+{
+}
+
+const POWER_TIER_PARAMS& PowerPolicyClass::paramsFOR(uint8_t tier)
+{
+    return POWER_TIERS[tier < POWER_TIER_COUNT ? tier : POWER_TIER_NORMAL];
+}
+
+const char* PowerPolicyClass::tierNAME(uint8_t tier)
+{
+    return tier < POWER_TIER_COUNT ? POWER_TIER_NAMES[tier] : "?";
+}
+
+bool PowerPolicyClass::update(int percent, bool charging)
+{
+    uint8_t next = _tier;
+    if (charging)
+    {
+        next = POWER_TIER_PLUGGED;
+    }
+    else if (_tier == POWER_TIER_PLUGGED || _tier >= POWER_TIER_COUNT)
+    {
+        // no history on battery yet: plain thresholds
+        if (percent <= POWER_CRITICAL_ENTER_PCT)    next = POWER_TIER_CRITICAL;
+        else if (percent <= POWER_LOW_ENTER_PCT)    next = POWER_TIER_LOW;
+        else                                        next = POWER_TIER_NORMAL;
+    }
+    else if (_tier == POWER_TIER_NORMAL)
+    {
+        if (percent <= POWER_CRITICAL_ENTER_PCT)    next = POWER_TIER_CRITICAL;
+        else if (percent <= POWER_LOW_ENTER_PCT)    next = POWER_TIER_LOW;
+    }
+    else if (_tier == POWER_TIER_LOW)
+    {
+        if (percent <= POWER_CRITICAL_ENTER_PCT)    next = POWER_TIER_CRITICAL;
+        else if (percent >= POWER_LOW_EXIT_PCT)     next = POWER_TIER_NORMAL;
+    }
+    else    // CRITICAL
+    {
+        if (percent >= POWER_LOW_EXIT_PCT)          next = POWER_TIER_NORMAL;
+        else if (percent >= POWER_CRITICAL_EXIT_PCT) next = POWER_TIER_LOW;
+    }
+    if (next == _tier)
+    {
+        return false;
+    }
+    _tier = next;
+    return true;
+}
+
+float PowerPolicyClass::projectedDUTY(const POWER_TIER_PARAMS& p, float reports_per_sec, bool connected)
+{
+    if (!connected)
+    {
+        // the controller picks somewhere in [min, max] and adds advDelay
+        float adv_us = (p.adv_min + p.adv_max) * 0.5f * 625.0f + POWER_ADV_DELAY_US;
+        return POWER_ADV_EVENT_US / adv_us;
+    }
+    // centrals usually grant the top of the requested range
+    float interval_s = p.conn_max * 0.00125f;
+    float max_events = 1.0f / interval_s;
+    float data_events = reports_per_sec < max_events ? reports_per_sec : max_events;
+    // idle events are skipped up to conn_latency, data events cannot be
+    float idle_events = (max_events - data_events) / (1.0f + p.conn_latency);
+    return (data_events * POWER_CONN_EVENT_DATA_US + idle_events * POWER_CONN_EVENT_IDLE_US) / 1e6f;
+}
+
+float PowerPolicyClass::projectedLOAD_MA(const POWER_TIER_PARAMS& p, float reports_per_sec, bool connected)
+{
+    return POWER_SYSTEM_LOAD_MA + projectedDUTY(p, reports_per_sec, connected) * POWER_RADIO_ACTIVE_MA;
+}
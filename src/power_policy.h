@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+
+// Battery-aware power policy.
+//
+// The battery percentage and charging flag select one of four tiers; each tier carries the
+// radio and sampling settings the bridge applies (TX power, connection interval range and
+// peripheral latency, advertising interval, battery sampling interval). Leaving LOW or
+// CRITICAL needs a few percent more than entering it, so a cell that sags under load and
+// recovers at rest does not flip the radio back and forth.
+// Units follow the BLE spec: connection interval 1.25 ms, supervision timeout 10 ms,
+// advertising interval 0.625 ms.
+
+const uint8_t POWER_TIER_PLUGGED    = 0;
+const uint8_t POWER_TIER_NORMAL     = 1;
+const uint8_t POWER_TIER_LOW        = 2;
+const uint8_t POWER_TIER_CRITICAL   = 3;
+const uint8_t POWER_TIER_COUNT      = 4;
+
+const uint8_t POWER_LOW_ENTER_PCT       = 20;
+const uint8_t POWER_LOW_EXIT_PCT        = 28;
+const uint8_t POWER_CRITICAL_ENTER_PCT  = 8;
+const uint8_t POWER_CRITICAL_EXIT_PCT   = 16;
+
+// radio on-air estimates for projectedDUTY(), per event including ramp-up
+const uint16_t POWER_CONN_EVENT_IDLE_US = 400;      // empty PDU exchange
+const uint16_t POWER_CONN_EVENT_DATA_US = 600;      // one input report notification
+const uint16_t POWER_ADV_EVENT_US       = 1500;     // three channels, TX + RX window each
+const uint16_t POWER_ADV_DELAY_US       = 5000;     // mean advDelay added by the controller
+// load estimate for the SoC model: board + USB keyboard, plus the radio while it is on
+const uint16_t POWER_SYSTEM_LOAD_MA     = 60;
+const uint16_t POWER_RADIO_ACTIVE_MA    = 100;
+
+typedef struct POWER_TIER_PARAMS {
+    int8_t   tx_dbm;
+    uint16_t conn_min;          // 1.25 ms
+    uint16_t conn_max;          // 1.25 ms
+    uint16_t conn_latency;      // connection events the peripheral may skip when idle
+    uint16_t sup_timeout;       // 10 ms
+    uint16_t adv_min;           // 0.625 ms
+    uint16_t adv_max;           // 0.625 ms
+    uint16_t batt_interval_ms;
+} POWER_TIER_PARAMS;
+
+class PowerPolicyClass {
+public:
+    PowerPolicyClass();
+    bool update(int percent, bool charging);    // true when the tier changed
+    uint8_t tier() const { return _tier; }
+    const POWER_TIER_PARAMS& params() const { return paramsFOR(_tier); }
+
+    static const POWER_TIER_PARAMS& paramsFOR(uint8_t tier);
+    static const char* tierNAME(uint8_t tier);
+    // fraction of time the radio is on: connected at reports_per_sec, or advertising
+    static float projectedDUTY(const POWER_TIER_PARAMS& p, float reports_per_sec, bool connected);
+    static float projectedLOAD_MA(const POWER_TIER_PARAMS& p, float reports_per_sec, bool connected);
+private:
+    uint8_t _tier;              // POWER_TIER_COUNT until the first update
+};
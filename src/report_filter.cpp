@@ -0,0 +1,129 @@
+// report_filter.cpp
+#include "report_filter.h"
+#include <string.h>
+
+ReportFilterClass::ReportFilterClass()
+    :   _redundant_total(0)
+{
+    for (uint8_t i = 0; i < USB_MAX_DEVICES; i++)
+    {
+        _slots[i].dev.store(nullptr, std::memory_order_relaxed);
+        _slots[i].kind = REPORT_KIND_GENERIC;
+        _slots[i].len = 0;
+    }
+    resetSTATS();
+}
+
+uint8_t ReportFilterClass::attach(const void* dev, uint8_t kind, uint32_t now_ms)
+{
+    uint8_t free_slot = REPORT_NO_SLOT;
+    for (uint8_t i = 0; i < USB_MAX_DEVICES; i++)
+    {
+        const void* d = _slots[i].dev.load(std::memory_order_acquire);
+        if (d == dev) return i;
+        if (!d && free_slot == REPORT_NO_SLOT) free_slot = i;
+    }
+    if (free_slot == REPORT_NO_SLOT)
+    {
+        return REPORT_NO_SLOT;
+    }
+    SLOT& s = _slots[free_slot];
+    s.kind = kind;
+    s.len = 0;                      // the first report always passes
+    s.reports = 0;
+    s.redundant = 0;
+    s.window_start = now_ms;
+    s.window_reports = 0;
+    s.window_changed = 0;
+    s.reports_per_s = 0;
+    s.changed_per_s = 0;
+    s.dev.store(dev, std::memory_order_release);
+    return free_slot;
+}
+
+void ReportFilterClass::detach(const void* dev)
+{
+    uint8_t slot = find(dev);
+    if (slot != REPORT_NO_SLOT)
+    {
+        _slots[slot].dev.store(nullptr, std::memory_order_release);
+    }
+}
+
+uint8_t ReportFilterClass::find(const void* dev) const
+{
+    if (!dev)
+    {
+        return REPORT_NO_SLOT;
+    }
+    for (uint8_t i = 0; i < USB_MAX_DEVICES; i++)
+    {
+        if (_slots[i].dev.load(std::memory_order_acquire) == dev) return i;
+    }
+    return REPORT_NO_SLOT;
+}
+
+void ReportFilterClass::_closeWINDOW(SLOT& s, uint32_t now_ms)
+{
+    const uint32_t dt = now_ms - s.window_start;
+    s.reports_per_s = (uint16_t)((uint32_t)s.window_reports * 1000u / dt);
+    s.changed_per_s = (uint16_t)((uint32_t)s.window_changed * 1000u / dt);
+    s.window_reports = 0;
+    s.window_changed = 0;
+    s.window_start = now_ms;
+}
+
+bool ReportFilterClass::changed(uint8_t slot, const uint8_t* data, uint8_t len, uint32_t now_ms)
+{
+    if (slot >= USB_MAX_DEVICES)
+    {
+        return true;
+    }
+    SLOT& s = _slots[slot];
+    if (len > REPORT_MAX_BYTES) len = REPORT_MAX_BYTES;
+    if (now_ms - s.window_start >= REPORT_RATE_WINDOW_MS)
+    {
+        _closeWINDOW(s, now_ms);
+    }
+    s.reports++;
+    s.window_reports++;
+    if (len == s.len && memcmp(data, s.last, len) == 0)
+    {
+        s.redundant++;
+        _redundant_total++;
+        return false;
+    }
+    s.window_changed++;
+    memcpy(s.last, data, len);
+    s.len = len;
+    return true;
+}
+
+bool ReportFilterClass::stats(uint8_t slot, uint32_t now_ms, REPORT_DEV_STATS* out) const
+{
+    if (slot >= USB_MAX_DEVICES || !_slots[slot].dev.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+    const SLOT& s = _slots[slot];
+    const bool stale = now_ms - s.window_start >= 2u * REPORT_RATE_WINDOW_MS;
+    out->kind = s.kind;
+    out->reports = s.reports;
+    out->redundant = s.redundant;
+    out->reports_per_s = stale ? 0 : s.reports_per_s;
+    out->changed_per_s = stale ? 0 : s.changed_per_s;
+    return true;
+}
+
+void ReportFilterClass::resetSTATS()
+{
+    for (uint8_t i = 0; i < USB_MAX_DEVICES; i++)
+    {
+        _slots[i].reports = 0;
+        _slots[i].redundant = 0;
+        _slots[i].window_reports = 0;
+        _slots[i].window_changed = 0;
+        _slots[i].reports_per_s = 0;
+        _slots[i].changed_per_s = 0;
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+// Per-device front end of the USB report path: redundant-report suppression and rate counters.
+//
+// Gaming keyboards poll at 1 kHz and many send a report every frame whether anything changed or
+// not. Each attached interface gets a slot holding its last report; an input report that equals
+// it byte for byte is counted and dropped before any decoding, params query or diff, so the CPU
+// cost of an idle keyboard does not depend on its polling rate. A plain memcmp of at most
+// REPORT_MAX_BYTES is exact and cheaper than hashing the report first. The dispatch kind is
+// fixed when the interface opens, so the report path never asks the driver for its params.
+// Rates are counted over REPORT_RATE_WINDOW_MS windows; a device that stops reporting reads as
+// 0 once its window is two windows old. changed() runs on the USB driver task only; attach /
+// detach may run on another task, a slot is published by its device pointer.
+
+const uint8_t  USB_MAX_DEVICES          = 4;
+const uint8_t  REPORT_MAX_BYTES         = 64;
+const uint8_t  REPORT_NO_SLOT           = 0xFF;
+const uint16_t REPORT_RATE_WINDOW_MS    = 1000;
+
+const uint8_t  REPORT_KIND_KEYBOARD     = 0;    // boot keyboard
+const uint8_t  REPORT_KIND_MOUSE        = 1;    // boot mouse
+const uint8_t  REPORT_KIND_GENERIC      = 2;
+
+typedef struct REPORT_DEV_STATS {
+    uint8_t  kind;
+    uint32_t reports;                   // all input reports since attach / reset
+    uint32_t redundant;                 // dropped as equal to the previous one
+    uint16_t reports_per_s;             // last full window
+    uint16_t changed_per_s;
+} REPORT_DEV_STATS;
+
+class ReportFilterClass {
+public:
+    ReportFilterClass();
+    uint8_t attach(const void* dev, uint8_t kind, uint32_t now_ms);    // REPORT_NO_SLOT when full
+    void    detach(const void* dev);
+    uint8_t find(const void* dev) const;
+    uint8_t kind(uint8_t slot) const { return _slots[slot].kind; }
+    const void* device(uint8_t slot) const { return slot < USB_MAX_DEVICES ? _slots[slot].dev.load() : nullptr; }
+
+    // false for a repeat of the slot's last report; the caller returns at once
+    bool changed(uint8_t slot, const uint8_t* data, uint8_t len, uint32_t now_ms);
+
+    bool     stats(uint8_t slot, uint32_t now_ms, REPORT_DEV_STATS* out) const;
+    uint32_t redundantTOTAL() const { return _redundant_total; }  // all devices, never reset
+    void     resetSTATS();
+private:
+    typedef struct SLOT {
+        std::atomic<const void*> dev;
+        uint8_t  kind;
+        uint8_t  len;
+        uint8_t  last[REPORT_MAX_BYTES];
+        uint32_t reports;
+        uint32_t redundant;
+        uint32_t window_start;
+        uint16_t window_reports;
+        uint16_t window_changed;
+        uint16_t reports_per_s;
+        uint16_t changed_per_s;
+    } SLOT;
+    SLOT     _slots[USB_MAX_DEVICES];
+    uint32_t _redundant_total;
+
+    static void _closeWINDOW(SLOT& s, uint32_t now_ms);
+};
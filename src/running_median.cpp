@@ -0,0 +1,77 @@
+// running_median.cpp
+#include "running_median.h"
+#include <string.h>
+
+RunningMedianClass::RunningMedianClass()
+    :   _size(MEDIAN_MIN_SAMPLES),
+        _count(0),
+        _head(0)
+{
+    memset(_ring, 0, sizeof(_ring));
+    memset(_sorted, 0, sizeof(_sorted));
+}
+
+void RunningMedianClass::setSIZE(uint8_t n)
+{
+    if (n < MEDIAN_MIN_SAMPLES) n = MEDIAN_MIN_SAMPLES;
+    if (n > MEDIAN_MAX_SAMPLES) n = MEDIAN_MAX_SAMPLES;
+    _size = n;
+    reset();
+}
+
+void RunningMedianClass::reset()
+{
+    _count = 0;
+    _head = 0;
+}
+
+uint8_t RunningMedianClass::_lowerBOUND(uint16_t v) const
+{
+    uint8_t lo = 0;
+    uint8_t hi = _count;
+    while (lo < hi)
+    {
+        uint8_t mid = (uint8_t)((lo + hi) >> 1);
+        if (_sorted[mid] < v) lo = mid + 1;
+        else                  hi = mid;
+    }
+    return lo;
+}
+
+void RunningMedianClass::push(uint16_t sample)
+{
+    if (_count == _size)
+    {
+        // drop the oldest sample from both views; its slot in the ring takes the new one
+        uint8_t out = _lowerBOUND(_ring[_head]);
+        memmove(&_sorted[out], &_sorted[out + 1], (size_t)(_count - out - 1) * sizeof(uint16_t));
+        _count--;
+        _ring[_head] = sample;
+        _head = (uint8_t)((_head + 1) % _size);
+    }
+    else
+    {
+        _ring[(uint8_t)((_head + _count) % _size)] = sample;
+    }
+    uint8_t in = _lowerBOUND(sample);
+    memmove(&_sorted[in + 1], &_sorted[in], (size_t)(_count - in) * sizeof(uint16_t));
+    _sorted[in] = sample;
+    _count++;
+}
+
+float RunningMedianClass::median3() const
+{
+    if (_count == 0)
+    {
+        return 0.0f;
+    }
+    uint8_t mid = _count / 2;
+    uint8_t start = mid > 0 ? mid - 1 : 0;
+    uint8_t end = (mid + 1 < _count) ? mid + 1 : _count - 1;
+    long sum = 0;
+    for (uint8_t i = start; i <= end; i++)
+    {
+        sum += _sorted[i];
+    }
+    return (float)sum / (float)(end - start + 1);
+}
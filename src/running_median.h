@@ -0,0 +1,33 @@
+#pragma once
+#include <stdint.h>
+
+// Fixed-capacity sliding window with a running median, no heap use.
+//
+// Samples live twice: in a ring (arrival order, to know which one falls out) and in a sorted
+// array. push() finds the outgoing and incoming positions by binary search and shifts the
+// values in between, so a window of MEDIAN_MAX_SAMPLES 12-bit ADC readings costs at most a
+// 128-byte memmove per sample. median3() is the mean of the three middle samples, the value
+// the old sort-the-batch sampler returned for a full window.
+
+const uint8_t MEDIAN_MAX_SAMPLES = 64;
+const uint8_t MEDIAN_MIN_SAMPLES = 3;
+
+class RunningMedianClass {
+public:
+    RunningMedianClass();
+    void    setSIZE(uint8_t n);             // clamped to MEDIAN_MIN..MAX_SAMPLES, empties the window
+    void    reset();
+    void    push(uint16_t sample);
+    float   median3() const;                // 0 when empty
+    uint8_t size() const { return _size; }
+    uint8_t count() const { return _count; }
+    bool    full() const { return _count == _size; }
+private:
+    uint16_t _ring[MEDIAN_MAX_SAMPLES];
+    uint16_t _sorted[MEDIAN_MAX_SAMPLES];
+    uint8_t  _size;
+    uint8_t  _count;
+    uint8_t  _head;                         // oldest sample in _ring
+
+    uint8_t  _lowerBOUND(uint16_t v) const;
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+// Latest value of a small plain struct, published by one writer and read from any task or core.
+//
+// A latched seqlock: two copies of the value plus a sequence counter. The single writer bumps
+// the sequence (readers switch to copy 1), rewrites copy 0, bumps again (readers switch back to
+// copy 0) and rewrites copy 1. A reader picks the copy the sequence points at, copies it and
+// retries only if the sequence moved meanwhile. Readers never wait for a writer that is half-way
+// through, which matters when a higher-priority task preempts the writer on the same core; the
+// only retry is a publish completing mid-read, i.e. once per value at most. The copies are kept
+// as relaxed 32-bit atomic words, so copying them is free of data races without any lock.
+
+template <typename T>
+class SeqLatch {
+public:
+    SeqLatch()
+        :   _seq(0),
+            _retries(0)
+    {
+        for (uint8_t s = 0; s < 2; s++)
+        {
+            for (size_t i = 0; i < WORDS; i++)
+            {
+                _slot[s][i].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // writer side, one task only
+    void publish(const T& v)
+    {
+        uint32_t w[WORDS];
+        w[WORDS - 1] = 0;
+        memcpy(w, &v, sizeof(T));
+        // keep the sequence even between publishes so readers start on copy 0
+        const uint32_t seq = _seq.load(std::memory_order_relaxed);
+        for (uint8_t s = 0; s < 2; s++)
+        {
+            _seq.store(seq + 1 + s, s ? std::memory_order_release : std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (size_t i = 0; i < WORDS; i++)
+            {
+                _slot[s][i].store(w[i], std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // any task: false until the first publish()
+    bool read(T* out) const
+    {
+        uint32_t w[WORDS];
+        for (;;)
+        {
+            const uint32_t seq = _seq.load(std::memory_order_acquire);
+            if (seq < 2)
+            {
+                return false;
+            }
+            const std::atomic<uint32_t>* d = _slot[seq & 1u];
+            for (size_t i = 0; i < WORDS; i++)
+            {
+                w[i] = d[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);   // copy completes before the re-check
+            if (_seq.load(std::memory_order_relaxed) != seq)
+            {
+                _retries.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            memcpy(out, w, sizeof(T));
+            return true;
+        }
+    }
+
+    uint32_t retries() const { return _retries.load(std::memory_order_relaxed); }  // for diagnostics
+private:
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLatch holds plain structs only");
+    static const size_t WORDS = (sizeof(T) + 3) / 4;
+
+    std::atomic<uint32_t> _seq;                 // readers use _slot[_seq & 1]; < 2 = never published
+    std::atomic<uint32_t> _slot[2][WORDS];
+    mutable std::atomic<uint32_t> _retries;
+};
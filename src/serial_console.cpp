@@ -0,0 +1,371 @@
+// serial_console.cpp
+#include "serial_console.h"
+#include "task_CP.h"
+#include "idle_manager.h"
+#include <stdlib.h>
+#include <ctype.h>
+#include <string.h>
+
+static const CMD_VIEW CMD_VIEW_EMPTY = { "", 0 };
+
+CMD_VIEW CmdArgs::param(uint8_t i) const
+{
+    uint8_t k = _base + i;
+    return k < _argc ? _argv[k] : CMD_VIEW_EMPTY;
+}
+
+bool CmdArgs::is(uint8_t i, const char* word) const
+{
+    uint8_t k = _base + i;
+    if (k >= _argc)
+    {
+        return false;
+    }
+    const char* a = _argv[k].ptr;
+    while (*a && *word)
+    {
+        if (toupper((unsigned char)*a) != toupper((unsigned char)*word)) return false;
+        a++;
+        word++;
+    }
+    return *a == *word;
+}
+
+bool CmdArgs::toINT(uint8_t i, long* out) const
+{
+    CMD_VIEW v = param(i);
+    if (!v.len)
+    {
+        return false;
+    }
+    char* end;
+    long n = strtol(v.ptr, &end, 0);
+    if (*end)
+    {
+        return false;
+    }
+    *out = n;
+    return true;
+}
+
+bool CmdArgs::toFLOAT(uint8_t i, float* out) const
+{
+    CMD_VIEW v = param(i);
+    if (!v.len)
+    {
+        return false;
+    }
+    char* end;
+    float f = strtof(v.ptr, &end);
+    if (*end)
+    {
+        return false;
+    }
+    *out = f;
+    return true;
+}
+
+SerialConsoleClass::SerialConsoleClass()
+    :   _port(NULL),
+        _task_handle(NULL),
+        _table_count(0),
+        _len(0),
+        _overflow(false),
+        _raw(NULL),
+        _raw_paused(false),
+        _rx_wakes(false),
+        _carry_len(0),
+        _carry_pos(0)
+{
+    _line[0] = 0;
+}
+
+bool SerialConsoleClass::begin(Stream& port)
+{
+    _port = &port;
+    BaseType_t r = xTaskCreate(
+        _taskFunctionSTATIC,
+        "SERIAL_CONSOLE_TASK",
+        CONSOLE_TASK_STACK, this,
+        SERIAL_CONSOLE_TASK_PRIO,
+        &_task_handle
+    );
+    if (r != pdPASS)
+    {
+        Serial.println("CONSOLE::TASK::Creation failed");
+        return false;
+    }
+    return true;
+}
+
+bool SerialConsoleClass::addTABLE(const CONSOLE_CMD* cmds, uint8_t count, void* ctx, const char* title)
+{
+    if (_table_count >= CONSOLE_MAX_TABLES)
+    {
+        return false;
+    }
+    CONSOLE_TABLE& t = _tables[_table_count++];
+    t.cmds = cmds;
+    t.count = count;
+    t.ctx = ctx;
+    t.title = title;
+    return true;
+}
+
+void SerialConsoleClass::startRAW(const CONSOLE_RAW* raw)
+{
+    _raw_paused = false;
+    _raw = raw;
+}
+
+void SerialConsoleClass::wake()
+{
+    _rx_wakes = true;
+    if (_task_handle)
+    {
+        xTaskNotifyGive(_task_handle);
+    }
+}
+
+void SerialConsoleClass::_taskFunctionSTATIC(void* p)
+{
+    static_cast<SerialConsoleClass*>(p)->_taskFUNC();
+}
+
+void SerialConsoleClass::_taskFUNC()
+{
+    for (;;)
+    {
+        if (_raw)
+        {
+            _serviceRAW();
+            vTaskDelay(1);
+        }
+        else
+        {
+            _serviceLINE();
+            // received bytes wake us; the poll is a fallback, on the shared idle schedule
+            ulTaskNotifyTake(pdTRUE, idlemgr.alignedTICKS(_rx_wakes ? CONSOLE_IDLE_POLL_MS : CONSOLE_POLL_MS));
+        }
+    }
+}
+
+// bytes left over from raw mode come first; a read never mixes them with port bytes
+size_t SerialConsoleClass::_available()
+{
+    return (size_t)(_carry_len - _carry_pos) + (size_t)_port->available();
+}
+
+size_t SerialConsoleClass::_read(uint8_t* buf, size_t max)
+{
+    if (_carry_pos < _carry_len)
+    {
+        size_t n = min(max, (size_t)(_carry_len - _carry_pos));
+        memcpy(buf, _carry + _carry_pos, n);
+        _carry_pos += n;
+        return n;
+    }
+    return _port->readBytes(buf, min(max, (size_t)_port->available()));
+}
+
+void SerialConsoleClass::_serviceLINE()
+{
+    while (!_raw && _available())
+    {
+        uint8_t b;
+        if (!_read(&b, 1)) break;
+        char c = (char)b;
+        if (c == '\r')
+        {
+            continue;
+        }
+        if (c != '\n')
+        {
+            if (_len < CONSOLE_LINE_MAX - 1) _line[_len++] = c;
+            else                             _overflow = true;
+            continue;
+        }
+        _line[_len] = 0;
+        if (_overflow)
+        {
+            Serial.printf("CONSOLE:: line longer than %u chars ignored\n", CONSOLE_LINE_MAX - 1);
+        }
+        else
+        {
+            executeLINE(_line);
+        }
+        _len = 0;
+        _overflow = false;
+    }
+}
+
+// raw bytes go straight to the sink, with XON/XOFF back to the sender
+void SerialConsoleClass::_serviceRAW()
+{
+    const CONSOLE_RAW* raw = _raw;
+    size_t space = raw->space(raw->ctx);
+    if (!_raw_paused && space < CONSOLE_XOFF_SPACE)
+    {
+        _port->write(CONSOLE_XOFF);
+        _raw_paused = true;
+    }
+    else if (_raw_paused && space > CONSOLE_XON_SPACE)
+    {
+        _port->write(CONSOLE_XON);
+        _raw_paused = false;
+    }
+
+    uint8_t buf[sizeof(_carry)];
+    while (space && _available())
+    {
+        size_t n = _read(buf, min(space, sizeof(buf)));
+        for (size_t i = 0; i < n; i++)
+        {
+            if (buf[i] == CONSOLE_RAW_END)
+            {
+                raw->write(raw->ctx, buf, i);
+                // whatever followed Ctrl-D in this read is console input: keep it, ahead of any
+                // carry not read yet (it all came from the carry then, so it fits)
+                uint8_t rest[sizeof(_carry)];
+                size_t r = n - i - 1;
+                memcpy(rest, buf + i + 1, r);
+                memcpy(rest + r, _carry + _carry_pos, _carry_len - _carry_pos);
+                r += _carry_len - _carry_pos;
+                memcpy(_carry, rest, r);
+                _carry_len = (uint8_t)r;
+                _carry_pos = 0;
+                if (_raw_paused) _port->write(CONSOLE_XON);
+                _raw_paused = false;
+                _raw = NULL;
+                raw->end(raw->ctx);
+                return;
+            }
+        }
+        space -= raw->write(raw->ctx, buf, n);
+    }
+}
+
+bool SerialConsoleClass::_equalsNOCASE(const char* a, const char* b)
+{
+    while (*a && *b)
+    {
+        if (toupper((unsigned char)*a) != toupper((unsigned char)*b)) return false;
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+void SerialConsoleClass::executeLINE(char* line)
+{
+    CmdArgs args;
+    args._argc = 0;
+    args._base = 0;
+    args._console = this;
+
+    char* p = line;
+    for (;;)
+    {
+        while (*p == ' ' || *p == '\t') p++;
+        if (!*p) break;
+        if (args._argc >= CONSOLE_MAX_ARGS)
+        {
+            Serial.printf("CONSOLE:: more than %u words\n", CONSOLE_MAX_ARGS);
+            return;
+        }
+        char* start = p;
+        while (*p && *p != ' ' && *p != '\t') p++;
+        args._argv[args._argc].ptr = start;
+        args._argv[args._argc].len = (uint8_t)(p - start);
+        args._argc++;
+        if (*p) *p++ = 0;
+    }
+    if (!args._argc)
+    {
+        return;
+    }
+
+    const char* verb = args._argv[0].ptr;
+    if (_equalsNOCASE(verb, "HELP"))
+    {
+        printHELP();
+        return;
+    }
+
+    // a matching sub-word wins over the bare verb
+    const CONSOLE_CMD* hit = NULL;
+    const CONSOLE_CMD* bare = NULL;
+    void* hit_ctx = NULL;
+    void* bare_ctx = NULL;
+    bool verb_known = false;
+    for (uint8_t t = 0; t < _table_count && !hit; t++)
+    {
+        for (uint8_t c = 0; c < _tables[t].count; c++)
+        {
+            const CONSOLE_CMD& cmd = _tables[t].cmds[c];
+            if (!_equalsNOCASE(verb, cmd.verb)) continue;
+            verb_known = true;
+            if (cmd.sub)
+            {
+                if (args._argc > 1 && _equalsNOCASE(args._argv[1].ptr, cmd.sub))
+                {
+                    hit = &cmd;
+                    hit_ctx = _tables[t].ctx;
+                    break;
+                }
+            }
+            else if (!bare)
+            {
+                bare = &cmd;
+                bare_ctx = _tables[t].ctx;
+            }
+        }
+    }
+    if (!hit)
+    {
+        hit = bare;
+        hit_ctx = bare_ctx;
+    }
+    if (!hit)
+    {
+        if (verb_known) _printUSAGE(verb);
+        else            Serial.println("UNKNOWN -- COMMAND use:HELP");
+        return;
+    }
+    args._base = hit->sub ? 2 : 1;
+    if (args.count() < hit->params)
+    {
+        _printUSAGE(verb);
+        return;
+    }
+    hit->fn(hit_ctx, args);
+}
+
+void SerialConsoleClass::_printUSAGE(const char* verb)
+{
+    for (uint8_t t = 0; t < _table_count; t++)
+    {
+        for (uint8_t c = 0; c < _tables[t].count; c++)
+        {
+            const CONSOLE_CMD& cmd = _tables[t].cmds[c];
+            if (!_equalsNOCASE(verb, cmd.verb)) continue;
+            Serial.printf("usage: %s %s %s\n", cmd.verb, cmd.sub ? cmd.sub : "", cmd.help);
+        }
+    }
+}
+
+void SerialConsoleClass::printHELP()
+{
+    Serial.println(F("HELP                    - show all commands"));
+    for (uint8_t t = 0; t < _table_count; t++)
+    {
+        Serial.printf("%s COMMANDS:\n", _tables[t].title);
+        for (uint8_t c = 0; c < _tables[t].count; c++)
+        {
+            const CONSOLE_CMD& cmd = _tables[t].cmds[c];
+            char head[24];
+            snprintf(head, sizeof(head), "%s%s%s", cmd.verb, cmd.sub ? " " : "", cmd.sub ? cmd.sub : "");
+            Serial.printf("%-23s %s\n", head, cmd.help);
+        }
+    }
+}
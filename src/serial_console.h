@@ -0,0 +1,112 @@
+#pragma once
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Shared serial console.
+//
+// One task owns the serial port. Lines are collected in a fixed buffer and split in place
+// (separators become NUL), so every argument is a view into that buffer and no command
+// allocates. Subsystems describe their commands in constexpr CONSOLE_CMD tables and register
+// them once; dispatch matches the verb, then an optional sub-word ("SET RTOP"), and checks the
+// argument count before the handler runs. HELP is generated from the tables.
+// A handler may switch the console to raw mode (bulk text): bytes then go to a CONSOLE_RAW
+// sink with XON/XOFF flow control until the end character arrives.
+
+const uint8_t  CONSOLE_LINE_MAX     = 128;
+const uint8_t  CONSOLE_MAX_ARGS     = 8;
+const uint8_t  CONSOLE_MAX_TABLES   = 12;
+const uint16_t CONSOLE_POLL_MS      = 20;
+const uint16_t CONSOLE_IDLE_POLL_MS = 1000;     // once wake() is fed by a receive callback
+const uint16_t CONSOLE_TASK_STACK   = 4096;
+
+const uint8_t  CONSOLE_RAW_END      = 0x04;     // Ctrl-D leaves raw mode
+const uint8_t  CONSOLE_XON          = 0x11;
+const uint8_t  CONSOLE_XOFF         = 0x13;
+const size_t   CONSOLE_XOFF_SPACE   = 512;      // ask the sender to pause below this much free space
+const size_t   CONSOLE_XON_SPACE    = 1536;     // and to resume above this
+
+class SerialConsoleClass;
+
+typedef struct CMD_VIEW {
+    const char* ptr;                // NUL-terminated inside the line buffer
+    uint8_t     len;
+} CMD_VIEW;
+
+class CmdArgs {
+public:
+    uint8_t count() const { return _argc - _base; }       // parameters after verb (+ sub-word)
+    CMD_VIEW param(uint8_t i) const;
+    const char* str(uint8_t i) const { return param(i).ptr; }
+    bool is(uint8_t i, const char* word) const;
+    bool toINT(uint8_t i, long* out) const;
+    bool toFLOAT(uint8_t i, float* out) const;
+    SerialConsoleClass& console() const { return *_console; }
+private:
+    friend class SerialConsoleClass;
+    CMD_VIEW _argv[CONSOLE_MAX_ARGS];
+    uint8_t  _argc;
+    uint8_t  _base;
+    SerialConsoleClass* _console;
+};
+
+typedef void (*CMD_HANDLER)(void* ctx, const CmdArgs& args);
+
+typedef struct CONSOLE_CMD {
+    const char* verb;
+    const char* sub;                // nullptr: the verb alone
+    uint8_t     params;             // minimum parameter count
+    CMD_HANDLER fn;
+    const char* help;               // "<args>  - what it does"
+} CONSOLE_CMD;
+
+typedef struct CONSOLE_RAW {
+    size_t (*write)(void* ctx, const uint8_t* data, size_t len);    // returns bytes taken
+    size_t (*space)(void* ctx);
+    void   (*end)(void* ctx);
+    void*  ctx;
+} CONSOLE_RAW;
+
+class SerialConsoleClass {
+public:
+    SerialConsoleClass();
+    bool begin(Stream& port);       // starts the console task
+    bool addTABLE(const CONSOLE_CMD* cmds, uint8_t count, void* ctx, const char* title);
+    template <uint8_t N>
+    bool addTABLE(const CONSOLE_CMD (&cmds)[N], void* ctx, const char* title) { return addTABLE(cmds, N, ctx, title); }
+
+    void wake();                                // from the port's receive callback; allows slow polling
+    void startRAW(const CONSOLE_RAW* raw);      // from a handler; takes effect after the current line
+    void executeLINE(char* line);               // tokenises in place
+    void printHELP();
+private:
+    typedef struct CONSOLE_TABLE {
+        const CONSOLE_CMD* cmds;
+        uint8_t            count;
+        void*              ctx;
+        const char*        title;
+    } CONSOLE_TABLE;
+
+    Stream*       _port;
+    TaskHandle_t  _task_handle;
+    CONSOLE_TABLE _tables[CONSOLE_MAX_TABLES];
+    uint8_t       _table_count;
+    char          _line[CONSOLE_LINE_MAX];
+    uint8_t       _len;
+    bool          _overflow;
+    const CONSOLE_RAW* volatile _raw;
+    bool          _raw_paused;
+    volatile bool _rx_wakes;
+    uint8_t       _carry[64];                   // read past the end of raw mode, for the line parser
+    uint8_t       _carry_len;
+    uint8_t       _carry_pos;
+
+    static void _taskFunctionSTATIC(void* p);
+    void _taskFUNC();
+    void _serviceLINE();
+    void _serviceRAW();
+    size_t _available();
+    size_t _read(uint8_t* buf, size_t max);
+    void _printUSAGE(const char* verb);
+    static bool _equalsNOCASE(const char* a, const char* b);
+};
@@ -0,0 +1,150 @@
+// soc_estimator.cpp
+#include "soc_estimator.h"
+#include <math.h>
+
+#define SOC_DEFAULT_CAPACITY_MAH    1000
+#define SOC_DEFAULT_CHARGE_MA       300
+#define SOC_VOLT_SIGMA_MV           15.0f       // ADC + divider noise after the median
+#define SOC_CHARGE_SIGMA_MV         60.0f       // charger ripple / CV phase
+#define SOC_LOAD_UNCERTAINTY        0.3f        // relative error of the load estimate
+#define SOC_Q_FLOOR                 0.01f       // permille^2 per update
+#define SOC_P_INITIAL               (100.0f * 100.0f)
+
+static constexpr SOC_PROFILE SOC_PROFILES[SOC_CHEM_COUNT] = {
+    { "LIPO", 150, 80,
+      { 3270, 3610, 3690, 3710, 3730, 3750, 3770, 3790, 3800, 3820, 3840,
+        3850, 3870, 3910, 3950, 3980, 4020, 4080, 4110, 4150, 4200 } },
+    { "LIFEPO4", 80, 60,
+      { 2500, 3000, 3200, 3220, 3250, 3260, 3270, 3280, 3290, 3295, 3300,
+        3305, 3310, 3315, 3320, 3325, 3330, 3335, 3350, 3380, 3450 } },
+};
+
+SocEstimatorClass::SocEstimatorClass()
+    :   _chem(SOC_CHEM_LIPO),
+        _capacity_mah(SOC_DEFAULT_CAPACITY_MAH),
+        _charge_ma(SOC_DEFAULT_CHARGE_MA),
+        _x(0.0f),
+        _p(SOC_P_INITIAL),
+        _valid(false)
+{
+}
+
+const SOC_PROFILE& SocEstimatorClass::profile(uint8_t chem)
+{
+    return SOC_PROFILES[chem < SOC_CHEM_COUNT ? chem : SOC_CHEM_LIPO];
+}
+
+void SocEstimatorClass::setPROFILE(uint8_t chem)
+{
+    if (chem >= SOC_CHEM_COUNT)
+    {
+        return;
+    }
+    _chem = chem;
+    _valid = false;     // the old estimate was read off another curve
+}
+
+uint16_t SocEstimatorClass::ocvFROM_SOC(const SOC_PROFILE& p, uint16_t permille)
+{
+    if (permille >= 1000)
+    {
+        return p.ocv_mv[SOC_CURVE_POINTS - 1];
+    }
+    uint8_t i = permille / SOC_CURVE_STEP;
+    uint16_t frac = permille % SOC_CURVE_STEP;
+    return p.ocv_mv[i] + (uint16_t)(((uint32_t)(p.ocv_mv[i + 1] - p.ocv_mv[i]) * frac) / SOC_CURVE_STEP);
+}
+
+uint16_t SocEstimatorClass::socFROM_OCV(const SOC_PROFILE& p, uint16_t mv, uint16_t* slope_mv_per_step)
+{
+    // segment i such that ocv[i] <= mv < ocv[i + 1]
+    uint8_t lo = 0;
+    uint8_t hi = SOC_CURVE_POINTS - 1;
+    if (mv <= p.ocv_mv[0])
+    {
+        hi = 1;
+        mv = p.ocv_mv[0];
+    }
+    else if (mv >= p.ocv_mv[SOC_CURVE_POINTS - 1])
+    {
+        lo = SOC_CURVE_POINTS - 2;
+        mv = p.ocv_mv[SOC_CURVE_POINTS - 1];
+    }
+    else
+    {
+        while (hi - lo > 1)
+        {
+            uint8_t mid = (lo + hi) >> 1;
+            if (p.ocv_mv[mid] <= mv) lo = mid;
+            else                     hi = mid;
+        }
+    }
+    hi = lo + 1;
+    const uint16_t span = p.ocv_mv[hi] - p.ocv_mv[lo];
+    if (slope_mv_per_step)
+    {
+        *slope_mv_per_step = span;
+    }
+    return lo * SOC_CURVE_STEP + (uint16_t)(((uint32_t)(mv - p.ocv_mv[lo]) * SOC_CURVE_STEP + span / 2) / span);
+}
+
+void SocEstimatorClass::reset(uint16_t mv, float load_ma)
+{
+    const SOC_PROFILE& p = profile(_chem);
+    float ocv = mv + load_ma * p.r_internal_mohm / 1000.0f;
+    _x = socFROM_OCV(p, (uint16_t)ocv);
+    _p = SOC_P_INITIAL;
+    _valid = true;
+}
+
+void SocEstimatorClass::update(uint16_t mv, bool charging, float load_ma, uint32_t dt_ms)
+{
+    if (!_valid)
+    {
+        reset(mv, charging ? 0.0f : load_ma);
+        return;
+    }
+    const SOC_PROFILE& p = profile(_chem);
+
+    // predict: coulomb count, mAh -> permille of capacity
+    const float current_ma = charging ? (float)_charge_ma : load_ma;
+    const float delta = current_ma * (dt_ms / 3600000.0f) * 1000.0f / _capacity_mah;
+    _x += charging ? delta : -delta;
+    _p += (SOC_LOAD_UNCERTAINTY * delta) * (SOC_LOAD_UNCERTAINTY * delta) + SOC_Q_FLOOR;
+
+    // measure: terminal voltage back to OCV for the current direction
+    float ocv;
+    float sigma_mv;
+    if (charging)
+    {
+        ocv = mv - _charge_ma * p.r_internal_mohm / 1000.0f - p.charge_offset_mv;
+        sigma_mv = SOC_CHARGE_SIGMA_MV;
+    }
+    else
+    {
+        ocv = mv + load_ma * p.r_internal_mohm / 1000.0f;
+        sigma_mv = SOC_VOLT_SIGMA_MV + SOC_LOAD_UNCERTAINTY * load_ma * p.r_internal_mohm / 1000.0f;
+    }
+    if (ocv < 0.0f) ocv = 0.0f;
+    uint16_t slope = 0;
+    const float z = socFROM_OCV(p, (uint16_t)ocv, &slope);
+    // mV error -> permille error through the local curve slope
+    const float sigma_soc = sigma_mv * SOC_CURVE_STEP / (slope ? slope : 1);
+    const float r = sigma_soc * sigma_soc;
+    const float k = _p / (_p + r);
+    _x += k * (z - _x);
+    _p *= (1.0f - k);
+
+    if (_x < 0.0f)    _x = 0.0f;
+    if (_x > 1000.0f) _x = 1000.0f;
+}
+
+uint16_t SocEstimatorClass::permille() const
+{
+    return _valid ? (uint16_t)(_x + 0.5f) : 0;
+}
+
+float SocEstimatorClass::stddevPERMILLE() const
+{
+    return sqrtf(_p);
+}
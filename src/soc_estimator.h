@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+
+// State-of-charge estimator: coulomb counting corrected by the open-circuit voltage.
+//
+// A one-state Kalman filter in permille. The prediction integrates the estimated load (or the
+// charge current) over the capacity; the measurement is the terminal voltage corrected by
+// I*R for the current direction and mapped through the chemistry's OCV curve. The measurement
+// noise is scaled by the local slope of that curve, so on a flat plateau (LiFePO4) the
+// estimate follows the coulomb count and on steep parts the voltage pulls it back.
+// Curves are fixed-point mV at 5% steps: SoC -> OCV by direct index, OCV -> SoC by binary
+// search and integer interpolation.
+
+const uint8_t  SOC_CURVE_POINTS     = 21;       // 0, 5, ... 100 %
+const uint16_t SOC_CURVE_STEP       = 50;       // permille between points
+
+const uint8_t  SOC_CHEM_LIPO        = 0;
+const uint8_t  SOC_CHEM_LIFEPO4     = 1;
+const uint8_t  SOC_CHEM_COUNT       = 2;
+
+typedef struct SOC_PROFILE {
+    const char* name;
+    uint16_t    r_internal_mohm;
+    uint16_t    charge_offset_mv;               // polarisation above OCV while charging
+    uint16_t    ocv_mv[SOC_CURVE_POINTS];       // strictly increasing
+} SOC_PROFILE;
+
+class SocEstimatorClass {
+public:
+    SocEstimatorClass();
+    void setPROFILE(uint8_t chem);
+    void setCAPACITY(uint16_t mah) { _capacity_mah = mah ? mah : 1; }
+    void setChargeMA(uint16_t ma) { _charge_ma = ma; }
+    uint8_t  chemistry() const { return _chem; }
+    uint16_t capacity() const { return _capacity_mah; }
+
+    void reset(uint16_t mv, float load_ma);     // start from the voltage alone
+    void update(uint16_t mv, bool charging, float load_ma, uint32_t dt_ms);
+    uint16_t permille() const;
+    uint8_t  percent() const { return (uint8_t)((permille() + 5) / 10); }
+    float    stddevPERMILLE() const;
+
+    static const SOC_PROFILE& profile(uint8_t chem);
+    static uint16_t ocvFROM_SOC(const SOC_PROFILE& p, uint16_t permille);
+    static uint16_t socFROM_OCV(const SOC_PROFILE& p, uint16_t mv, uint16_t* slope_mv_per_step = 0);
+private:
+    uint8_t  _chem;
+    uint16_t _capacity_mah;
+    uint16_t _charge_ma;
+    float    _x;            // permille
+    float    _p;            // variance, permille^2
+    bool     _valid;
+};
@@ -6,6 +6,11 @@ const uint8_t USB_EVENTS_WRAPPER_PRIO  =2;
 const uint8_t HID_HOST_DRIVER_TASK_PRIO =8;
 const uint8_t HID_WORKER_PRIO =2;
 const uint8_t BATTERY_MONITOR_TASK_PRIO = 2;
+const uint8_t ADC_SCHEDULER_TASK_PRIO = 2;
+const uint8_t SERIAL_CONSOLE_TASK_PRIO = 1;
+const uint8_t TELEMETRY_TASK_PRIO = 1;
+const uint8_t DEFERRED_LOG_TASK_PRIO = 1;
+const uint8_t DASHBOARD_TASK_PRIO = 1;
 
 
 
@@ -17,4 +22,5 @@ const uint8_t BATTERY_MONITOR_TASK_PRIO = 2;
 const uint8_t BLE_Task_WRAPPER_Core = 0;
 const uint8_t USB_EVENTS_WRAPPER_Core = 0;
 const uint8_t HID_HOST_DRIVER_TASK_Core =0;
+const uint8_t DASHBOARD_TASK_Core = 1;       // away from the USB / BLE tasks on core 0
 
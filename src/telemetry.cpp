@@ -0,0 +1,164 @@
+// telemetry.cpp
+#include "telemetry.h"
+#include "serial_console.h"
+#include "task_CP.h"
+#include "idle_manager.h"
+
+TelemetryClass telemetry;
+
+TelemetryClass::TelemetryClass()
+    :   _dropped_reported(0),
+        _streaming(false),
+        _sampler_count(0),
+        _port(nullptr),
+        _task_handle(NULL),
+        _have_pending(false)
+{
+}
+
+bool TelemetryClass::begin(Stream& port)
+{
+    _port = &port;
+    BaseType_t r = xTaskCreate(
+        _taskFunctionSTATIC,
+        "TELEMETRY_TASK",
+        TELEM_TASK_STACK, this,
+        TELEMETRY_TASK_PRIO,
+        &_task_handle
+    );
+    if (r != pdPASS)
+    {
+        Serial.println("TELEMETRY::TASK::Creation failed");
+        return false;
+    }
+    return true;
+}
+
+bool TelemetryClass::addSAMPLER(TELEM_SAMPLER fn, void* ctx)
+{
+    if (_sampler_count >= TELEM_MAX_SAMPLERS)
+    {
+        return false;
+    }
+    _samplers[_sampler_count].fn = fn;
+    _samplers[_sampler_count].ctx = ctx;
+    _sampler_count++;
+    return true;
+}
+
+bool TelemetryClass::emit(uint8_t type, uint8_t arg, uint32_t a, uint32_t b)
+{
+    return emitAT(type, arg, a, b, millis());
+}
+
+// the record carries its ring position, so the host sees gaps where frames were lost on the wire
+bool TelemetryClass::emitAT(uint8_t type, uint8_t arg, uint32_t a, uint32_t b, uint32_t time_ms)
+{
+    return _ring.emplace([=](TELEM_RECORD& r, uint32_t pos)
+    {
+        r.type = type;
+        r.arg = arg;
+        r.seq = (uint16_t)pos;
+        r.time_ms = time_ms;
+        r.a = a;
+        r.b = b;
+    });
+}
+
+void TelemetryClass::_frame(const TELEM_RECORD& r)
+{
+    uint8_t raw[TELEM_RECORD_SIZE + 1];
+    memcpy(raw, &r, TELEM_RECORD_SIZE);
+    raw[TELEM_RECORD_SIZE] = telemCRC8(raw, TELEM_RECORD_SIZE);
+    _pending[0] = 0;
+    telemCOBS_ENCODE(raw, sizeof(raw), _pending + 1);
+    _pending[TELEM_FRAME_SIZE - 1] = 0;
+    _have_pending = true;
+}
+
+// whole frames only, so console text never lands inside one
+bool TelemetryClass::_flushPENDING()
+{
+    if (!_have_pending)
+    {
+        return true;
+    }
+    if (_port->availableForWrite() < (int)TELEM_FRAME_SIZE)
+    {
+        return false;
+    }
+    _port->write(_pending, TELEM_FRAME_SIZE);
+    _have_pending = false;
+    return true;
+}
+
+void TelemetryClass::_taskFunctionSTATIC(void* p)
+{
+    static_cast<TelemetryClass*>(p)->_taskFUNC();
+}
+
+void TelemetryClass::_taskFUNC()
+{
+    uint32_t last_sample = millis();
+    for (;;)
+    {
+        // records are only discarded while not streaming; the samplers set the pace then
+        idlemgr.sleepALIGNED(_streaming ? TELEM_DRAIN_MS : TELEM_SAMPLE_MS);
+
+        uint32_t now = millis();
+        if (now - last_sample >= TELEM_SAMPLE_MS)
+        {
+            last_sample = now;
+            for (uint8_t i = 0; i < _sampler_count; i++)
+            {
+                _samplers[i].fn(_samplers[i].ctx);
+            }
+            uint32_t d = dropped();
+            if (d != _dropped_reported)
+            {
+                emitAT(TELEM_COUNTER, TELEM_C_DROPPED, d, d - _dropped_reported, now);
+                _dropped_reported = d;
+            }
+        }
+
+        if (!_streaming)
+        {
+            TELEM_RECORD r;
+            while (_ring.pop(&r)) {}
+            _have_pending = false;
+            continue;
+        }
+        while (_flushPENDING())
+        {
+            TELEM_RECORD r;
+            if (!_ring.pop(&r))
+            {
+                break;
+            }
+            _frame(r);
+        }
+    }
+}
+
+// ----------------- console commands -----------------
+static void cmd_TELEMETRY(void* ctx, const CmdArgs& args)
+{
+    TelemetryClass* t = static_cast<TelemetryClass*>(ctx);
+    if (args.count() == 0)
+    {
+        Serial.printf("TELEMETRY:: streaming %s, %u records dropped\n", t->streaming() ? "on" : "off", t->dropped());
+        return;
+    }
+    if (args.is(0, "ON"))       t->setSTREAMING(true);
+    else if (args.is(0, "OFF")) t->setSTREAMING(false);
+    else Serial.println("TELEMETRY:: ON or OFF expected");
+}
+
+static constexpr CONSOLE_CMD TELEMETRY_COMMANDS[] = {
+    {"TELEMETRY", nullptr, 0, cmd_TELEMETRY, "[ON|OFF]  - binary telemetry frames on this port (tools/telem_decode)"},
+};
+
+void TelemetryClass::registerCOMMANDS(SerialConsoleClass& console)
+{
+    console.addTABLE(TELEMETRY_COMMANDS, this, "TELEMETRY");
+}
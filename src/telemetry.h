@@ -0,0 +1,61 @@
+#pragma once
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "telemetry_format.h"
+#include "mpmc_ring.h"
+
+// Binary telemetry: producers on any task or core drop fixed-size records into a lock-free
+// ring; one low-priority task drains it to the serial port as COBS frames (telemetry_format.h).
+//
+// The ring is an MpmcRing (mpmc_ring.h): a producer claims a slot with one compare-and-swap,
+// writes the 16-byte record in place and releases it; a full ring drops the new record and
+// counts it, so producers never wait. The drain task writes only what fits in the port's
+// transmit buffer, so it never blocks on the UART either, and reports the drop counter and any
+// registered samplers once a second. Streaming is off by default; records are then consumed
+// and discarded.
+
+const uint16_t TELEM_RING_SIZE          = 128;      // records, power of two
+const uint16_t TELEM_DRAIN_MS           = 50;
+const uint16_t TELEM_SAMPLE_MS          = 1000;
+const uint16_t TELEM_TASK_STACK         = 2048;
+const uint8_t  TELEM_MAX_SAMPLERS       = 4;
+
+typedef void (*TELEM_SAMPLER)(void* ctx);            // runs on the drain task, emits records
+
+class SerialConsoleClass;
+
+class TelemetryClass {
+public:
+    TelemetryClass();
+    bool begin(Stream& port);                        // starts the drain task
+    void setSTREAMING(bool on) { _streaming = on; }
+    bool streaming() const { return _streaming; }
+    bool addSAMPLER(TELEM_SAMPLER fn, void* ctx);
+
+    // producer side: any task, any core; false if the ring was full
+    bool emit(uint8_t type, uint8_t arg, uint32_t a, uint32_t b);
+    bool emitAT(uint8_t type, uint8_t arg, uint32_t a, uint32_t b, uint32_t time_ms);
+
+    uint32_t dropped() const { return _ring.dropped(); }
+    void registerCOMMANDS(SerialConsoleClass& console);
+private:
+    MpmcRing<TELEM_RECORD, TELEM_RING_SIZE> _ring;
+    uint32_t              _dropped_reported;
+    volatile bool         _streaming;
+
+    struct { TELEM_SAMPLER fn; void* ctx; } _samplers[TELEM_MAX_SAMPLERS];
+    uint8_t               _sampler_count;
+
+    Stream*      _port;
+    TaskHandle_t _task_handle;
+    uint8_t      _pending[TELEM_FRAME_SIZE];         // frame that did not fit the TX buffer yet
+    bool         _have_pending;
+
+    static void _taskFunctionSTATIC(void* p);
+    void _taskFUNC();
+    bool _flushPENDING();
+    void _frame(const TELEM_RECORD& r);
+};
+
+extern TelemetryClass telemetry;
@@ -0,0 +1,101 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Wire format of the binary telemetry stream, shared by the firmware and tools/telem_decode.cpp.
+//
+// Every record is TELEM_RECORD_SIZE bytes followed by a CRC-8, COBS-encoded and framed by a
+// 0x00 on both sides: 0x00 | 18 COBS bytes | 0x00. The leading delimiter means console text that
+// shares the port ends up in its own chunk, which a decoder recognises by its length and CRC and
+// passes through as text. Multi-byte fields are little-endian (the ESP32 byte order).
+
+const uint8_t TELEM_BATTERY     = 1;    // a: battery mV,   b: EMA mV,   arg: percent | charging << 7
+const uint8_t TELEM_LATENCY     = 2;    // a: USB report -> BLE send, ms, b: usage,  arg: pressed
+const uint8_t TELEM_QUEUE       = 3;    // a: depth,        b: capacity, arg: TELEM_Q_*
+const uint8_t TELEM_COUNTER     = 4;    // a: total,        b: delta since the last record, arg: TELEM_C_*
+
+const uint8_t TELEM_Q_KEYS      = 0;    // KBQueue (key events waiting for the BLE task)
+const uint8_t TELEM_Q_HID       = 1;    // USB host driver events
+const uint8_t TELEM_Q_BULK      = 2;    // bulk-text stream buffer, bytes
+
+const uint8_t TELEM_C_DROPPED   = 0;    // telemetry records lost to a full ring
+const uint8_t TELEM_C_KEY_DROPS = 1;    // key events lost to a full KBQueue
+const uint8_t TELEM_C_DEBOUNCE  = 2;    // edges suppressed by the debouncer
+const uint8_t TELEM_C_REDUNDANT = 3;    // USB input reports dropped as repeats of the last one
+const uint8_t TELEM_C_USB_FAULTS = 4;   // USB transfer errors and failed driver calls
+
+typedef struct __attribute__((packed)) TELEM_RECORD {
+    uint8_t  type;                      // TELEM_*
+    uint8_t  arg;
+    uint16_t seq;                       // ring position, gaps show frames lost on the wire
+    uint32_t time_ms;
+    uint32_t a;
+    uint32_t b;
+} TELEM_RECORD;
+
+const size_t TELEM_RECORD_SIZE  = sizeof(TELEM_RECORD);                 // 16
+const size_t TELEM_COBS_SIZE    = TELEM_RECORD_SIZE + 1 + 1;            // record + CRC, + COBS overhead
+const size_t TELEM_FRAME_SIZE   = TELEM_COBS_SIZE + 2;                  // with both delimiters
+
+// CRC-8, polynomial 0x07
+static inline uint8_t telemCRC8(const uint8_t* p, size_t n)
+{
+    uint8_t crc = 0;
+    while (n--)
+    {
+        crc ^= *p++;
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// COBS for blocks shorter than 254 bytes; out needs n + 1 bytes, returns n + 1
+static inline size_t telemCOBS_ENCODE(const uint8_t* in, size_t n, uint8_t* out)
+{
+    size_t code_at = 0;
+    size_t o = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (in[i] == 0)
+        {
+            out[code_at] = code;
+            code_at = o++;
+            code = 1;
+        }
+        else
+        {
+            out[o++] = in[i];
+            code++;
+        }
+    }
+    out[code_at] = code;
+    return o;
+}
+
+// returns the decoded length, 0 on a malformed block; out needs n - 1 bytes
+static inline size_t telemCOBS_DECODE(const uint8_t* in, size_t n, uint8_t* out)
+{
+    size_t i = 0;
+    size_t o = 0;
+    while (i < n)
+    {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > n)
+        {
+            return 0;
+        }
+        for (uint8_t k = 1; k < code; k++)
+        {
+            out[o++] = in[i++];
+        }
+        if (i < n)
+        {
+            out[o++] = 0;
+        }
+    }
+    return o;
+}
@@ -0,0 +1,123 @@
+// timer_wheel.cpp
+#include "timer_wheel.h"
+
+TimerWheelClass::TimerWheelClass()
+    :   _cursor(0),
+        _active(0)
+{
+    reset(0);
+}
+
+void TimerWheelClass::reset(uint32_t now_ms)
+{
+    for (uint8_t i = 0; i < WHEEL_MAX_TIMERS; i++)
+    {
+        _timers[i].used = false;
+        _timers[i].next = -1;
+    }
+    for (uint8_t i = 0; i < WHEEL_SLOTS; i++)
+    {
+        _slots[i] = -1;
+    }
+    _cursor = now_ms;
+    _active = 0;
+}
+
+int8_t TimerWheelClass::schedule(uint32_t deadline_ms, WHEEL_CALLBACK cb, void* owner, uint32_t tag)
+{
+    // a deadline that already passed fires on the next advance()
+    if ((int32_t)(deadline_ms - _cursor) <= 0)
+    {
+        deadline_ms = _cursor + 1;
+    }
+    for (int8_t h = 0; h < (int8_t)WHEEL_MAX_TIMERS; h++)
+    {
+        if (_timers[h].used) continue;
+        WHEEL_TIMER& t = _timers[h];
+        uint8_t slot = deadline_ms & (WHEEL_SLOTS - 1);
+        t.deadline = deadline_ms;
+        t.cb = cb;
+        t.owner = owner;
+        t.tag = tag;
+        t.used = true;
+        t.next = _slots[slot];
+        _slots[slot] = h;
+        _active++;
+        return h;
+    }
+    return -1;
+}
+
+void TimerWheelClass::_unlink(int8_t handle)
+{
+    uint8_t slot = _timers[handle].deadline & (WHEEL_SLOTS - 1);
+    int8_t* link = &_slots[slot];
+    while (*link >= 0)
+    {
+        if (*link == handle)
+        {
+            *link = _timers[handle].next;
+            break;
+        }
+        link = &_timers[*link].next;
+    }
+    _timers[handle].used = false;
+    _timers[handle].next = -1;
+    _active--;
+}
+
+void TimerWheelClass::cancel(int8_t handle)
+{
+    if (handle < 0 || handle >= (int8_t)WHEEL_MAX_TIMERS || !_timers[handle].used)
+    {
+        return;
+    }
+    _unlink(handle);
+}
+
+void TimerWheelClass::advance(uint32_t now_ms)
+{
+    // walk one slot per elapsed millisecond so expiries come out in deadline order;
+    // with nothing pending the cursor just jumps
+    while (_active && (int32_t)(now_ms - _cursor) > 0)
+    {
+        _cursor++;
+        uint8_t slot = _cursor & (WHEEL_SLOTS - 1);
+        int8_t h = _slots[slot];
+        while (h >= 0)
+        {
+            int8_t next = _timers[h].next;
+            if (_timers[h].deadline == _cursor)
+            {
+                WHEEL_CALLBACK cb = _timers[h].cb;
+                void* owner = _timers[h].owner;
+                uint32_t tag = _timers[h].tag;
+                _unlink(h);
+                // the callback may schedule/cancel; re-read the slot head afterwards
+                cb(owner, tag, _cursor);
+                next = _slots[slot];
+            }
+            h = next;
+        }
+    }
+    if ((int32_t)(now_ms - _cursor) > 0)
+    {
+        _cursor = now_ms;
+    }
+}
+
+uint32_t TimerWheelClass::msUntilNEXT(uint32_t now_ms) const
+{
+    if (!_active)
+    {
+        return WHEEL_IDLE;
+    }
+    int32_t best = INT32_MAX;
+    for (uint8_t i = 0; i < WHEEL_MAX_TIMERS; i++)
+    {
+        if (!_timers[i].used) continue;
+        int32_t d = (int32_t)(_timers[i].deadline - now_ms);
+        if (d < best) best = d;
+    }
+    return best < 0 ? 0 : (uint32_t)best;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+
+// Hashed timer wheel with a fixed timer pool, 1 ms per slot. Timers hash into
+// slot (deadline & (WHEEL_SLOTS-1)); deadlines further out than one revolution simply stay in
+// their slot until the cursor reaches them on a later lap. No allocation, no OS timers: the
+// owning task sleeps for msUntilNEXT() and calls advance() when it wakes.
+
+const uint8_t  WHEEL_SLOTS      = 64;          // power of two
+const uint8_t  WHEEL_MAX_TIMERS = 16;
+const uint32_t WHEEL_IDLE       = 0xFFFFFFFFu; // msUntilNEXT() when nothing is pending
+
+typedef void (*WHEEL_CALLBACK)(void* owner, uint32_t tag, uint32_t now_ms);
+
+class TimerWheelClass {
+public:
+    TimerWheelClass();
+    void     reset(uint32_t now_ms);
+    int8_t   schedule(uint32_t deadline_ms, WHEEL_CALLBACK cb, void* owner, uint32_t tag); // -1 when full
+    void     cancel(int8_t handle);
+    void     advance(uint32_t now_ms);          // fire every timer whose deadline <= now_ms, in order
+    uint32_t msUntilNEXT(uint32_t now_ms) const;
+    uint8_t  pending() const { return _active; }
+private:
+    typedef struct WHEEL_TIMER {
+        uint32_t       deadline;
+        WHEEL_CALLBACK cb;
+        void*          owner;
+        uint32_t       tag;
+        int8_t         next;
+        bool           used;
+    } WHEEL_TIMER;
+
+    WHEEL_TIMER _timers[WHEEL_MAX_TIMERS];
+    int8_t      _slots[WHEEL_SLOTS];
+    uint32_t    _cursor;        // last millisecond already processed
+    uint8_t     _active;
+
+    void _unlink(int8_t handle);
+};
@@ -0,0 +1,165 @@
+// usb_recovery.cpp
+#include "usb_recovery.h"
+#include <string.h>
+
+// slot states; stats.level is the level the slot has escalated to
+const uint8_t REC_HEALTHY   = 0;
+const uint8_t REC_WAIT      = 1;    // backoff running, the action is due at `due`
+const uint8_t REC_RUNNING   = 2;    // service() handed out the action, result() pending
+const uint8_t REC_WATCH     = 3;    // action done, healthy again if no fault until `due`
+const uint8_t REC_GAVE_UP   = 4;
+
+UsbRecoveryClass::UsbRecoveryClass()
+    :   _fault_total(0)
+{
+    for (uint8_t i = 0; i < USB_MAX_DEVICES; i++)
+    {
+        _slots[i].attached = false;
+        _slots[i].pending.store(0);
+    }
+}
+
+void UsbRecoveryClass::attach(uint8_t slot)
+{
+    if (slot >= USB_MAX_DEVICES)
+    {
+        return;
+    }
+    SLOT& s = _slots[slot];
+    s.state = REC_HEALTHY;
+    s.tries = 0;
+    s.backoff = USB_REC_BASE_MS;
+    s.due = 0;
+    memset(&s.stats, 0, sizeof(s.stats));
+    s.pending.store(0);
+    s.attached = true;
+}
+
+void UsbRecoveryClass::detach(uint8_t slot)
+{
+    if (slot < USB_MAX_DEVICES)
+    {
+        _slots[slot].attached = false;
+    }
+}
+
+void UsbRecoveryClass::fault(uint8_t slot)
+{
+    _fault_total++;
+    if (slot < USB_MAX_DEVICES)
+    {
+        _slots[slot].pending++;
+    }
+}
+
+// a fault right after an action: same level with twice the backoff, or the next level
+void UsbRecoveryClass::_escalate(SLOT& s, uint32_t now_ms)
+{
+    if (++s.tries >= USB_REC_TRIES)
+    {
+        s.tries = 0;
+        if (s.stats.level >= USB_REC_REOPEN)
+        {
+            s.stats.level = USB_REC_FAILED;
+            s.state = REC_GAVE_UP;
+            return;
+        }
+        s.stats.level++;
+    }
+    s.backoff = (uint16_t)(s.backoff * 2 > USB_REC_MAX_MS ? USB_REC_MAX_MS : s.backoff * 2);
+    s.state = REC_WAIT;
+    s.due = now_ms + s.backoff;
+}
+
+uint8_t UsbRecoveryClass::service(uint8_t slot, uint32_t now_ms)
+{
+    if (slot >= USB_MAX_DEVICES || !_slots[slot].attached)
+    {
+        return USB_REC_NONE;
+    }
+    SLOT& s = _slots[slot];
+    const uint16_t faults = s.pending.exchange(0);
+    s.stats.faults += faults;
+
+    if (faults)
+    {
+        if (s.state == REC_HEALTHY)
+        {
+            s.stats.level = USB_REC_RESTART;
+            s.tries = 0;
+            s.backoff = USB_REC_BASE_MS;
+            s.state = REC_WAIT;
+            s.due = now_ms + s.backoff;
+        }
+        else if (s.state == REC_WATCH)
+        {
+            _escalate(s, now_ms);
+        }
+        // faults while waiting or running belong to the episode already being handled
+    }
+
+    if (s.state == REC_WAIT && (int32_t)(now_ms - s.due) >= 0)
+    {
+        s.state = REC_RUNNING;
+        s.stats.actions[s.stats.level]++;
+        return s.stats.level;
+    }
+    if (s.state == REC_WATCH && (int32_t)(now_ms - s.due) >= 0)
+    {
+        s.state = REC_HEALTHY;
+        s.stats.level = USB_REC_NONE;
+        s.stats.recovered++;
+    }
+    return USB_REC_NONE;
+}
+
+void UsbRecoveryClass::result(uint8_t slot, bool ok, uint32_t now_ms)
+{
+    if (slot >= USB_MAX_DEVICES || _slots[slot].state != REC_RUNNING)
+    {
+        return;
+    }
+    SLOT& s = _slots[slot];
+    if (!ok)
+    {
+        _escalate(s, now_ms);
+        return;
+    }
+    s.state = REC_WATCH;
+    s.due = now_ms + USB_REC_SETTLE_MS;
+}
+
+uint32_t UsbRecoveryClass::msUntilNEXT(uint32_t now_ms) const
+{
+    uint32_t best = USB_REC_IDLE;
+    for (uint8_t i = 0; i < USB_MAX_DEVICES; i++)
+    {
+        const SLOT& s = _slots[i];
+        if (!s.attached) continue;
+        if (s.pending.load())
+        {
+            return 0;
+        }
+        if (s.state != REC_WAIT && s.state != REC_WATCH) continue;
+        int32_t left = (int32_t)(s.due - now_ms);
+        uint32_t ms = left > 0 ? (uint32_t)left : 0;
+        if (ms < best) best = ms;
+    }
+    return best;
+}
+
+bool UsbRecoveryClass::stats(uint8_t slot, USB_REC_STATS* out) const
+{
+    if (slot >= USB_MAX_DEVICES || !_slots[slot].attached)
+    {
+        return false;
+    }
+    *out = _slots[slot].stats;
+    return true;
+}
+
+const char* UsbRecoveryClass::levelNAME(uint8_t level)
+{
+    static const char* names[] = {"ok", "restart", "reopen", "failed"};
+    return level <= USB_REC_FAILED ? names[level] : "?";
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include "report_filter.h"
+
+// Transfer-error recovery of the USB HID interfaces, one state machine per report-filter slot.
+//
+// A transfer error (or a failed driver call) is a fault. fault() may be called from any task;
+// it only counts, and the HID worker runs service() to act on it. The first fault of a healthy
+// device schedules the mildest action after USB_REC_BASE_MS; each fault that follows within
+// USB_REC_SETTLE_MS of an action doubles the backoff (up to USB_REC_MAX_MS), and after
+// USB_REC_TRIES actions on one level the next, heavier level is used:
+//   RESTART - stop and start the interface, which re-submits its interrupt IN transfer
+//   REOPEN  - close the interface, open it again, redo SET_PROTOCOL / SET_IDLE and start it
+// There is no port reset: IDF has no client-side one, and usb_host_device_free_all() only
+// succeeds once every client (the HID driver included) has deregistered. After the last REOPEN
+// the slot is FAILED and left alone until the device is replugged. A
+// device that stays quiet for USB_REC_SETTLE_MS after an action is counted as recovered and its
+// backoff starts over, so a glitch costs one restart a few ms later instead of a reboot.
+
+const uint8_t  USB_REC_NONE         = 0;        // action codes, also the escalation levels
+const uint8_t  USB_REC_RESTART      = 1;
+const uint8_t  USB_REC_REOPEN       = 2;
+const uint8_t  USB_REC_FAILED       = 3;
+
+const uint8_t  USB_REC_TRIES        = 3;        // actions per level before escalating
+const uint16_t USB_REC_BASE_MS      = 10;
+const uint16_t USB_REC_MAX_MS       = 2000;
+const uint16_t USB_REC_SETTLE_MS    = 250;
+const uint32_t USB_REC_IDLE         = 0xFFFFFFFFu;
+
+typedef struct USB_REC_STATS {
+    uint8_t  level;                             // USB_REC_NONE when healthy
+    uint32_t faults;
+    uint32_t actions[USB_REC_FAILED];           // by level, [0] unused
+    uint32_t recovered;
+} USB_REC_STATS;
+
+class UsbRecoveryClass {
+public:
+    UsbRecoveryClass();
+    void attach(uint8_t slot);
+    void detach(uint8_t slot);
+    void fault(uint8_t slot);                   // any task
+
+    // HID worker: the action to run now for the slot, then result() with its outcome
+    uint8_t service(uint8_t slot, uint32_t now_ms);
+    void    result(uint8_t slot, bool ok, uint32_t now_ms);
+    uint32_t msUntilNEXT(uint32_t now_ms) const;    // USB_REC_IDLE when nothing is scheduled
+
+    bool     stats(uint8_t slot, USB_REC_STATS* out) const;
+    bool     failed(uint8_t slot) const { return slot < USB_MAX_DEVICES && _slots[slot].stats.level == USB_REC_FAILED; }
+    uint32_t faultTOTAL() const { return _fault_total.load(); }     // never reset
+    static const char* levelNAME(uint8_t level);
+private:
+    typedef struct SLOT {
+        bool     attached;
+        uint8_t  state;
+        uint8_t  tries;
+        uint16_t backoff;
+        uint32_t due;
+        USB_REC_STATS stats;
+        std::atomic<uint16_t> pending;
+    } SLOT;
+    SLOT _slots[USB_MAX_DEVICES];
+    std::atomic<uint32_t> _fault_total;
+
+    void _escalate(SLOT& s, uint32_t now_ms);
+};
@@ -0,0 +1,81 @@
+// adc_cal_check.cpp - check the multi-point ADC calibration table (host only)
+//
+//   g++ -std=gnu++11 -I../src adc_cal_check.cpp ../src/adc_calibration.cpp -o adc_cal_check
+//   ./adc_cal_check
+//
+// Uses a bent, S3-like base curve and a "true" curve with a smooth gain error, calibrates at a
+// few raw counts and compares the table against the true battery voltage over the usable range.
+// A single point must reproduce the old scalar calibration factor. Exit status 1 on failure.
+#include <stdio.h>
+#include <math.h>
+#include "adc_calibration.h"
+
+static uint16_t bentBASE(uint16_t raw, void* ctx)
+{
+    (void)ctx;
+    double x = raw / 4095.0;
+    return (uint16_t)(3100.0 * x + 120.0 * x * x * x + 0.5);     // what the eFuse curve says
+}
+
+static double truePIN(uint16_t raw)
+{
+    double g = 1.0 + 0.025 * sin(raw / 900.0) - 0.01;              // what a multimeter says
+    return bentBASE(raw, nullptr) * g;
+}
+
+static AdcCalibrationClass cal;
+
+int main()
+{
+    const float divider = 2.0f;
+    int fails = 0;
+    cal.setBASE(bentBASE, nullptr);
+
+    // no points: the table is the base curve times the divider
+    cal.build(divider, 1.0f);
+    double err0 = 0.0;
+    for (uint16_t r = 1500; r < 3500; r++)
+    {
+        err0 = fmax(err0, fabs(cal.batteryMV(r) - truePIN(r) * divider));
+        if (cal.batteryMV(r) != (uint16_t)(bentBASE(r, nullptr) * divider + 0.5f)) fails++;
+    }
+
+    // one point == one scalar factor
+    const uint16_t r1 = 2600;
+    cal.addPOINT(r1, (uint16_t)(truePIN(r1) + 0.5));
+    cal.build(divider, 1.0f);
+    const float factor = (float)(uint16_t)(truePIN(r1) + 0.5) / bentBASE(r1, nullptr);
+    for (uint16_t r = 0; r < ADC_CAL_LUT_SIZE; r += 7)
+    {
+        float want = bentBASE(r, nullptr) * factor * divider;
+        if (fabs(cal.batteryMV(r) - want) > 1.0f) fails++;
+    }
+
+    // several points, one of them merged into a near duplicate
+    const uint16_t raws[] = {1600, 2000, 2400, 2800, 3200, 2810};
+    cal.clearPOINTS();
+    for (unsigned i = 0; i < sizeof(raws) / sizeof(raws[0]); i++)
+    {
+        cal.addPOINT(raws[i], (uint16_t)(truePIN(raws[i]) + 0.5));
+    }
+    if (cal.pointCOUNT() != 5) fails++;
+    for (uint8_t i = 1; i < cal.pointCOUNT(); i++)
+    {
+        if (cal.point(i).raw <= cal.point(i - 1).raw) fails++;
+    }
+    cal.build(divider, 1.0f);
+    double errN = 0.0;
+    for (uint16_t r = 1600; r <= 3200; r++)
+    {
+        errN = fmax(errN, fabs(cal.batteryMV(r) - truePIN(r) * divider));
+    }
+    for (uint8_t i = 0; i < cal.pointCOUNT(); i++)
+    {
+        if (fabs(cal.batteryMV(cal.point(i).raw) - cal.point(i).mv * divider) > 2.0) fails++;
+    }
+    if (errN >= err0) fails++;
+
+    printf("max battery error 1600..3200: no points %.1f mV, %u points %.1f mV; %d failures\n",
+           err0, cal.pointCOUNT(), errN, fails);
+    return fails ? 1 : 0;
+}
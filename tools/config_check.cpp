@@ -0,0 +1,164 @@
+// config_check.cpp - decode paths of the battery settings blob (host only)
+//
+//   g++ -std=gnu++11 -I../src config_check.cpp ../src/batt_config.cpp -o config_check
+//   ./config_check
+//
+// A current blob must round-trip. A version 1 blob written before the calibration fields were
+// appended must decode with those fields left at the defaults. Truncated, padded, bad-CRC,
+// wrong-magic and newer-version blobs must be rejected without touching the defaults.
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include "batt_config.h"
+
+static int errors = 0;
+
+static void expect(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        printf("FAIL: %s\n", what);
+        errors++;
+    }
+}
+
+static BATT_CONFIG_DATA defaults()
+{
+    BATT_CONFIG_DATA c;
+    memset(&c, 0, sizeof(c));
+    c.pin_adc = 1;
+    c.r_top = 100000.0f;
+    c.r_bottom = 100000.0f;
+    c.number_of_samples = 16;
+    c.interval_ms = 1000;
+    c.ema_alpha = 0.2f;
+    c.adc_ref = 3.3f;
+    c.calibration_factor = 1.0f;
+    c.capacity_mah = 1000;
+    c.cal_count = 2;
+    c.cal_raw[0] = 100;  c.cal_mv[0] = 150;
+    c.cal_raw[1] = 4000; c.cal_mv[1] = 3100;
+    return c;
+}
+
+static BATT_CONFIG_DATA edited()
+{
+    BATT_CONFIG_DATA c = defaults();
+    c.pin_adc = 7;
+    c.r_top = 47000.0f;
+    c.interval_ms = 5000;
+    c.chemistry = 1;
+    c.capacity_mah = 2500;
+    c.cal_count = 3;
+    c.cal_raw[2] = 2000; c.cal_mv[2] = 1600;
+    return c;
+}
+
+static bool same(const BATT_CONFIG_DATA& a, const BATT_CONFIG_DATA& b)
+{
+    return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+// rejected blobs leave the defaults alone
+static void reject(const uint8_t* blob, size_t len, const char* what)
+{
+    BATT_CONFIG_DATA c = defaults();
+    expect(!battConfigDECODE(blob, len, &c), what);
+    expect(same(c, defaults()), "defaults kept after a rejected blob");
+}
+
+static void resealCRC(uint8_t* blob, size_t len)
+{
+    const uint32_t crc = battConfigCRC(blob, len - 4);
+    memcpy(blob + len - 4, &crc, sizeof(crc));
+}
+
+int main()
+{
+    // CRC-32/IEEE check value, so the blobs below do not just agree with themselves
+    expect(battConfigCRC((const uint8_t*)"123456789", 9) == 0xCBF43926u, "CRC-32 check value");
+
+    uint8_t blob[BATT_CONFIG_BLOB_SIZE + 8];
+    const size_t n = battConfigENCODE(edited(), blob);
+    expect(n == BATT_CONFIG_BLOB_SIZE, "encoded length");
+    {
+        BATT_CONFIG_DATA c = defaults();
+        expect(battConfigDECODE(blob, n, &c) && same(c, edited()), "current blob round-trips");
+    }
+
+    // version 1 as written before the calibration points were appended: shorter payload
+    {
+        const uint8_t payload = (uint8_t)offsetof(BATT_CONFIG_DATA, cal_count);
+        uint8_t v1[BATT_CONFIG_HEADER + sizeof(BATT_CONFIG_DATA) + 4];
+        const BATT_CONFIG_DATA e = edited();
+        v1[0] = (uint8_t)(BATT_CONFIG_MAGIC & 0xFF);
+        v1[1] = (uint8_t)(BATT_CONFIG_MAGIC >> 8);
+        v1[2] = 1;
+        v1[3] = payload;
+        memcpy(v1 + BATT_CONFIG_HEADER, &e, payload);
+        const size_t len = BATT_CONFIG_HEADER + payload + 4;
+        resealCRC(v1, len);
+
+        BATT_CONFIG_DATA c = defaults();
+        BATT_CONFIG_DATA want = edited();
+        const BATT_CONFIG_DATA d = defaults();
+        want.cal_count = d.cal_count;
+        memcpy(want.cal_raw, d.cal_raw, sizeof(want.cal_raw));
+        memcpy(want.cal_mv, d.cal_mv, sizeof(want.cal_mv));
+        expect(battConfigDECODE(v1, len, &c), "v1 blob accepted");
+        expect(same(c, want), "v1 fields taken, appended fields at their defaults");
+    }
+
+    // truncated: every length short of the full blob, including a header alone
+    {
+        bool all = true;
+        for (size_t len = 0; len < n; len++)
+        {
+            BATT_CONFIG_DATA c = defaults();
+            if (battConfigDECODE(blob, len, &c) || !same(c, defaults())) all = false;
+        }
+        expect(all, "truncated blobs rejected");
+    }
+
+    // padded past the length in the header
+    {
+        uint8_t pad[sizeof(blob)];
+        memcpy(pad, blob, n);
+        pad[n] = 0;
+        reject(pad, n + 1, "padded blob rejected");
+    }
+
+    // a flipped bit anywhere: header, payload or the CRC itself
+    {
+        const size_t at[] = { 3, BATT_CONFIG_HEADER, BATT_CONFIG_HEADER + 7, n - 5, n - 1 };
+        for (size_t i = 0; i < sizeof(at) / sizeof(at[0]); i++)
+        {
+            uint8_t bad[sizeof(blob)];
+            memcpy(bad, blob, n);
+            bad[at[i]] ^= 0x10;
+            reject(bad, n, "bad CRC rejected");
+        }
+    }
+
+    // resealed, so only the header check can catch them
+    {
+        uint8_t bad[sizeof(blob)];
+        memcpy(bad, blob, n);
+        bad[0] ^= 0xFF;
+        resealCRC(bad, n);
+        reject(bad, n, "wrong magic rejected");
+
+        memcpy(bad, blob, n);
+        bad[2] = BATT_CONFIG_VERSION + 1;
+        resealCRC(bad, n);
+        reject(bad, n, "blob from a newer firmware rejected");
+
+        memcpy(bad, blob, n);
+        bad[2] = 0;
+        resealCRC(bad, n);
+        reject(bad, n, "version 0 rejected");
+    }
+
+    printf("%d errors\n", errors);
+    return errors ? 1 : 0;
+}
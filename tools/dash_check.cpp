@@ -0,0 +1,108 @@
+// dash_check.cpp - render dashboard frames and diff them the way the panel task does (host only)
+//
+//   g++ -std=gnu++11 -O2 -I../src dash_check.cpp ../src/dashboard_view.cpp ../src/oled_frame.cpp -o dash_check
+//   ./dash_check [--show]
+//
+// Each step changes one DASH_STATE field and checks that only the expected pages come out
+// dirty, and counts the bytes a partial push would send against a full 1 KB display(). --show
+// prints the frames as text art.
+#include <stdio.h>
+#include <string.h>
+#include "dashboard_view.h"
+
+static int errors = 0;
+static void check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        printf("FAIL: %s\n", what);
+        errors++;
+    }
+}
+
+static void show(const OledFrameClass& f)
+{
+    for (uint8_t y = 0; y < OLED_PAGES * 8; y++)
+    {
+        char row[OLED_WIDTH + 1];
+        for (uint8_t x = 0; x < OLED_WIDTH; x++)
+        {
+            row[x] = (f.at(x, y >> 3) >> (y & 7)) & 1 ? '#' : '.';
+        }
+        row[OLED_WIDTH] = 0;
+        printf("%s\n", row);
+    }
+}
+
+// pages that differ, as a bit mask, plus the bytes a partial push sends; brings `shown` up to date
+static uint8_t push(OledFrameClass& shown, const OledFrameClass& next, uint32_t* bytes)
+{
+    uint8_t mask = 0;
+    *bytes = 0;
+    for (uint8_t p = 0; p < OLED_PAGES; p++)
+    {
+        uint8_t x0, x1;
+        if (!OledFrameClass::dirtyRANGE(next, shown, p, &x0, &x1))
+        {
+            continue;
+        }
+        mask |= (uint8_t)(1u << p);
+        *bytes += x1 - x0 + 1;
+        shown.copyPAGE(next, p, x0, x1);
+    }
+    return mask;
+}
+
+int main(int argc, char** argv)
+{
+    const bool verbose = argc > 1 && !strcmp(argv[1], "--show");
+    DASH_STATE s = {true, "QWERTY", false, true, 3921, 78, false, 12, 34, "NORMAL", 3600 + 23 * 60};
+    OledFrameClass shown, next;
+    uint32_t bytes;
+
+    dashRENDER(s, &next);
+    uint8_t m = push(shown, next, &bytes);
+    check(m == 0xFF, "first frame touches every page");
+    if (verbose) show(shown);
+
+    // glyph placement: 'H' of "Host" is the 5 columns at x 0..4 of page 1
+    check(shown.at(0, 1) == 0x7F && shown.at(2, 1) == 0x08 && shown.at(5, 1) == 0x00, "glyph H");
+    // title bar inverted
+    check(shown.at(OLED_WIDTH - 1, 0) == 0xFF, "title bar");
+
+    dashRENDER(s, &next);
+    check(push(shown, next, &bytes) == 0 && bytes == 0, "same state, nothing to send");
+
+    struct STEP { const char* what; uint8_t pages; void (*apply)(DASH_STATE&); };
+    static const STEP steps[] = {
+        {"battery 10 mV",      0x04, [](DASH_STATE& x) { x.battery_mv = 3911; }},
+        {"battery percent",    0x0C, [](DASH_STATE& x) { x.battery_pct = 77; }},
+        {"charging",           0x04, [](DASH_STATE& x) { x.charging = true; }},
+        {"p99",                0x10, [](DASH_STATE& x) { x.latency_p99_ms = 9; }},
+        {"key rate",           0x20, [](DASH_STATE& x) { x.keys_per_s_x10 = 52; }},
+        {"BLE drops",          0x01, [](DASH_STATE& x) { x.ble_connected = false; }},
+        {"host profile",       0x02, [](DASH_STATE& x) { x.host_mac = true; }},
+        {"tier",               0x40, [](DASH_STATE& x) { x.power_tier = "LOW"; }},
+        {"uptime +59 s",       0x00, [](DASH_STATE& x) { x.uptime_s += 59 - (x.uptime_s % 60); }},
+        {"uptime next minute", 0x80, [](DASH_STATE& x) { x.uptime_s += 1; }},
+    };
+    uint32_t total = 0;
+    for (const STEP& st : steps)
+    {
+        st.apply(s);
+        dashRENDER(s, &next);
+        m = push(shown, next, &bytes);
+        total += bytes;
+        printf("%-20s pages 0x%02X  %4u bytes\n", st.what, m, (unsigned)bytes);
+        check(m == st.pages, st.what);
+        check(bytes < OLED_WIDTH * 2 || m == 0x0C, "partial push stays small");
+    }
+    if (verbose) show(shown);
+    printf("%u bytes for %u updates, %u with full frames\n", (unsigned)total,
+           (unsigned)(sizeof(steps) / sizeof(steps[0])), (unsigned)(sizeof(steps) / sizeof(steps[0]) * 1024));
+
+    // a frame pushed by ranges equals the rendered frame
+    check(memcmp(shown.page(0), next.page(0), OLED_WIDTH * OLED_PAGES) == 0, "panel copy matches render");
+    printf("%d error(s)\n", errors);
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,219 @@
+// debounce_sim.cpp - KeyDebounceClass against synthetic contact bounce on a virtual clock (host only)
+//
+//   g++ -std=gnu++11 -O2 -I../src debounce_sim.cpp ../src/key_debounce.cpp -o debounce_sim
+//   ./debounce_sim
+//
+// Each case feeds a scripted list of 6-key boot reports into a fresh filter on a 1 ms clock and
+// calls recheck() once msUntilRECHECK() runs out, as the HID worker does between reports. The
+// filtered reports are turned back into key edges stamped with the virtual time they left the
+// filter, and compared with the edges a clean contact would have produced. The window is 5 ms.
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "key_debounce.h"
+
+static const uint8_t A      = 0x04;
+static const uint8_t B      = 0x05;
+static const uint8_t C      = 0x06;
+static const uint8_t LSHIFT = 0xE1;         // modifier bit 1 as a usage
+static const uint16_t WINDOW = 5;
+
+static int errors = 0;
+
+static void expect(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        printf("FAIL: %s\n", what);
+        errors++;
+    }
+}
+
+typedef struct REPORT {
+    uint32_t t;
+    uint8_t  mods;
+    uint8_t  keys[6];
+} REPORT;
+
+typedef struct EDGE {
+    uint32_t t;
+    uint8_t  usage;
+    bool     pressed;
+} EDGE;
+
+static bool has(const uint8_t* keys, uint8_t k)
+{
+    return memchr(keys, k, 6) != nullptr;
+}
+
+// edges between two filtered reports, modifiers as usages 0xE0..0xE7
+static void diff(uint32_t t, const uint8_t* prev_keys, uint8_t prev_mods, const uint8_t* keys, uint8_t mods,
+                 std::vector<EDGE>* out)
+{
+    for (uint8_t b = 0; b < 8; b++)
+    {
+        const uint8_t m = 1u << b;
+        if ((prev_mods ^ mods) & m) out->push_back(EDGE{t, (uint8_t)(0xE0 + b), (mods & m) != 0});
+    }
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        if (prev_keys[i] && !has(keys, prev_keys[i])) out->push_back(EDGE{t, prev_keys[i], false});
+    }
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        if (keys[i] && !has(prev_keys, keys[i])) out->push_back(EDGE{t, keys[i], true});
+    }
+}
+
+static void print(const char* tag, const std::vector<EDGE>& v)
+{
+    printf("  %-8s", tag);
+    for (size_t i = 0; i < v.size(); i++)
+    {
+        printf(" %02X%c@%u", v[i].usage, v[i].pressed ? 'v' : '^', v[i].t);
+    }
+    printf("\n");
+}
+
+// plays `in` up to `end_ms` through `f`, or a fresh filter
+static void run(const char* name, uint8_t mode, const std::vector<REPORT>& in, uint32_t end_ms,
+                const std::vector<EDGE>& want, KeyDebounceClass* f = nullptr)
+{
+    KeyDebounceClass local;
+    KeyDebounceClass& deb = f ? *f : local;
+    deb.setWINDOW(WINDOW);
+    deb.setMODE(mode);
+
+    std::vector<EDGE> out;
+    REPORT cur;
+    memset(&cur, 0, sizeof(cur));
+    size_t next = 0;
+    for (uint32_t now = 0; now <= end_ms; now++)
+    {
+        REPORT r;
+        memset(&r, 0, sizeof(r));
+        r.t = now;
+        if (next < in.size() && in[next].t == now)
+        {
+            deb.filter(in[next].mods, in[next].keys, 6, (uint16_t)now, &r.mods, r.keys);
+            next++;
+        }
+        else if (deb.msUntilRECHECK((uint16_t)now) == 0)
+        {
+            deb.recheck((uint16_t)now, 6, &r.mods, r.keys);
+        }
+        else
+        {
+            continue;
+        }
+        diff(now, cur.keys, cur.mods, r.keys, r.mods, &out);
+        cur = r;
+    }
+
+    bool same = out.size() == want.size();
+    for (size_t i = 0; same && i < out.size(); i++)
+    {
+        same = out[i].t == want[i].t && out[i].usage == want[i].usage && out[i].pressed == want[i].pressed;
+    }
+    printf("%s: %s\n", name, same ? "ok" : "MISMATCH");
+    if (!same)
+    {
+        print("output", out);
+        print("wanted", want);
+    }
+    expect(same, name);
+    expect(deb.msUntilRECHECK((uint16_t)end_ms) == DEBOUNCE_IDLE, "no window left open");
+}
+
+// a press that bounces `n` times 1 ms apart from `t`, ending down
+static void bounceDOWN(std::vector<REPORT>* v, uint32_t t, uint8_t key, uint8_t n)
+{
+    for (uint8_t i = 0; i <= 2 * n; i++)
+    {
+        v->push_back(REPORT{t + i, 0, {(uint8_t)(i & 1 ? 0 : key), 0, 0, 0, 0, 0}});
+    }
+}
+
+int main()
+{
+    // OFF hands the keyboard's report through, slot order and all
+    {
+        KeyDebounceClass deb;
+        const uint8_t in[6] = {C, 0, A, B, 0, 0};
+        uint8_t keys[6], mods;
+        deb.filter(0x22, in, 6, 0, &mods, keys);
+        expect(mods == 0x22 && !memcmp(keys, in, 6), "OFF passes the report through");
+    }
+
+    run("eager clean tap", DEBOUNCE_EAGER, {
+            {0, 0, {A}}, {40, 0, {0}},
+        }, 100, {
+            {0, A, true}, {40, A, false},
+        });
+
+    // the first edge goes out at once, the chatter behind it is eaten
+    {
+        std::vector<REPORT> in;
+        bounceDOWN(&in, 10, A, 2);
+        in.push_back(REPORT{60, 0, {0}});
+        in.push_back(REPORT{61, 0, {A}});
+        in.push_back(REPORT{62, 0, {0}});
+        KeyDebounceClass deb;
+        run("eager press and release bounce", DEBOUNCE_EAGER, in, 100, {
+                {10, A, true}, {60, A, false},
+            }, &deb);
+        expect(deb.suppressedCOUNT() == 6, "eager counts every suppressed edge");
+        expect(deb.worstKEY() == A && deb.chatterCOUNT(A) == 6, "A is the worst offender");
+    }
+
+    // a 2 ms glitch: the release inside the window is applied when the window closes
+    run("eager glitch settles at window end", DEBOUNCE_EAGER, {
+            {0, 0, {A}}, {2, 0, {0}},
+        }, 100, {
+            {0, A, true}, {WINDOW, A, false},
+        });
+
+    // DEFER waits for a stable window after the last bounce; a short glitch never shows
+    {
+        std::vector<REPORT> in;
+        bounceDOWN(&in, 10, A, 2);
+        in.push_back(REPORT{50, 0, {A, B}});
+        in.push_back(REPORT{52, 0, {A}});
+        in.push_back(REPORT{80, 0, {0}});
+        run("defer bounce and glitch", DEBOUNCE_DEFER, in, 120, {
+                {14 + WINDOW, A, true}, {80 + WINDOW, A, false},
+            });
+    }
+
+    // a bouncing shift changes the modifier byte once each way
+    run("eager modifier bounce", DEBOUNCE_EAGER, {
+            {0, 0x02, {0}}, {1, 0x00, {0}}, {2, 0x02, {0}}, {30, 0x02, {A}},
+            {40, 0x00, {A}}, {41, 0x02, {A}}, {42, 0x00, {A}}, {50, 0x00, {0}},
+        }, 100, {
+            {0, LSHIFT, true}, {30, A, true}, {40, LSHIFT, false}, {50, A, false},
+        });
+
+    // slot order: B before A as the keyboard sent it; A bouncing up keeps its slot
+    {
+        KeyDebounceClass deb;
+        run("eager keeps slot order", DEBOUNCE_EAGER, {
+                {0, 0, {B}}, {20, 0, {B, A}}, {30, 0, {B}}, {31, 0, {B, A}}, {32, 0, {B}},
+            }, 33, {
+                {0, B, true}, {20, A, true}, {30, A, false},
+            }, &deb);
+        uint8_t keys[6], mods;
+        const uint8_t in[6] = {C, B, 0, 0, 0, 0};
+        deb.filter(0, in, 6, 40, &mods, keys);
+        expect(keys[0] == C && keys[1] == B && !keys[2], "accepted keys follow the raw slot order");
+
+        // A pressed at 45 bounces up at 46: its window holds it down in its old slot
+        const uint8_t pressed[6] = {A, C, B, 0, 0, 0};
+        deb.filter(0, pressed, 6, 45, &mods, keys);
+        const uint8_t bounce[6] = {C, B, 0, 0, 0, 0};
+        deb.filter(0, bounce, 6, 46, &mods, keys);
+        expect(keys[0] == A && keys[1] == C && keys[2] == B, "a key held by its window keeps its slot");
+    }
+
+    printf("%d errors\n", errors);
+    return errors ? 1 : 0;
+}
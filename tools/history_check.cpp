@@ -0,0 +1,111 @@
+// history_check.cpp - round-trip and query check of the battery history page codec (host only)
+//
+//   g++ -std=gnu++11 -I../src history_check.cpp ../src/history_codec.cpp ../src/batt_config.cpp -o history_check
+//   ./history_check [samples] [seed]
+//
+// Encodes a random discharge/charge walk into pages, decodes them again and compares every
+// sample, then checks windowed min/avg/max built from page summaries plus edge-page decoding
+// against a brute-force pass over the original samples. Exit status 1 on any mismatch.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "history_codec.h"
+
+static uint32_t rng = 1;
+static uint32_t rnd() { rng = rng * 1664525u + 1013904223u; return rng >> 8; }
+
+static bool sameSTATS(const HIST_STATS& a, const HIST_STATS& b)
+{
+    return a.count == b.count && (!a.count || (a.mv_min == b.mv_min && a.mv_max == b.mv_max &&
+           a.mv_sum == b.mv_sum && a.t_first == b.t_first && a.t_last == b.t_last));
+}
+
+int main(int argc, char** argv)
+{
+    const unsigned total = argc > 1 ? (unsigned)atoi(argv[1]) : 200000;
+    rng = argc > 2 ? (uint32_t)atoi(argv[2]) : 1;
+
+    // a walk with occasional large jumps (reconnected cell, boot) and time gaps
+    std::vector<HIST_SAMPLE> in;
+    HIST_SAMPLE x = {0, 4150, HIST_FLAG_BOOT};
+    for (unsigned i = 0; i < total; i++)
+    {
+        in.push_back(x);
+        x.t += (rnd() % 50 == 0) ? 1 + rnd() % 100000 : 60;
+        int step = (rnd() % 200 == 0) ? (int)(rnd() % 2000) - 1000 : (int)(rnd() % 7) - 3;
+        x.mv = (uint16_t)(x.mv + step < 2500 ? 2500 : (x.mv + step > 4300 ? 4300 : x.mv + step));
+        x.flags = (uint8_t)((rnd() % 1000 == 0 ? HIST_FLAG_BOOT : 0) | ((i / 5000) & 1 ? HIST_FLAG_CHARGING : 0));
+    }
+
+    std::vector<std::vector<uint8_t> > pages;
+    std::vector<uint8_t> page(HIST_PAGE_SIZE);
+    HistPageWriterClass w;
+    w.begin(page.data(), 0);
+    for (size_t i = 0; i < in.size(); i++)
+    {
+        if (!w.append(in[i]))
+        {
+            w.seal();
+            pages.push_back(page);
+            w.begin(page.data(), (uint32_t)pages.size());
+            if (!w.append(in[i])) { printf("append into an empty page failed\n"); return 1; }
+        }
+    }
+    w.seal();
+    pages.push_back(page);
+
+    unsigned errors = 0;
+    size_t k = 0;
+    for (size_t p = 0; p < pages.size(); p++)
+    {
+        HistPageReaderClass r;
+        if (!r.begin(pages[p].data(), true)) { printf("page %u invalid\n", (unsigned)p); return 1; }
+        HIST_SAMPLE s;
+        while (r.next(&s))
+        {
+            if (k >= in.size() || s.t != in[k].t || s.mv != in[k].mv || s.flags != in[k].flags) errors++;
+            k++;
+        }
+    }
+    if (k != in.size()) errors++;
+
+    // corrupt one byte: the page must be rejected
+    pages[0][HIST_HEADER_SIZE + 7] ^= 0x40;
+    if (histPageVALID(pages[0].data())) errors++;
+    pages[0][HIST_HEADER_SIZE + 7] ^= 0x40;
+
+    // windowed queries: whole pages from the summary, edge pages decoded
+    unsigned queries = 0;
+    const uint32_t t_max = in.back().t;
+    for (unsigned q = 0; q < 2000; q++)
+    {
+        uint32_t a = rnd() % (t_max + 1), b = rnd() % (t_max + 1);
+        if (a > b) { uint32_t t = a; a = b; b = t; }
+
+        HIST_STATS want, got;
+        histStatsRESET(&want);
+        histStatsRESET(&got);
+        for (size_t i = 0; i < in.size(); i++)
+            if (in[i].t >= a && in[i].t <= b) histStatsADD(&want, in[i]);
+
+        for (size_t p = 0; p < pages.size(); p++)
+        {
+            const HIST_PAGE_HEADER* h = (const HIST_PAGE_HEADER*)pages[p].data();
+            if (h->t_end < a || h->t_start > b) continue;
+            if (h->t_start >= a && h->t_end <= b) { histStatsADD_PAGE(&got, *h); continue; }
+            HistPageReaderClass r;
+            r.begin(pages[p].data(), false);
+            HIST_SAMPLE s;
+            while (r.next(&s))
+                if (s.t >= a && s.t <= b) histStatsADD(&got, s);
+        }
+        if (!sameSTATS(want, got)) errors++;
+        queries++;
+    }
+
+    printf("%u samples, %u pages, %.2f bytes/sample, %u queries, %u errors\n",
+           (unsigned)in.size(), (unsigned)pages.size(),
+           (double)(pages.size() * HIST_DATA_MAX) / in.size(), queries, errors);
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,170 @@
+// hub_fanin_sim.cpp - several keyboards and a mouse behind a simulated hub (host only)
+//
+//   g++ -std=gnu++11 -O2 -I../src hub_fanin_sim.cpp ../src/key_fanin.cpp ../src/report_filter.cpp -o hub_fanin_sim
+//   ./hub_fanin_sim
+//
+// Part 1 drives the fan-in with scripted reports and checks the logical keyboard: OR of the
+// modifier bytes, a key shared by two keyboards released only by the last one, ErrorRollOver,
+// and an unplug releasing only what nobody else holds.
+// Part 2 is the fairness run. Every 1 ms frame the hub delivers a report from each interface:
+// keyboard A types 10 keys a second, a chattering macro pad taps a new key every frame, and a
+// 1 kHz mouse moves all the time. Reports go through the redundant filter, fan-in and a diff
+// into a KEYQUEUE_DEPTH queue that the BLE side drains at 2 notifications per 7.5 ms connection
+// event. Run once with admission and once without; A must lose nothing with it.
+#include <stdio.h>
+#include <string.h>
+#include <deque>
+#include "report_filter.h"
+#include "key_fanin.h"
+
+static const uint16_t QUEUE_DEPTH   = 256;      // KEYQUEUE_DEPTH
+static const uint32_t RUN_MS        = 10000;
+static int errors = 0;
+
+static void expect(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        printf("FAIL: %s\n", what);
+        errors++;
+    }
+}
+
+static bool has(const uint8_t* keys, uint8_t k)
+{
+    for (uint8_t i = 0; i < FANIN_MAX_KEYS; i++)
+    {
+        if (keys[i] == k) return true;
+    }
+    return false;
+}
+
+static void part1()
+{
+    KeyFanInClass f;
+    uint8_t mods, keys[FANIN_MAX_KEYS];
+    f.attach(0);
+    f.attach(1);
+    const uint8_t a_only[6] = {0x04, 0, 0, 0, 0, 0};
+    const uint8_t a_and_b[6] = {0x05, 0x04, 0, 0, 0, 0};
+    const uint8_t none[6] = {0};
+    const uint8_t rollover[6] = {0x01, 0x01, 0x01, 0x01, 0x01, 0x01};
+
+    f.update(0, 0x02, a_only);                  // LShift + A on keyboard 0
+    f.update(1, 0x01, a_and_b);                 // LCtrl + B + A on keyboard 1
+    f.merged(&mods, keys);
+    expect(mods == 0x03, "modifier bytes are OR-ed");
+    expect(has(keys, 0x04) && has(keys, 0x05) && keys[2] == 0, "keys are a union without duplicates");
+
+    f.update(0, 0, none);
+    f.merged(&mods, keys);
+    expect(has(keys, 0x04) && mods == 0x01, "A still held by keyboard 1 after keyboard 0 let go");
+
+    f.update(1, 0x01, rollover);
+    f.merged(&mods, keys);
+    expect(has(keys, 0x04) && has(keys, 0x05), "ErrorRollOver keeps the previous keys");
+
+    f.update(0, 0, a_only);
+    f.update(1, 0, none);                       // unplug: keys dropped, then detach
+    f.detach(1);
+    f.merged(&mods, keys);
+    expect(has(keys, 0x04) && !has(keys, 0x05) && mods == 0, "unplug releases only what nobody else holds");
+    expect(f.count() == 1, "count after detach");
+}
+
+typedef struct SIM_DEV {
+    uint8_t slot;
+    uint32_t pressed;                           // presses produced by the diff
+    uint32_t delivered;                         // presses that reached BLE
+} SIM_DEV;
+
+static void part2(bool fair, uint32_t* a_lost, uint32_t* pad_lost)
+{
+    static int hdh_a, hdh_pad, hdh_mouse;
+    ReportFilterClass filter;
+    KeyFanInClass fan;
+    fan.setQUEUE(fair ? QUEUE_DEPTH : 0xFFFF);  // 0xFFFF: the share never binds
+    SIM_DEV a = {filter.attach(&hdh_a, REPORT_KIND_KEYBOARD, 0), 0, 0};
+    SIM_DEV pad = {filter.attach(&hdh_pad, REPORT_KIND_KEYBOARD, 0), 0, 0};
+    uint8_t mouse = filter.attach(&hdh_mouse, REPORT_KIND_MOUSE, 0);
+    fan.attach(a.slot);
+    fan.attach(pad.slot);
+
+    std::deque<KB_EVENT> queue;
+    uint8_t prev[FANIN_MAX_KEYS] = {0};
+    uint32_t mouse_reports = 0;
+
+    for (uint32_t t = 1; t <= RUN_MS; t++)
+    {
+        uint8_t a_rep[8] = {0}, pad_rep[8] = {0}, m_rep[4] = {0};
+        if (t % 100 < 40) a_rep[2] = (uint8_t)(0x04 + (t / 100) % 20);         // 10 keys/s, 40 ms down
+        pad_rep[2] = (uint8_t)(0x1E + t % 10);                                 // new key every frame
+        m_rep[1] = (t & 1) ? 1 : 0xFF;
+
+        const struct { SIM_DEV* d; uint8_t* rep; } kbs[] = {{&a, a_rep}, {&pad, pad_rep}};
+        for (uint8_t n = 0; n < 2; n++)
+        {
+            SIM_DEV* d = kbs[n].d;
+            if (!filter.changed(d->slot, kbs[n].rep, 8, t)) continue;
+            uint8_t mods, curr[FANIN_MAX_KEYS];
+            fan.update(d->slot, kbs[n].rep[0], kbs[n].rep + 2);
+            fan.merged(&mods, curr);
+            for (uint8_t i = 0; i < FANIN_MAX_KEYS; i++)
+            {
+                if (prev[i] && !has(curr, prev[i]) && fan.admit(d->slot, prev[i], false))
+                {
+                    if (queue.size() < QUEUE_DEPTH) queue.push_back({prev[i], 0, false, d->slot, t});
+                    else fan.done(d->slot);
+                }
+            }
+            for (uint8_t i = 0; i < FANIN_MAX_KEYS; i++)
+            {
+                if (!curr[i] || has(prev, curr[i])) continue;
+                d->pressed++;
+                if (!fan.admit(d->slot, curr[i], true)) continue;
+                if (queue.size() < QUEUE_DEPTH) queue.push_back({curr[i], 0, true, d->slot, t});
+                else fan.done(d->slot);
+            }
+            memcpy(prev, curr, sizeof(prev));
+        }
+        mouse_reports += filter.changed(mouse, m_rep, 4, t);
+
+        // 7.5 ms connection interval, 2 notifications per event
+        if ((t * 2) % 15 == 0)
+        {
+            for (uint8_t k = 0; k < 2 && !queue.empty(); k++)
+            {
+                KB_EVENT e = queue.front();
+                queue.pop_front();
+                fan.done(e.src);
+                if (!e.pressed) continue;
+                (e.src == a.slot ? a : pad).delivered++;
+            }
+        }
+    }
+    // whatever is still queued would go out; count it as delivered
+    while (!queue.empty())
+    {
+        KB_EVENT e = queue.front();
+        queue.pop_front();
+        if (e.pressed) (e.src == a.slot ? a : pad).delivered++;
+    }
+    *a_lost = a.pressed - a.delivered;
+    *pad_lost = pad.pressed - pad.delivered;
+    printf("%-13s keyboard A %u/%u presses, pad %u/%u presses (%u refused), mouse %u reports\n",
+           fair ? "fair:" : "first come:", a.delivered, a.pressed, pad.delivered, pad.pressed,
+           fan.refused(pad.slot), mouse_reports);
+}
+
+int main()
+{
+    part1();
+    uint32_t a_lost, pad_lost, a_lost_unfair, pad_lost_unfair;
+    part2(false, &a_lost_unfair, &pad_lost_unfair);
+    part2(true, &a_lost, &pad_lost);
+    expect(a_lost_unfair > 0, "without admission the pad crowds keyboard A out");
+    expect(a_lost == 0, "with admission keyboard A loses nothing");
+    expect(pad_lost > 0, "the pad pays for its own chatter");
+    printf("%d errors\n", errors);
+    return errors ? 1 : 0;
+}
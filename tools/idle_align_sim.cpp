@@ -0,0 +1,77 @@
+// idle_align_sim.cpp - wake-ups per second of the idle bridge, free-running vs aligned (host only)
+//
+//   g++ -std=gnu++11 -O2 -I../src idle_align_sim.cpp -o idle_align_sim
+//   ./idle_align_sim [seconds]
+//
+// Every periodic task of the idle bridge (no keys, telemetry off, panel on) is modelled by its
+// period and the millisecond its task happened to start. "before" is the old schedule: own
+// vTaskDelayUntil phases, HID worker and console polling. "after" is the idle_manager schedule:
+// idleNEXT_WAKE() on the shared time base, idle periods, no HID poll, console woken by RX.
+// A wake instant is a millisecond in which at least one task wakes - what the chip sees.
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "idle_schedule.h"
+
+typedef struct TASK {
+    const char* name;
+    uint32_t    period_ms;
+    uint32_t    start_ms;
+} TASK;
+
+static uint32_t count(const std::vector<TASK>& tasks, uint32_t seconds, bool aligned, uint32_t* wakeups)
+{
+    const uint32_t end = seconds * 1000u;
+    std::vector<uint32_t> next(tasks.size());
+    for (size_t i = 0; i < tasks.size(); i++)
+    {
+        next[i] = aligned ? idleNEXT_WAKE(tasks[i].start_ms, tasks[i].period_ms) : tasks[i].start_ms + tasks[i].period_ms;
+    }
+    uint32_t instants = 0;
+    *wakeups = 0;
+    for (uint32_t t = 0; t < end; t++)
+    {
+        bool any = false;
+        for (size_t i = 0; i < tasks.size(); i++)
+        {
+            if (next[i] != t) continue;
+            any = true;
+            (*wakeups)++;
+            next[i] = aligned ? idleNEXT_WAKE(t, tasks[i].period_ms) : t + tasks[i].period_ms;
+        }
+        instants += any;
+    }
+    return instants;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t seconds = argc > 1 ? (uint32_t)atoi(argv[1]) : 600;
+    const std::vector<TASK> before = {
+        {"hid worker poll",   50,   37},
+        {"console poll",      20,   412},
+        {"telemetry drain",   50,   433},
+        {"log drain",         100,  436},
+        {"dashboard",         250,  421},
+        {"battery reading",   1500, 611},
+        {"battery samples",   75,   611},      // 20 samples spread over 1.5 s
+        {"loop",              1000, 440},
+    };
+    const std::vector<TASK> after = {
+        {"console fallback",  1000,  412},
+        {"telemetry samplers", 1000, 433},
+        {"log drain (idle)",  1000, 436},
+        {"dashboard (idle)",  1000, 421},
+        {"battery reading",   1500, 611},
+        {"battery samples",   idlePERIOD(75),     611},
+        {"adc fallback",      1000, 300},
+        {"loop",              1000, 440},
+    };
+    uint32_t wb, wa;
+    uint32_t ib = count(before, seconds, false, &wb);
+    uint32_t ia = count(after, seconds, true, &wa);
+    printf("before: %6.1f task wake-ups/s in %6.1f wake instants/s\n", (float)wb / seconds, (float)ib / seconds);
+    printf("after:  %6.1f task wake-ups/s in %6.1f wake instants/s\n", (float)wa / seconds, (float)ia / seconds);
+    printf("chip wake-ups cut by %.1fx\n", (float)ib / ia);
+    return ia < ib ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+// layer_sim.cpp - tap-hold and layer resolution of KeyLayerClass on a virtual clock (host only)
+//
+//   g++ -std=gnu++11 -O2 -I../src layer_sim.cpp ../src/key_layers.cpp ../src/key_combos.cpp ../src/ascii_hid.cpp ../src/timer_wheel.cpp -o layer_sim
+//   ./layer_sim
+//
+// Each case builds a fresh engine on a fresh timer wheel and plays a scripted event list; the
+// wheel is advanced to every event's time first, as TASK_BLE does between queue reads. The
+// default tap-hold key is used: Space taps Space and holds layer 1 (Fn), where H is Left and
+// N is transparent. The output stream is compared event by event, stamped with the virtual
+// time it left the engine, so a buffered key shows the latency the tap-hold decision added.
+// The last cases chain the combo engine behind the layers, as TASK_BLE does, with the default
+// J+K -> Esc combo: under Fn the same keys are arrows and must not complete the chord.
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "key_layers.h"
+#include "key_combos.h"
+
+static const uint8_t SPACE  = 0x2C;
+static const uint8_t H      = 0x0B;
+static const uint8_t J      = 0x0D;
+static const uint8_t K      = 0x0E;
+static const uint8_t N      = 0x11;
+static const uint8_t X      = 0x1B;
+static const uint8_t Z      = 0x1D;
+static const uint8_t LEFT   = 0x50;
+static const uint8_t DOWN   = 0x51;
+static const uint8_t UP     = 0x52;
+static const uint8_t ESC    = 0x29;
+
+static int errors = 0;
+static uint32_t now_ms = 0;
+
+static void expect(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        printf("FAIL: %s\n", what);
+        errors++;
+    }
+}
+
+typedef struct STEP {
+    uint32_t t;
+    uint8_t  usage;
+    bool     pressed;
+} STEP;
+
+static void collect(const KB_EVENT& ev, void* arg)
+{
+    static_cast<std::vector<STEP>*>(arg)->push_back(STEP{now_ms, ev.usage, ev.pressed});
+}
+
+static void print(const char* tag, const std::vector<STEP>& v)
+{
+    printf("  %-8s", tag);
+    for (size_t i = 0; i < v.size(); i++)
+    {
+        printf(" %02X%c@%u", v[i].usage, v[i].pressed ? 'v' : '^', v[i].t);
+    }
+    printf("\n");
+}
+
+static void toCOMBOS(const KB_EVENT& ev, void* arg)
+{
+    static_cast<KeyComboClass*>(arg)->onEVENT(ev);
+}
+
+// plays `in`, then lets the clock run to `end_ms`, and compares the output with `want`
+static void run(const char* name, const std::vector<STEP>& in, uint32_t end_ms, const std::vector<STEP>& want,
+                bool with_combos = false)
+{
+    TimerWheelClass wheel;
+    KeyLayerClass layers;
+    KeyComboClass combos;
+    std::vector<STEP> out;
+    if (with_combos)
+    {
+        combos.begin(&wheel, collect, &out);
+        layers.begin(&wheel, toCOMBOS, &combos);
+    }
+    else
+    {
+        layers.begin(&wheel, collect, &out);
+    }
+
+    // 1 ms ticks, so a timer fires at its own deadline
+    size_t next = 0;
+    for (now_ms = 0; now_ms <= end_ms; now_ms++)
+    {
+        wheel.advance(now_ms);
+        for (; next < in.size() && in[next].t == now_ms; next++)
+        {
+            layers.onEVENT(KB_EVENT{in[next].usage, 0, in[next].pressed, KB_SRC_NONE, now_ms});
+        }
+    }
+
+    bool same = out.size() == want.size();
+    for (size_t i = 0; same && i < out.size(); i++)
+    {
+        same = out[i].t == want[i].t && out[i].usage == want[i].usage && out[i].pressed == want[i].pressed;
+    }
+    printf("%s: %s\n", name, same ? "ok" : "MISMATCH");
+    if (!same)
+    {
+        print("input", in);
+        print("output", out);
+        print("wanted", want);
+    }
+    expect(same, name);
+    expect(wheel.pending() == 0, "no timer left behind");
+    expect(layers.activeLAYERS() == 0x01, "only the base layer active at the end");
+}
+
+int main()
+{
+    const uint32_t T = TAP_HOLD_TERM_MS;
+
+    run("tap", {
+            {0, SPACE, true}, {50, SPACE, false},
+        }, 1000, {
+            {50, SPACE, true}, {50, SPACE, false},
+        });
+
+    // one millisecond short of the term is still a tap, the term itself is a hold
+    run("release at term - 1", {
+            {0, SPACE, true}, {T - 1, SPACE, false},
+        }, 1000, {
+            {T - 1, SPACE, true}, {T - 1, SPACE, false},
+        });
+    run("hold at the term", {
+            {0, SPACE, true}, {T + 50, H, true}, {T + 80, H, false}, {T + 100, SPACE, false},
+            {T + 150, H, true}, {T + 160, H, false},
+        }, 1000, {
+            {T + 50, LEFT, true}, {T + 80, LEFT, false},
+            {T + 150, H, true}, {T + 160, H, false},
+        });
+
+    // H is pressed and released inside Space: Fn wins at once, long before the term
+    run("permissive hold", {
+            {0, SPACE, true}, {30, H, true}, {60, H, false}, {100, SPACE, false},
+        }, 1000, {
+            {60, LEFT, true}, {60, LEFT, false},
+        });
+
+    // keys pressed while Space is undecided come out behind it, in their order
+    run("buffered ordering", {
+            {0, SPACE, true}, {10, X, true}, {20, Z, true}, {40, SPACE, false},
+            {60, X, false}, {70, Z, false},
+        }, 1000, {
+            {40, SPACE, true}, {40, X, true}, {40, Z, true}, {40, SPACE, false},
+            {60, X, false}, {70, Z, false},
+        });
+    run("layer change while a key is down", {
+            {0, SPACE, true}, {T + 10, H, true}, {T + 20, SPACE, false}, {T + 30, H, false},
+        }, 1000, {
+            {T + 10, LEFT, true}, {T + 30, LEFT, false},
+        });
+
+    // typing "space n" fast: N has no Fn meaning, so it must not turn the Space into Fn
+    run("Space-N roll, nested", {
+            {0, SPACE, true}, {30, N, true}, {60, N, false}, {90, SPACE, false},
+        }, 1000, {
+            {90, SPACE, true}, {90, N, true}, {90, N, false}, {90, SPACE, false},
+        });
+    run("Space-N roll, overlapped", {
+            {0, SPACE, true}, {30, N, true}, {60, SPACE, false}, {90, N, false},
+        }, 1000, {
+            {60, SPACE, true}, {60, N, true}, {60, SPACE, false}, {90, N, false},
+        });
+    run("nested N held past the term", {
+            {0, SPACE, true}, {30, N, true}, {60, N, false}, {T + 100, SPACE, false},
+        }, 1000, {
+            {T, N, true}, {T, N, false},
+        });
+
+    // layers -> combos: the chord is matched on what the layer made of the keys
+    run("J+K on the base layer fires the combo", {
+            {0, J, true}, {10, K, true}, {50, J, false}, {60, K, false},
+        }, 1000, {
+            {COMBO_TERM_MS, ESC, true}, {COMBO_TERM_MS, ESC, false},
+        }, true);
+    run("Fn+J+K sends the arrows, not the combo", {
+            {0, SPACE, true}, {30, J, true}, {35, K, true}, {60, J, false}, {65, K, false},
+            {100, SPACE, false},
+        }, 1000, {
+            {60, DOWN, true}, {60, UP, true}, {60, DOWN, false}, {65, UP, false},
+        }, true);
+    run("Fn+J+K held past the term", {
+            {0, SPACE, true}, {T + 10, J, true}, {T + 15, K, true}, {T + 40, J, false},
+            {T + 45, K, false}, {T + 80, SPACE, false},
+        }, 1000, {
+            {T + 10, DOWN, true}, {T + 15, UP, true}, {T + 40, DOWN, false}, {T + 45, UP, false},
+        }, true);
+
+    printf("%d errors\n", errors);
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,150 @@
+// log_bench.cpp - deferred log record vs inline snprintf on the report path (host only)
+//
+//   g++ -std=gnu++11 -O2 -pthread -I../src log_bench.cpp ../src/log_ring.cpp -o log_bench
+//   ./log_bench [iterations]
+//
+// "inline" is what hid_KB_Report_CALLBACK used to do for every report: format the modifier
+// byte and six keys into a 128-byte stack buffer. "deferred" is what DLOG_D stores instead.
+// "drain" is the log task turning the same record into a line later. The host CPU is much
+// faster than the S3, so compare the ratio rather than the nanoseconds. Last, several threads
+// push into one ring while a consumer drains it: every record must arrive once, in its
+// producer's order, or be counted as dropped.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "log_ring.h"
+
+static const unsigned PRODUCERS = 3;
+
+static volatile uint32_t sink;
+static LogRingClass shared;
+static std::atomic<unsigned> running(0);
+
+static double nsPER(std::chrono::steady_clock::time_point t0, uint32_t n)
+{
+    auto dt = std::chrono::steady_clock::now() - t0;
+    return std::chrono::duration<double, std::nano>(dt).count() / n;
+}
+
+// args[0] is the producer, args[1] its running count
+static void producer(uint32_t id, uint32_t n, uint32_t* accepted)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        const uint32_t v[2] = {id, i};
+        if (shared.push(DLOG_LEVEL_DEBUG, i, "%u %u", v, 2)) (*accepted)++;
+        else std::this_thread::yield();         // let the consumer catch up
+    }
+    running--;
+}
+
+// false when a record is lost, duplicated, torn or out of order
+static bool contended(uint32_t per_producer)
+{
+    uint32_t accepted[PRODUCERS] = {0};
+    std::vector<uint32_t> next(PRODUCERS, 0), got(PRODUCERS, 0);
+    std::vector<std::thread> threads;
+    bool ok = true;
+    running = PRODUCERS;
+    for (uint32_t p = 0; p < PRODUCERS; p++)
+    {
+        threads.push_back(std::thread(producer, p, per_producer, &accepted[p]));
+    }
+    DLOG_RECORD r;
+    for (;;)
+    {
+        const bool last = running.load() == 0;
+        while (shared.pop(&r))
+        {
+            const uint32_t p = r.args[0];
+            if (p >= PRODUCERS || r.nargs != 2 || r.args[1] < next[p] || r.time_ms != r.args[1])
+            {
+                ok = false;
+                continue;
+            }
+            next[p] = r.args[1] + 1;
+            got[p]++;
+        }
+        if (last) break;
+    }
+    uint32_t pushed = 0, popped = 0;
+    for (uint32_t p = 0; p < PRODUCERS; p++)
+    {
+        threads[p].join();
+        ok = ok && got[p] == accepted[p];
+        pushed += per_producer;
+        popped += got[p];
+    }
+    printf("contended: %u producers, %u pushed, %u popped, %u dropped\n",
+           PRODUCERS, pushed, popped, shared.dropped());
+    return ok && popped + shared.dropped() == pushed;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t iters = argc > 1 ? (uint32_t)atoi(argv[1]) : 2000000;
+    uint8_t report[8] = {0x02, 0, 0x04, 0x05, 0, 0, 0, 0};
+
+    // the old inline formatting
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iters; i++)
+    {
+        report[2] = (uint8_t)i;
+        char buf[128];
+        int n = snprintf(buf, sizeof(buf), "RAW : 0x%02x", report[0]);
+        for (size_t k = 0; k < 6 && n < (int)sizeof(buf) - 4; ++k)
+        {
+            n += snprintf(buf + n, sizeof(buf) - n, " %02x", report[2 + k]);
+        }
+        sink += (uint32_t)n + (uint8_t)buf[n - 1];
+    }
+    double inline_ns = nsPER(t0, iters);
+
+    // producer side of DLOG_D; the ring is emptied in batches outside the timed loop
+    static LogRingClass ring;
+    DLOG_RECORD r;
+    double push_ns = 0.0;
+    uint32_t done = 0;
+    while (done < iters)
+    {
+        uint32_t batch = iters - done < DLOG_RING_SIZE ? iters - done : DLOG_RING_SIZE;
+        t0 = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < batch; i++)
+        {
+            report[2] = (uint8_t)(done + i);
+            const uint32_t v[7] = {report[0], report[2], report[3], report[4], report[5], report[6], report[7]};
+            ring.push(DLOG_LEVEL_DEBUG, done + i, "RAW : 0x%02x %02x %02x %02x %02x %02x %02x", v, 7);
+        }
+        push_ns += nsPER(t0, 1);       // the whole batch
+        while (ring.pop(&r)) {}
+        done += batch;
+    }
+    push_ns /= iters;
+
+    // consumer side: the same work as inline, moved to the log task
+    char line[DLOG_LINE_MAX];
+    const uint32_t v[7] = {2, 0, 4, 5, 0, 0, 0};
+    ring.push(DLOG_LEVEL_DEBUG, 12345, "RAW : 0x%02x %02x %02x %02x %02x %02x %02x", v, 7);
+    ring.pop(&r);
+    t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iters; i++)
+    {
+        r.time_ms = i;
+        sink += (uint32_t)LogRingClass::format(r, line, sizeof(line));
+    }
+    double drain_ns = nsPER(t0, iters);
+
+    printf("sample line:  %s", line);
+    printf("inline snprintf   %7.1f ns / report\n", inline_ns);
+    printf("deferred push     %7.1f ns / report  (%.1fx less on the report path)\n", push_ns, inline_ns / push_ns);
+    printf("drain format      %7.1f ns / record  (log task, lowest priority)\n", drain_ns);
+    printf("record %u bytes, ring %u records, %u dropped\n", (unsigned)sizeof(DLOG_RECORD), DLOG_RING_SIZE, ring.dropped());
+
+    const bool ok = contended(iters / 4);
+    printf("%s\n", ok ? "contended ok" : "FAIL: contended ring lost, repeated or reordered records");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+// macro_link_sim.cpp - macro recording and paced playback over a simulated BLE link (host only)
+//
+//   g++ -std=gnu++11 -O2 -I../src macro_link_sim.cpp ../src/key_macros.cpp ../src/link_pacer.cpp -o macro_link_sim
+//   ./macro_link_sim
+//
+// A text is typed into KeyMacroClass as KB_EVENTs (shifted letters, taps, one rolled pair), the
+// slot is copied out and loaded into a second instance the way MacroStoreClass does across a
+// reboot, and played back through LinkPacerClass into a model of the controller: `bufs` ACL
+// buffers, at most `per_event` packets sent per connection event, buffers given back at the end
+// of the event they went out in. The TASK_BLE side sleeps in whole milliseconds as on the
+// device. Checked for several links: the peer decodes the same text, the host never queues a
+// packet (a buffer is free for every notification), and the burst runs at the link's rate.
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <deque>
+#include <vector>
+#include "key_macros.h"
+#include "link_pacer.h"
+
+static const uint8_t SHIFT = 0x02;     // left shift bit
+static const uint8_t RESERVE = 1;      // BLE_NOTIFY_RESERVE
+static int errors = 0;
+
+static void expect(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        printf("FAIL: %s\n", what);
+        errors++;
+    }
+}
+
+static uint8_t charUSAGE(char c, bool* shift)
+{
+    *shift = c >= 'A' && c <= 'Z';
+    if (c >= 'a' && c <= 'z') return (uint8_t)(0x04 + c - 'a');
+    if (c >= 'A' && c <= 'Z') return (uint8_t)(0x04 + c - 'A');
+    if (c == ' ') return 0x2C;
+    if (c == ',') return 0x36;
+    if (c == '!') { *shift = true; return 0x1E; }
+    return 0;
+}
+
+static char usageCHAR(uint8_t u, bool shift)
+{
+    if (u >= 0x04 && u <= 0x1D) return (char)((shift ? 'A' : 'a') + u - 0x04);
+    if (u == 0x2C) return ' ';
+    if (u == 0x36) return ',';
+    if (u == 0x1E && shift) return '!';
+    return '?';
+}
+
+static void ev(KeyMacroClass& m, uint8_t usage, uint8_t mods, bool pressed)
+{
+    m.recordEVENT(KB_EVENT{usage, mods, pressed, KB_SRC_NONE, 0});
+}
+
+// types `text` the way the diff produces it; "wo" in "world" is rolled: w down, o down, w up, o up
+static void record(KeyMacroClass& m, const char* text)
+{
+    for (const char* p = text; *p; p++)
+    {
+        bool shift;
+        uint8_t u = charUSAGE(*p, &shift);
+        if (p[0] == 'w' && p[1] == 'o')
+        {
+            uint8_t o = charUSAGE('o', &shift);
+            ev(m, u, 0, true);
+            ev(m, o, 0, true);
+            ev(m, u, 0, false);
+            ev(m, o, 0, false);
+            p++;
+            continue;
+        }
+        if (shift) ev(m, 0, SHIFT, true);
+        ev(m, u, shift ? SHIFT : 0, true);
+        ev(m, u, shift ? SHIFT : 0, false);
+        if (shift) ev(m, 0, 0, false);
+    }
+}
+
+// the peer: a key that appears in a report is a press, typed with the report's shift state
+static std::string decode(const std::vector<KB_REPORT>& reports)
+{
+    std::string out;
+    KB_REPORT prev;
+    memset(&prev, 0, sizeof(prev));
+    for (size_t i = 0; i < reports.size(); i++)
+    {
+        const KB_REPORT& r = reports[i];
+        for (uint8_t k = 0; k < 6; k++)
+        {
+            if (!r.keys[k] || memchr(prev.keys, r.keys[k], 6)) continue;
+            out += usageCHAR(r.keys[k], (r.mods & 0x22) != 0);
+        }
+        prev = r;
+    }
+    return out;
+}
+
+typedef struct LINK {
+    const char* name;
+    uint32_t interval_us;
+    uint16_t bufs;
+    uint16_t per_event;
+} LINK;
+
+static void play(const LINK& l, KeyMacroClass& m, uint8_t slot, const char* text)
+{
+    LinkPacerClass pacer;
+    pacer.setRESERVE(RESERVE);
+    pacer.setINTERVAL(l.interval_us);
+
+    std::deque<KB_REPORT> ctrl;             // packets in controller buffers, oldest first
+    std::vector<KB_REPORT> peer;
+    uint16_t free_bufs = l.bufs;
+    uint16_t min_free = l.bufs;
+    uint32_t now = 3000;                    // the burst does not start on an event boundary
+    uint32_t next_event = l.interval_us;
+    uint32_t sent = 0;
+
+    pacer.reset(now);
+    expect(m.startPLAYBACK(slot), "playback starts");
+    uint32_t start = now;
+    uint32_t guard = 0;
+    while ((m.playing() || !ctrl.empty()) && guard++ < 100000)
+    {
+        // TASK_BLE: send while the stack has a buffer for it, then sleep in whole ms
+        while (m.playing() && pacer.take(now, free_bufs))
+        {
+            KB_REPORT r;
+            m.nextREPORT(&r);
+            ctrl.push_back(r);
+            free_bufs--;
+            sent++;
+            if (free_bufs < min_free) min_free = free_bufs;
+        }
+        uint32_t wake = now + ((pacer.usUntilCREDIT(now) + 999) / 1000) * 1000;
+        if (!m.playing()) wake = next_event;
+        // connection events between now and the wake-up
+        while (next_event <= wake)
+        {
+            uint16_t n = 0;
+            while (!ctrl.empty() && n < l.per_event)
+            {
+                peer.push_back(ctrl.front());
+                ctrl.pop_front();
+                n++;
+            }
+            free_bufs += n;
+            next_event += l.interval_us;
+        }
+        now = wake > now ? wake : now + 1000;
+    }
+    const uint32_t took = now - start;
+    const uint16_t usable = l.bufs - RESERVE < l.per_event ? l.bufs - RESERVE : l.per_event;
+    const uint32_t ideal = (sent + usable - 1) / usable * l.interval_us;
+
+    std::string got = decode(peer);
+    printf("%-22s %3u reports in %6.1f ms (link best %6.1f ms), %3u waits, min free %u\n",
+           l.name, sent, took / 1000.0, ideal / 1000.0, pacer.stalls(), min_free);
+    expect(got == text, "peer types the recorded text");
+    expect(peer.size() == sent, "every report delivered");
+    expect(min_free >= RESERVE, "reserve never used by the burst");
+    // a wait may start just after an event and see its buffers only one interval later
+    expect(took <= ideal + 2 * l.interval_us, "burst runs at the link's rate");
+    expect(peer.size() && decode(std::vector<KB_REPORT>(1, peer.back())).empty(), "ends all-up");
+}
+
+int main()
+{
+    const char* text = "Hello, world! Macros pace by credits";
+
+    KeyMacroClass rec;
+    expect(rec.startRECORD(2), "start recording");
+    uint8_t buf[MACRO_MAX_BYTES];
+    uint16_t len = 0;
+    expect(!rec.copySLOT(2, buf, &len), "no copy while recording");
+    record(rec, text);
+    expect(!rec.dirty(), "not dirty while recording");
+    rec.stopRECORD();
+    expect(rec.takeDIRTY() == (1u << 2), "closed slot is dirty");
+    expect(!rec.dirty(), "takeDIRTY clears");
+    expect(rec.copySLOT(2, buf, &len) && len == rec.slotLENGTH(2), "copy of a closed slot");
+    printf("%zu characters recorded in %u bytes\n", strlen(text), len);
+
+    // what MacroStoreClass::begin() does after a reboot
+    KeyMacroClass boot;
+    expect(boot.loadSLOT(2, buf, len), "load slot");
+    expect(!boot.loadSLOT(MACRO_SLOTS, buf, len), "bad slot rejected");
+
+    const LINK links[] = {
+        {"7.5 ms, 4 bufs, 2/ev",  7500,  4,  2},
+        {"15 ms, 12 bufs, 6/ev",  15000, 12, 6},
+        {"30 ms, 3 bufs, 8/ev",   30000, 3,  8},
+        {"7.5 ms, 24 bufs, 1/ev", 7500,  24, 1},
+    };
+    for (size_t i = 0; i < sizeof(links) / sizeof(links[0]); i++)
+    {
+        play(links[i], boot, 2, text);
+    }
+
+    printf("%d errors\n", errors);
+    return errors ? 1 : 0;
+}
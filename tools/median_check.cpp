@@ -0,0 +1,112 @@
+// median_check.cpp - running median window against the old vector+sort sampler (host only)
+//
+//   g++ -std=gnu++11 -O2 -I../src median_check.cpp ../src/running_median.cpp -o median_check
+//   ./median_check
+//
+// The reference is the median the battery sampler computed before the running window: copy the
+// batch into a vector, std::sort it, average the three middle samples. Every window size from
+// MEDIAN_MIN_SAMPLES to MEDIAN_MAX_SAMPLES is fed several streams (uniform 12-bit noise, heavy
+// duplicates, ramps, a slow battery curve with spikes) and median3() must equal the reference
+// over the last count() samples after every push, exactly, partial windows included.
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+#include "running_median.h"
+
+static int errors = 0;
+
+static void expect(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        printf("FAIL: %s\n", what);
+        errors++;
+    }
+}
+
+static uint32_t rng = 12345;
+static uint32_t next()
+{
+    rng = rng * 1103515245u + 12345u;
+    return rng >> 8;
+}
+
+// the pre-window sampler, minus analogRead()
+static float sortMEDIAN(const std::vector<uint16_t>& batch)
+{
+    std::vector<int> v(batch.begin(), batch.end());
+    std::sort(v.begin(), v.end());
+    const int n = (int)v.size();
+    int mid = n / 2;
+    int start = std::max(0, mid - 1);
+    int end = std::min(n - 1, mid + 1);
+    long sum = 0;
+    for (int i = start; i <= end; i++)
+    {
+        sum += v[i];
+    }
+    return (float)sum / (float)(end - start + 1);
+}
+
+static uint16_t sample(int stream, int i)
+{
+    switch (stream)
+    {
+        case 0:  return (uint16_t)(next() & 0x0FFF);                        // noise
+        case 1:  return (uint16_t)(2000 + (next() & 3));                    // duplicates
+        case 2:  return (uint16_t)(i * 7 & 0x0FFF);                         // rising ramp
+        case 3:  return (uint16_t)(4095 - (i * 5 & 0x0FFF));                // falling ramp
+        default:
+        {
+            uint16_t v = (uint16_t)(2600 - i / 8 + (next() % 9));           // battery and noise
+            if (next() % 23 == 0) v = (next() & 1) ? 4095 : 0;              // spikes
+            return v;
+        }
+    }
+}
+
+int main()
+{
+    RunningMedianClass m;
+    long pushes = 0;
+    for (int size = MEDIAN_MIN_SAMPLES; size <= MEDIAN_MAX_SAMPLES; size++)
+    {
+        for (int stream = 0; stream < 5; stream++)
+        {
+            m.setSIZE((uint8_t)size);
+            std::vector<uint16_t> history;
+            int bad = 0;
+            for (int i = 0; i < 600; i++)
+            {
+                uint16_t s = sample(stream, i);
+                m.push(s);
+                history.push_back(s);
+                pushes++;
+                const size_t n = std::min<size_t>(history.size(), (size_t)size);
+                std::vector<uint16_t> batch(history.end() - n, history.end());
+                if (m.count() != n || m.median3() != sortMEDIAN(batch)) bad++;
+            }
+            if (bad)
+            {
+                printf("size %d stream %d: %d mismatches\n", size, stream, bad);
+            }
+            expect(bad == 0, "median3 equals the sorted batch median");
+            expect(m.full(), "window full after the run");
+        }
+    }
+
+    m.setSIZE(1);
+    expect(m.size() == MEDIAN_MIN_SAMPLES, "size clamped up");
+    m.setSIZE(200);
+    expect(m.size() == MEDIAN_MAX_SAMPLES, "size clamped down");
+    m.push(100);
+    m.reset();
+    expect(m.count() == 0 && m.median3() == 0.0f, "reset empties the window");
+    m.push(7);
+    expect(m.median3() == 7.0f, "one sample");
+
+    printf("%ld pushes compared\n", pushes);
+    printf("%d errors\n", errors);
+    return errors ? 1 : 0;
+}
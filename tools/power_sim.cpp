@@ -0,0 +1,43 @@
+// power_sim.cpp - host-side projection of the power policy (not part of the firmware build)
+//
+//   g++ -std=gnu++11 -I../src power_sim.cpp ../src/power_policy.cpp -o power_sim && ./power_sim
+//
+// Prints the projected radio duty cycle per tier for idle, typing and fast-typing loads plus
+// advertising, then runs a noisy discharge through the tier machine to show the hysteresis.
+#include <stdio.h>
+#include <stdlib.h>
+#include "power_policy.h"
+
+int main()
+{
+    const float loads[] = {0.0f, 2.0f, 10.0f};     // input reports per second (press+release)
+    printf("%-9s %6s %10s %8s %8s %8s %8s\n", "tier", "tx", "conn(ms)", "idle", "2 rps", "10 rps", "adv");
+    for (uint8_t t = 0; t < POWER_TIER_COUNT; t++)
+    {
+        const POWER_TIER_PARAMS& p = PowerPolicyClass::paramsFOR(t);
+        printf("%-9s %+4ddBm %4.1f-%-5.1f", PowerPolicyClass::tierNAME(t), p.tx_dbm,
+               p.conn_min * 1.25f, p.conn_max * 1.25f);
+        for (unsigned i = 0; i < sizeof(loads) / sizeof(loads[0]); i++)
+        {
+            printf(" %7.3f%%", 100.0f * PowerPolicyClass::projectedDUTY(p, loads[i], true));
+        }
+        printf(" %7.3f%%\n", 100.0f * PowerPolicyClass::projectedDUTY(p, 0.0f, false));
+    }
+
+    // 100% -> 0% with +-3% load sag noise, then back on the charger
+    PowerPolicyClass policy;
+    unsigned changes = 0;
+    srand(1);
+    for (int step = 0; step <= 1000; step++)
+    {
+        int pct = 100 - step / 10 + (rand() % 7) - 3;
+        bool charging = step == 1000;
+        if (policy.update(pct < 0 ? 0 : pct, charging))
+        {
+            changes++;
+            printf("step %4d  pct %3d  -> %s\n", step, pct, PowerPolicyClass::tierNAME(policy.tier()));
+        }
+    }
+    printf("%u tier changes\n", changes);
+    return 0;
+}
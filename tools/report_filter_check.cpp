@@ -0,0 +1,95 @@
+// report_filter_check.cpp - redundant-report suppression and rate counters at 1 kHz (host only)
+//
+//   g++ -std=gnu++11 -O2 -I../src report_filter_check.cpp ../src/report_filter.cpp -o report_filter_check
+//   ./report_filter_check [seconds]
+//
+// A gaming keyboard sends a boot report every 1 ms frame and a mouse every 8 ms; the keyboard
+// types about 8 keys a second. Checks that exactly the changed reports pass, that the rates read
+// back per device, that a silent device reads 0, and times the repeat path the report callback
+// now takes 999 times out of 1000. Compare the ns with the diff path rather than trusting them.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "report_filter.h"
+
+static int errors = 0;
+
+static void expect(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        printf("FAIL: %s\n", what);
+        errors++;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t seconds = argc > 1 ? (uint32_t)atoi(argv[1]) : 10;
+    static int kb_dev, mouse_dev, spare_dev[USB_MAX_DEVICES];
+    ReportFilterClass f;
+    uint8_t kb = f.attach(&kb_dev, REPORT_KIND_KEYBOARD, 0);
+    uint8_t ms = f.attach(&mouse_dev, REPORT_KIND_MOUSE, 0);
+    expect(kb != REPORT_NO_SLOT && ms != REPORT_NO_SLOT && kb != ms, "attach");
+    expect(f.attach(&kb_dev, REPORT_KIND_KEYBOARD, 0) == kb, "attach twice gives the same slot");
+    expect(f.find(&mouse_dev) == ms && f.kind(ms) == REPORT_KIND_MOUSE, "find");
+    for (uint8_t i = 2; i < USB_MAX_DEVICES; i++) f.attach(&spare_dev[i], REPORT_KIND_GENERIC, 0);
+    expect(f.attach(&spare_dev[0], REPORT_KIND_GENERIC, 0) == REPORT_NO_SLOT, "full table");
+    expect(f.changed(REPORT_NO_SLOT, nullptr, 0, 0), "unknown device always passes");
+
+    uint8_t report[8] = {0};
+    uint8_t prev[8] = {0xFF};
+    uint8_t mouse[4] = {0};
+    uint32_t kb_passed = 0, kb_expected = 0, mouse_passed = 0;
+    for (uint32_t t = 1; t <= seconds * 1000u; t++)
+    {
+        // press at 0 ms and release at 60 ms of every 125 ms
+        uint8_t phase = (uint8_t)(t % 125);
+        if (phase == 0) report[2] = (uint8_t)(0x04 + (t / 125) % 26);
+        if (phase == 60) report[2] = 0;
+        if (memcmp(report, prev, sizeof(report)))
+        {
+            memcpy(prev, report, sizeof(report));
+            kb_expected++;
+        }
+        kb_passed += f.changed(kb, report, sizeof(report), t);
+        if (t % 8 == 0)
+        {
+            mouse[1] = (t / 8) % 2 ? 1 : 0xFF;      // always moving
+            mouse_passed += f.changed(ms, mouse, sizeof(mouse), t);
+        }
+    }
+    REPORT_DEV_STATS st;
+    expect(kb_passed == kb_expected, "exactly the changed keyboard reports pass");
+    expect(mouse_passed == seconds * 125u, "every moving mouse report passes");
+    expect(f.stats(kb, seconds * 1000u, &st), "keyboard stats");
+    printf("keyboard: %u reports, %u redundant, %u/s, %u changed/s\n", st.reports, st.redundant,
+           st.reports_per_s, st.changed_per_s);
+    expect(st.reports_per_s >= 999 && st.reports_per_s <= 1001, "keyboard at 1000 reports/s");
+    expect(st.changed_per_s >= 15 && st.changed_per_s <= 17, "keyboard at 16 changes/s");
+    expect(st.redundant == st.reports - kb_passed, "redundant count");
+    expect(f.stats(ms, seconds * 1000u, &st) && st.reports_per_s == 125 && st.redundant == 0, "mouse at 125/s");
+    expect(f.redundantTOTAL() == seconds * 1000u - kb_passed, "redundant total");
+    expect(f.stats(kb, seconds * 1000u + 2 * REPORT_RATE_WINDOW_MS, &st) && st.reports_per_s == 0, "silent device reads 0");
+
+    // a re-attached handle starts over, its first report passes again
+    f.detach(&kb_dev);
+    expect(!f.stats(kb, 0, &st) && f.find(&kb_dev) == REPORT_NO_SLOT, "detach");
+    kb = f.attach(&kb_dev, REPORT_KIND_KEYBOARD, 0);
+    expect(f.changed(kb, report, sizeof(report), 1), "first report after attach passes");
+    expect(f.changed(kb, report, 7, 2), "length change passes");
+
+    const uint32_t n = 10000000;
+    uint32_t passed = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < n; i++)
+    {
+        passed += f.changed(kb, report, 7, i);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / n;
+    printf("repeat path: %.1f ns per report (%u passed)\n", ns, passed);
+
+    printf("%d errors\n", errors);
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,73 @@
+// snapshot_stress.cpp - hammer SeqLatch (the battery snapshot) from several threads (host only)
+//
+//   g++ -std=gnu++11 -O2 -pthread -I../src snapshot_stress.cpp -o snapshot_stress
+//   ./snapshot_stress [publishes] [readers]
+//
+// One writer publishes readings whose fields are all derived from one counter; every reader
+// checks that each snapshot it gets belongs to a single publish and that the counter never goes
+// backwards.
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "batt_snapshot.h"
+
+static BattSnapshotClass snap;
+static std::atomic<bool> done(false);
+
+static BATT_SNAPSHOT make(uint32_t i)
+{
+    BATT_SNAPSHOT s;
+    s.voltage = 3.0f + (float)(i % 1024) / 1024.0f;    // exact in float
+    s.percent = (int16_t)(i % 101);
+    s.charging = (i & 1) != 0;
+    s.time_ms = i;
+    return s;
+}
+
+static void reader(unsigned long* reads, unsigned long* torn)
+{
+    uint32_t last = 0;
+    while (!done.load(std::memory_order_relaxed))
+    {
+        BATT_SNAPSHOT s;
+        if (!snap.read(&s)) continue;
+        BATT_SNAPSHOT want = make(s.time_ms);
+        if (s.voltage != want.voltage || s.percent != want.percent ||
+            s.charging != want.charging || s.time_ms < last)
+        {
+            (*torn)++;
+        }
+        last = s.time_ms;
+        (*reads)++;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const unsigned long publishes = argc > 1 ? strtoul(argv[1], nullptr, 0) : 5000000ul;
+    const unsigned n = argc > 2 ? (unsigned)atoi(argv[2]) : 3;
+
+    std::vector<unsigned long> reads(n, 0), torn(n, 0);
+    std::vector<std::thread> threads;
+    for (unsigned r = 0; r < n; r++)
+    {
+        threads.push_back(std::thread(reader, &reads[r], &torn[r]));
+    }
+    for (uint32_t i = 1; i <= publishes; i++)
+    {
+        snap.publish(make(i));
+    }
+    done = true;
+    unsigned long total_reads = 0, total_torn = 0;
+    for (unsigned r = 0; r < n; r++)
+    {
+        threads[r].join();
+        total_reads += reads[r];
+        total_torn += torn[r];
+    }
+    printf("publishes %lu  reads %lu  retries %u  torn %lu\n",
+           publishes, total_reads, snap.retries(), total_torn);
+    return total_torn ? 1 : 0;
+}
@@ -0,0 +1,77 @@
+// soc_replay.cpp - replay a recorded battery trace through the SoC estimator (host only)
+//
+//   g++ -std=gnu++11 -I../src soc_replay.cpp ../src/soc_estimator.cpp -o soc_replay
+//   ./soc_replay [chem] [capacity_mah] [mean_limit_pct] [max_limit_pct] < trace.csv
+//   ./soc_replay 0 1000 < traces/lipo_1000mah.csv
+//
+// Input lines: time_ms,battery_mv,charging(0/1),load_ma[,reference_percent]
+// Output lines: time_ms,battery_mv,estimate_percent,stddev_permille[,error_percent]
+// With a reference column the mean and max absolute error are printed at the end, and the exit
+// status is 1 when either is above its limit (defaults 2 % and 5 %).
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "soc_estimator.h"
+
+static const double MEAN_LIMIT_PCT = 2.0;
+static const double MAX_LIMIT_PCT  = 5.0;
+
+int main(int argc, char** argv)
+{
+    SocEstimatorClass soc;
+    soc.setPROFILE(argc > 1 ? (uint8_t)atoi(argv[1]) : SOC_CHEM_LIPO);
+    soc.setCAPACITY(argc > 2 ? (uint16_t)atoi(argv[2]) : 1000);
+    const double mean_limit = argc > 3 ? atof(argv[3]) : MEAN_LIMIT_PCT;
+    const double max_limit  = argc > 4 ? atof(argv[4]) : MAX_LIMIT_PCT;
+
+    char line[128];
+    unsigned long last_ms = 0;
+    bool first = true;
+    double err_sum = 0.0, err_max = 0.0;
+    unsigned long n_ref = 0;
+    while (fgets(line, sizeof(line), stdin))
+    {
+        unsigned long t_ms;
+        unsigned mv;
+        int charging;
+        float load_ma;
+        float ref = -1.0f;
+        int fields = sscanf(line, "%lu,%u,%d,%f,%f", &t_ms, &mv, &charging, &load_ma, &ref);
+        if (fields < 4)
+        {
+            continue;   // header or comment
+        }
+        if (first)
+        {
+            soc.reset((uint16_t)mv, load_ma);
+            first = false;
+        }
+        else
+        {
+            soc.update((uint16_t)mv, charging != 0, load_ma, (uint32_t)(t_ms - last_ms));
+        }
+        last_ms = t_ms;
+        printf("%lu,%u,%u,%.1f", t_ms, mv, soc.percent(), soc.stddevPERMILLE());
+        if (fields == 5)
+        {
+            double e = soc.permille() / 10.0 - ref;
+            err_sum += fabs(e);
+            if (fabs(e) > err_max) err_max = fabs(e);
+            n_ref++;
+            printf(",%.1f", e);
+        }
+        printf("\n");
+    }
+    if (!n_ref)
+    {
+        return 0;
+    }
+    const double err_mean = err_sum / n_ref;
+    fprintf(stderr, "mean |error| %.2f %%, max |error| %.2f %% over %lu samples\n", err_mean, err_max, n_ref);
+    if (err_mean > mean_limit || err_max > max_limit)
+    {
+        fprintf(stderr, "FAIL: limits %.2f %% mean, %.2f %% max\n", mean_limit, max_limit);
+        return 1;
+    }
+    return 0;
+}
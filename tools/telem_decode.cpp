@@ -0,0 +1,110 @@
+// telem_decode.cpp - turn the firmware's binary telemetry stream back into CSV or text (host only)
+//
+//   g++ -std=gnu++11 -I../src telem_decode.cpp -o telem_decode
+//   ./telem_decode [--text] < capture.bin          (capture: raw bytes from the serial port)
+//
+// Frames are 0x00-delimited COBS blocks of one record + CRC-8 (telemetry_format.h). Anything
+// else on the port, e.g. console output, is passed through to stderr; frames failing the CRC
+// and malformed frames are counted and reported at the end. CSV columns: time_ms,seq,type,arg,a,b
+#include <stdio.h>
+#include <string.h>
+#include "telemetry_format.h"
+
+static const char* typeNAME(uint8_t t)
+{
+    switch (t)
+    {
+        case TELEM_BATTERY: return "battery";
+        case TELEM_LATENCY: return "latency";
+        case TELEM_QUEUE:   return "queue";
+        case TELEM_COUNTER: return "counter";
+        default:            return "unknown";
+    }
+}
+
+static const char* queueNAME(uint8_t q)
+{
+    static const char* names[] = {"keys", "hid", "bulk"};
+    return q < 3 ? names[q] : "?";
+}
+
+static const char* counterNAME(uint8_t c)
+{
+    static const char* names[] = {"telemetry_dropped", "key_drops", "debounce_suppressed", "redundant_reports",
+                                  "usb_faults"};
+    return c < 5 ? names[c] : "?";
+}
+
+static void printTEXT(const TELEM_RECORD& r)
+{
+    printf("%10u  #%-5u ", (unsigned)r.time_ms, (unsigned)r.seq);
+    switch (r.type)
+    {
+        case TELEM_BATTERY:
+            printf("battery  %u mV (ema %u mV) %u%%%s\n", (unsigned)r.a, (unsigned)r.b,
+                   (unsigned)(r.arg & 0x7F), (r.arg & 0x80) ? " charging" : "");
+            break;
+        case TELEM_LATENCY:
+            printf("latency  usage 0x%02x %s %u ms\n", (unsigned)r.b, r.arg ? "down" : "up", (unsigned)r.a);
+            break;
+        case TELEM_QUEUE:
+            printf("queue    %-5s %u / %u\n", queueNAME(r.arg), (unsigned)r.a, (unsigned)r.b);
+            break;
+        case TELEM_COUNTER:
+            printf("counter  %s %u (+%u)\n", counterNAME(r.arg), (unsigned)r.a, (unsigned)r.b);
+            break;
+        default:
+            printf("type %u arg %u a %u b %u\n", r.type, r.arg, (unsigned)r.a, (unsigned)r.b);
+            break;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const bool text = argc > 1 && strcmp(argv[1], "--text") == 0;
+    if (!text)
+    {
+        printf("time_ms,seq,type,arg,a,b\n");
+    }
+
+    uint8_t chunk[512];
+    size_t n = 0;
+    bool overflow = false;
+    unsigned long frames = 0, bad = 0;
+    int c;
+    while ((c = getchar()) != EOF)
+    {
+        if (c != 0)
+        {
+            if (n < sizeof(chunk)) chunk[n++] = (uint8_t)c;
+            else overflow = true;
+            continue;
+        }
+        uint8_t raw[TELEM_COBS_SIZE];
+        if (!overflow && n == TELEM_COBS_SIZE)
+        {
+            if (telemCOBS_DECODE(chunk, n, raw) == TELEM_RECORD_SIZE + 1 &&
+                telemCRC8(raw, TELEM_RECORD_SIZE) == raw[TELEM_RECORD_SIZE])
+            {
+                TELEM_RECORD r;
+                memcpy(&r, raw, TELEM_RECORD_SIZE);
+                frames++;
+                if (text) printTEXT(r);
+                else printf("%u,%u,%s,%u,%u,%u\n", (unsigned)r.time_ms, (unsigned)r.seq, typeNAME(r.type),
+                            (unsigned)r.arg, (unsigned)r.a, (unsigned)r.b);
+            }
+            else
+            {
+                bad++;
+            }
+        }
+        else if (n)
+        {
+            fwrite(chunk, 1, n, stderr);
+        }
+        n = 0;
+        overflow = false;
+    }
+    fprintf(stderr, "\n%lu frames, %lu corrupt\n", frames, bad);
+    return 0;
+}
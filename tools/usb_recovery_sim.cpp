@@ -0,0 +1,115 @@
+// usb_recovery_sim.cpp - transfer-error recovery schedule against scripted faults (host only)
+//
+//   g++ -std=gnu++11 -O2 -I../src usb_recovery_sim.cpp ../src/usb_recovery.cpp -o usb_recovery_sim
+//   ./usb_recovery_sim
+//
+// Drives UsbRecoveryClass the way the HID worker does: sleep until msUntilNEXT(), service(),
+// run the action, result(). Scenarios: one glitch, a burst of errors from one glitch, a cable
+// that needs a reopen, a device that never comes back, and a failing action. Prints when each
+// action runs; the first scenario is what a flaky cable now costs instead of a reboot.
+#include <stdio.h>
+#include <vector>
+#include "usb_recovery.h"
+
+static int errors = 0;
+
+static void expect(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        printf("FAIL: %s\n", what);
+        errors++;
+    }
+}
+
+typedef struct STEP {
+    uint32_t time_ms;
+    uint8_t  action;
+} STEP;
+
+// faults_after: how many actions still see a fault 1 ms after they ran (-1: forever)
+static std::vector<STEP> run(const char* name, int faults_after, bool actions_fail, uint32_t burst)
+{
+    UsbRecoveryClass rec;
+    std::vector<STEP> steps;
+    rec.attach(0);
+    uint32_t now = 1000;
+    for (uint32_t i = 0; i < burst; i++) rec.fault(0);
+    int left = faults_after;
+    uint32_t fault_at = 0;
+    for (uint32_t guard = 0; guard < 1000; guard++)
+    {
+        uint32_t next = rec.msUntilNEXT(now);
+        if (fault_at && (next == USB_REC_IDLE || fault_at <= now + next))
+        {
+            now = fault_at;
+            fault_at = 0;
+            rec.fault(0);
+            continue;
+        }
+        if (next == USB_REC_IDLE) break;
+        now += next;
+        uint8_t action = rec.service(0, now);
+        if (action == USB_REC_NONE) continue;
+        steps.push_back({now, action});
+        rec.result(0, !actions_fail, now);
+        if (left != 0)
+        {
+            if (left > 0) left--;
+            fault_at = now + 1;
+        }
+    }
+    USB_REC_STATS st;
+    rec.stats(0, &st);
+    printf("%-22s", name);
+    for (size_t i = 0; i < steps.size(); i++)
+    {
+        printf(" %s@%u", UsbRecoveryClass::levelNAME(steps[i].action), steps[i].time_ms - 1000);
+    }
+    printf(" -> %s, %u faults, %u recovered\n", UsbRecoveryClass::levelNAME(st.level), st.faults, st.recovered);
+    return steps;
+}
+
+int main()
+{
+    std::vector<STEP> s;
+
+    s = run("one glitch:", 0, false, 1);
+    expect(s.size() == 1 && s[0].action == USB_REC_RESTART && s[0].time_ms - 1000 == USB_REC_BASE_MS,
+           "one glitch costs one restart after the base backoff");
+
+    s = run("burst of 20 errors:", 0, false, 20);
+    expect(s.size() == 1, "a burst from one glitch is one episode");
+
+    s = run("needs a reopen:", USB_REC_TRIES, false, 1);
+    expect(s.size() == USB_REC_TRIES + 1u && s.back().action == USB_REC_REOPEN, "restarts escalate to a reopen");
+    for (size_t i = 1; i < s.size(); i++)
+    {
+        expect(s[i].time_ms > s[i - 1].time_ms, "actions in order");
+    }
+
+    s = run("never comes back:", -1, false, 1);
+    expect(s.size() == 2u * USB_REC_TRIES && s.back().action == USB_REC_REOPEN, "two levels, then give up");
+    expect(s.back().time_ms - 1000 < 10000, "gives up within seconds");
+
+    s = run("actions fail:", 0, true, 1);
+    expect(s.size() == 2u * USB_REC_TRIES, "a failing action escalates like a fault");
+
+    // a recovered device starts over at the base backoff
+    UsbRecoveryClass rec;
+    rec.attach(0);
+    rec.fault(0);
+    expect(rec.service(0, 0) == USB_REC_NONE && rec.service(0, USB_REC_BASE_MS) == USB_REC_RESTART, "first action");
+    rec.result(0, true, USB_REC_BASE_MS);
+    rec.service(0, USB_REC_BASE_MS + USB_REC_SETTLE_MS);
+    USB_REC_STATS st;
+    expect(rec.stats(0, &st) && st.level == USB_REC_NONE && st.recovered == 1, "recovered after the settle time");
+    rec.fault(0);
+    const uint32_t t = 5000;
+    expect(rec.service(0, t) == USB_REC_NONE && rec.service(0, t + USB_REC_BASE_MS) == USB_REC_RESTART, "backoff starts over");
+    rec.detach(0);
+    expect(!rec.stats(0, &st) && rec.msUntilNEXT(t) == USB_REC_IDLE, "detach");
+
+    printf("%d errors\n", errors);
+    return errors ? 1 : 0;
+}